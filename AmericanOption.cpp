@@ -0,0 +1,400 @@
+//  AmericanOption.cpp
+//  Class that represents finite-maturity American options, priced with
+//  the Barone-Adesi-Whaley or Bjerksund-Stensland 2002 approximation.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "AmericanOption.hpp"
+#include "EuropeanFormula.hpp"
+#include "Lattice.hpp"
+#include "NormalDistribution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    namespace American
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Approximations///////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Generalized Black-Scholes price of a European call or put
+        static double EuropeanPrice(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                    const double& S, const bool& call)
+        {
+            if (call)
+                return European::EuropeanFormula<1, CARRY_GENERAL>::Price(T, K, sig, r, b, S, HIGH_ACCURACY);
+            return European::EuropeanFormula<-1, CARRY_GENERAL>::Price(T, K, sig, r, b, S, HIGH_ACCURACY);
+        }
+        
+        // Barone-Adesi-Whaley terms: solve the critical price of a unit strike option by Newton's method
+        static AmericanTerms BaroneAdesiWhaleyBoundary(const double& T, const double& sig, const double& r, const double& b,
+                                                       const bool& call)
+        {
+            AmericanTerms terms;
+            double w = call? 1.0 : -1.0;
+            double v2 = sig * sig, sqrtT = sqrt(T), carry = exp((b - r) * T);
+            
+            // Exponents of the premium, for perpetual (m) and finite (k) maturities; k tends to 2 / (sig^2 T) as r goes to 0
+            double n = 2 * b / v2;
+            double m = 2 * r / v2;
+            double k = (r == 0)? 2 / (v2 * T) : 2 * r / (v2 * (1 - exp(-r * T)));
+            double qu = (-(n - 1) + w * sqrt((n - 1) * (n - 1) + 4 * m)) / 2;
+            double q = (-(n - 1) + w * sqrt((n - 1) * (n - 1) + 4 * k)) / 2;
+            
+            // Seed from the perpetual boundary
+            double su = 1 / (1 - 1 / qu);
+            double si = call? 1 + (su - 1) * (1 - exp(-(b * T + 2 * sig * sqrtT) / (su - 1)))
+                            : su + (1 - su) * exp((b * T - 2 * sig * sqrtT) / (1 - su));
+            
+            // Newton's method on w (S - 1) = V(S) + w (1 - e^((b-r)T) N(w d1)) S / q
+            for (int iteration = 0; iteration < 100; iteration++)
+            {
+                double d1 = (log(si) + (b + v2 / 2) * T) / (sig * sqrtT);
+                double nd1 = NormalCdf(w * d1, HIGH_ACCURACY);
+                double rhs = EuropeanPrice(T, 1, sig, r, b, si, call) + w * (1 - carry * nd1) * si / q;
+                if (std::fabs(w * (si - 1) - rhs) < 1e-12)
+                    break;
+                double slope = w * carry * nd1 * (1 - 1 / q) + w * (1 - w * carry * NormalPdf(d1, HIGH_ACCURACY) / (sig * sqrtT)) / q;
+                si = call? (1 + rhs - slope * si) / (1 - slope) : (1 - rhs + slope * si) / (1 + slope);
+            }
+            
+            double d1 = (log(si) + (b + v2 / 2) * T) / (sig * sqrtT);
+            terms.european = false;
+            terms.beta = q;
+            terms.trigger = si;
+            terms.alpha = w * (si / q) * (1 - carry * NormalCdf(w * d1, HIGH_ACCURACY));
+            return terms;
+        }
+        
+        // Barone-Adesi-Whaley price: European price plus the early exercise premium, or the exercise value past the boundary
+        static double BaroneAdesiWhaleyPrice(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                             const double& S, const bool& call, const AmericanTerms& terms)
+        {
+            double critical = K * terms.trigger;
+            if (call? S >= critical : S <= critical)
+                return call? S - K : K - S;
+            return EuropeanPrice(T, K, sig, r, b, S, call) + K * terms.alpha * pow(S / critical, terms.beta);
+        }
+        
+        // Bjerksund-Stensland terms of the call with the given r and b, for a unit strike
+        static AmericanTerms BjerksundStenslandBoundary(const double& T, const double& sig, const double& r, const double& b)
+        {
+            AmericanTerms terms;
+            terms.european = false;
+            terms.r = r;
+            terms.b = b;
+            double v2 = sig * sig;
+            
+            // The boundary is I1 until t1 and I2 from t1 to T
+            terms.t1 = 0.5 * (sqrt(5.0) - 1) * T;
+            terms.beta = (0.5 - b / v2) + sqrt((b / v2 - 0.5) * (b / v2 - 0.5) + 2 * r / v2);
+            double binf = terms.beta / (terms.beta - 1);
+            double b0 = std::max(1.0, r / (r - b));
+            double h1 = -(b * terms.t1 + 2 * sig * sqrt(terms.t1)) / ((binf - b0) * b0);
+            double h2 = -(b * T + 2 * sig * sqrt(T)) / ((binf - b0) * b0);
+            terms.i1 = b0 + (binf - b0) * (1 - exp(h1));
+            terms.trigger = b0 + (binf - b0) * (1 - exp(h2));
+            terms.alpha1 = (terms.i1 - 1) * pow(terms.i1, -terms.beta);
+            terms.alpha = (terms.trigger - 1) * pow(terms.trigger, -terms.beta);
+            return terms;
+        }
+        
+        // phi function of Bjerksund-Stensland
+        static double Phi(const double& S, const double& T, const double& gamma, const double& H, const double& I,
+                          const double& sig, const double& r, const double& b)
+        {
+            double v2 = sig * sig, vt = sig * sqrt(T);
+            double lambda = (-r + gamma * b + 0.5 * gamma * (gamma - 1) * v2) * T;
+            double d = -(log(S / H) + (b + (gamma - 0.5) * v2) * T) / vt;
+            double kappa = 2 * b / v2 + 2 * gamma - 1;
+            return exp(lambda) * pow(S, gamma) * (NormalCdf(d, HIGH_ACCURACY)
+                                                  - pow(I / S, kappa) * NormalCdf(d - 2 * log(I / S) / vt, HIGH_ACCURACY));
+        }
+        
+        // psi function of Bjerksund-Stensland 2002
+        static double Psi(const double& S, const double& T, const double& gamma, const double& H, const double& I2,
+                          const double& I1, const double& t1, const double& sig, const double& r, const double& b)
+        {
+            double v2 = sig * sig, drift = b + (gamma - 0.5) * v2;
+            double vt1 = sig * sqrt(t1), vt = sig * sqrt(T);
+            double e1 = (log(S / I1) + drift * t1) / vt1;
+            double e2 = (log(I2 * I2 / (S * I1)) + drift * t1) / vt1;
+            double e3 = (log(S / I1) - drift * t1) / vt1;
+            double e4 = (log(I2 * I2 / (S * I1)) - drift * t1) / vt1;
+            double f1 = (log(S / H) + drift * T) / vt;
+            double f2 = (log(I2 * I2 / (S * H)) + drift * T) / vt;
+            double f3 = (log(I1 * I1 / (S * H)) + drift * T) / vt;
+            double f4 = (log(S * I1 * I1 / (H * I2 * I2)) + drift * T) / vt;
+            double rho = sqrt(t1 / T);
+            double lambda = -r + gamma * b + 0.5 * gamma * (gamma - 1) * v2;
+            double kappa = 2 * b / v2 + 2 * gamma - 1;
+            return exp(lambda * T) * pow(S, gamma) * (BivariateNormalCdf(-e1, -f1, rho)
+                                                      - pow(I2 / S, kappa) * BivariateNormalCdf(-e2, -f2, rho)
+                                                      - pow(I1 / S, kappa) * BivariateNormalCdf(-e3, -f3, -rho)
+                                                      + pow(I1 / I2, kappa) * BivariateNormalCdf(-e4, -f4, -rho));
+        }
+        
+        // Bjerksund-Stensland 2002 price of a call with strike 1 on an asset at S
+        static double BjerksundStenslandCall(const double& T, const double& sig, const double& S, const AmericanTerms& terms)
+        {
+            const double &r = terms.r, &b = terms.b, &t1 = terms.t1, &beta = terms.beta;
+            const double &I1 = terms.i1, &I2 = terms.trigger, &alpha1 = terms.alpha1, &alpha2 = terms.alpha;
+            if (S >= I2)
+                return S - 1;
+            return alpha2 * pow(S, beta) - alpha2 * Phi(S, t1, beta, I2, I2, sig, r, b)
+                   + Phi(S, t1, 1, I2, I2, sig, r, b) - Phi(S, t1, 1, I1, I2, sig, r, b)
+                   - Phi(S, t1, 0, I2, I2, sig, r, b) + Phi(S, t1, 0, I1, I2, sig, r, b)
+                   + alpha1 * Phi(S, t1, beta, I1, I2, sig, r, b) - alpha1 * Psi(S, T, beta, I1, I2, I1, t1, sig, r, b)
+                   + Psi(S, T, 1, I1, I2, I1, t1, sig, r, b) - Psi(S, T, 1, 1, I2, I1, t1, sig, r, b)
+                   - Psi(S, T, 0, I1, I2, I1, t1, sig, r, b) + Psi(S, T, 0, 1, I2, I1, t1, sig, r, b);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Price Formula////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Terms of the approximation shared by the options with the same T, sig, r, b and type
+        AmericanTerms AmericanOption::Boundary(const double& T, const double& sig, const double& r, const double& b,
+                                               const bool& call, const AmericanMethod& method)
+        {
+            // A call on an asset whose carry is at least r, a put without interest, or an expiring option
+            // is never exercised early; without volatility there is no boundary to solve
+            if (T == 0 || sig == 0 || (call? b >= r : r <= 0))
+                return AmericanTerms();
+            
+            if (method == BARONE_ADESI_WHALEY)
+                return BaroneAdesiWhaleyBoundary(T, sig, r, b, call);
+            
+            // The put is the call with S and K swapped, priced at r - b and -b
+            if (call)
+                return BjerksundStenslandBoundary(T, sig, r, b);
+            return BjerksundStenslandBoundary(T, sig, r - b, -b);
+        }
+        
+        // Price of a call or put from the terms of its group
+        double AmericanOption::BoundaryPrice(const double& T, const double& K, const double& sig, const double& r,
+                                             const double& b, const double& S, const bool& call,
+                                             const AmericanMethod& method, const AmericanTerms& terms)
+        {
+            // Exercise value at expiry
+            if (T == 0)
+                return call? std::max(S - K, 0.0) : std::max(K - S, 0.0);
+            
+            // Without volatility the price is the best exercise value along the sure path of the underlying
+            if (sig == 0)
+                return Lattice::LatticeOption::DegeneratePrice(T, K, r, b, S, call, AMERICAN_EXERCISE);
+            if (terms.european)
+                return EuropeanPrice(T, K, sig, r, b, S, call);
+            
+            if (method == BARONE_ADESI_WHALEY)
+                return BaroneAdesiWhaleyPrice(T, K, sig, r, b, S, call, terms);
+            
+            // A call on a worthless asset is worthless, a put on it is exercised
+            if (S == 0)
+                return call? 0.0 : K;
+            
+            // Homogeneity: C(S, K) = K C(S / K, 1) and P(S, K) = C'(K, S) = S C'(K / S, 1)
+            if (call)
+                return K * BjerksundStenslandCall(T, sig, S / K, terms);
+            return S * BjerksundStenslandCall(T, sig, K / S, terms);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////Private Price Calculator/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the price for factors indexed by Factor
+        double AmericanOption::Calculate(const double (&f)[6]) const
+        {
+            bool call = (data.optType == 'C');
+            return BoundaryPrice(f[0], f[1], f[2], f[3], f[4], f[5], call, method,
+                                 Boundary(f[0], f[2], f[3], f[4], call, method));
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Constructors/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Default AmericanOption constructor
+        AmericanOption::AmericanOption(): Option(), method(BJERKSUND_STENSLAND) {}
+        
+        // Copy option
+        AmericanOption::AmericanOption(const AmericanOption& o2): Option(o2), method(o2.method) {}
+        
+        // Create an option of certain type
+        AmericanOption::AmericanOption(const char& optionType, const AmericanMethod& m): Option(optionType), method(m) {}
+        
+        // Create an option using given data
+        AmericanOption::AmericanOption(const struct OptionData& data, const AmericanMethod& m): Option(data), method(m) {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        AmericanOption::~AmericanOption() {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Operators/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Assignment operator
+        AmericanOption& AmericanOption::operator = (const AmericanOption& option2)
+        {
+            // Return original objects if addresses are the same
+            if (this == &option2) return *this;
+            
+            Option::operator = (option2);
+            method = option2.method;
+            return *this;
+        }
+        
+        // Get the information of the object using <<
+        std::ostream& operator << (std::ostream& os, const AmericanOption& op)
+        {
+            // Get the description from ToString() function
+            os << op.ToString();
+            return os;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the approximation used by the price getters
+        const AmericanMethod& AmericanOption::get_method() const
+        {
+            return method;
+        }
+        
+        // Set the approximation used by the price getters
+        void AmericanOption::set_method(const AmericanMethod& m)
+        {
+            method = m;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the price of the option
+        double AmericanOption::Price() const
+        {
+            double f[6];
+            FactorArray(f);
+            return Calculate(f);
+        }
+        
+        // Given a factor name and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double AmericanOption::Price(std::string factor, const double& value) const
+        {
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor name and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> AmericanOption::Price
+        (std::string factor, const double& start, const double& end, const double& step) const
+        {
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double AmericanOption::Price(const Factor& factor, const double& value) const
+        {
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
+            
+            // Check if the values of parameter are valid
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
+            
+            return Calculate(f);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> AmericanOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            // Create a vector that will store prices of different option parameters
+            std::vector<double> price_vec(SweepSize(start, end, step));
+            Price(factor, start, end, step, price_vec.data(), price_vec.size());
+            return price_vec;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void AmericanOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffer are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the input factor
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
+            bool call = (data.optType == 'C');
+            
+            // The boundary terms only depend on T, sig, r and b
+            bool fixed_boundary = (factor == Factor::K || factor == Factor::S);
+            AmericanTerms terms = Boundary(f[0], f[2], f[3], f[4], call, method);
+            
+            // Use to determine whether the varying parameter is increasing or decreasing
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            
+            // Loop over varying options
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                // Change the value corresponding to the input factor
+                x = i;
+                if (!fixed_boundary)
+                    terms = Boundary(f[0], f[2], f[3], f[4], call, method);
+                
+                // Get the price and put it in the buffer
+                price[row] = BoundaryPrice(f[0], f[1], f[2], f[3], f[4], f[5], call, method, terms);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        std::string AmericanOption::ToString() const
+        {
+            // Create a stringstream
+            std::stringstream str;
+            
+            // Put the content from Options to the stringstream
+            str << "American Option (" << MethodName(method) << ")\n" << Option::ToString();
+            return str.str();
+        }
+        
+        // Name of an approximation
+        std::string MethodName(const AmericanMethod& method)
+        {
+            return (method == BARONE_ADESI_WHALEY)? "Barone-Adesi-Whaley" : "Bjerksund-Stensland";
+        }
+    }
+}
@@ -0,0 +1,134 @@
+//  AmericanOption.hpp
+//  Class that represents finite-maturity American options, priced with
+//  analytic approximations: Barone-Adesi-Whaley (1987), whose critical
+//  price is found by Newton's method, or Bjerksund-Stensland (2002),
+//  which uses a two-step flat exercise boundary and needs no iteration.
+//  Both are homogeneous of degree one in S and K, so the boundary terms
+//  are computed for a unit strike and shared by every option with the
+//  same T, sig, r, b and type.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef AmericanOption_hpp
+#define AmericanOption_hpp
+
+#include "Options.hpp"
+
+namespace All_Options
+{
+    namespace American
+    {
+        // Analytic approximations of the American price
+        enum AmericanMethod { BARONE_ADESI_WHALEY = 0, BJERKSUND_STENSLAND = 1 };
+        
+        // Terms of an approximation that only depend on T, sig, r, b and the option type, for a unit strike
+        struct AmericanTerms
+        {
+            bool european = true;   // Early exercise is never optimal (calls with b >= r, puts with r <= 0, T = 0)
+            double beta = 0;        // Exponent of the early exercise premium (q2 or q1 for BAW, beta for BS)
+            double trigger = 0;     // Exercise boundary per unit strike (critical price for BAW, I2 for BS)
+            double alpha = 0;       // Coefficient of the premium (A2 or A1 for BAW, alpha2 for BS)
+            double t1 = 0;          // First step of the boundary of BS (the boundary is I1 until t1)
+            double i1 = 0;          // I1 per unit strike (BS)
+            double alpha1 = 0;      // alpha1 (BS)
+            double r = 0;           // r and b of the call priced by BS (r - b and -b for a put)
+            double b = 0;
+        };
+        
+        class AmericanOption: public Option
+        {
+        private:
+            
+            // Approximation used by the price getters
+            AmericanMethod method;
+            
+            ///////////////////////////////////Private Price Calculator////////////////////////////////////////
+            
+            // Calculate the price for factors indexed by Factor
+            double Calculate(const double (&f)[6]) const;
+        
+        public:
+            
+            ///////////////////////////////////////Price Formula////////////////////////////////////////////////
+            
+            // Terms of the approximation shared by the options with the same T, sig, r, b and type
+            // For BAW this is where the critical price is solved (Newton's method, relative tolerance 1e-12)
+            static AmericanTerms Boundary(const double& T, const double& sig, const double& r, const double& b,
+                                          const bool& call, const AmericanMethod& method);
+            
+            // Price of a call or put from the terms of its group
+            // With sig = 0 this is the best discounted exercise value over [0, T] (see LatticeOption::DegeneratePrice)
+            static double BoundaryPrice(const double& T, const double& K, const double& sig, const double& r,
+                                        const double& b, const double& S, const bool& call,
+                                        const AmericanMethod& method, const AmericanTerms& terms);
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Default AmericanOption constructor (Bjerksund-Stensland)
+            AmericanOption();
+            
+            // Copy Constructor
+            AmericanOption(const AmericanOption& option2);
+            
+            // Constructe an option of certain type
+            AmericanOption(const char& optionType, const AmericanMethod& method = BJERKSUND_STENSLAND);
+            
+            // Constructe an option using given data
+            AmericanOption(const struct OptionData& optionData, const AmericanMethod& method = BJERKSUND_STENSLAND);
+            
+            /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+            
+            virtual ~AmericanOption();
+            
+            //////////////////////////////////////////Operators/////////////////////////////////////////////////
+            
+            // Assignment operator
+            AmericanOption& operator = (const AmericanOption& option2);
+            
+            // Get the information of the object using <<
+            friend std::ostream& operator << (std::ostream& os, const AmericanOption& op);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the approximation used by the price getters
+            const AmericanMethod& get_method() const;
+            
+            // Set the approximation used by the price getters
+            void set_method(const AmericanMethod& method);
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Calculate the price of the option
+            virtual double Price() const;
+            
+            // Given a factor name and its value, calculate the price of the option
+            // The class variable is not changed to the given value.
+            virtual double Price(std::string factor, const double& value) const;
+            
+            // Given a factor name and start, end and step of the factor
+            // Calculte the price of the option for each variable change. Output a vector of prices
+            // The boundary terms are computed once unless the factor is T, sig, r or b
+            virtual std::vector<double> Price(std::string factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            virtual double Price(const Factor& factor, const double& value) const;
+            virtual std::vector<double> Price(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) prices to a caller buffer without allocating
+            // Throw InvalidSizeException if n is not the number of values
+            void Price(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* price, const std::size_t& n) const;
+            
+            ////////////////////////////////////////Description/////////////////////////////////////////////////
+            
+            virtual std::string ToString() const;
+        };
+        
+        // Name of an approximation
+        std::string MethodName(const AmericanMethod& method);
+    }
+}
+
+#endif
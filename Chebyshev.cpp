@@ -0,0 +1,297 @@
+//  Chebyshev.cpp
+//  Chebyshev proxy of the price of an option over a box of factors.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "Chebyshev.hpp"
+#include "RandomNumbers.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    namespace Chebyshev
+    {
+        static const double Pi = 3.14159265358979323846;
+        
+        // Value of a factor in an OptionData structure
+        static double& FactorReference(struct OptionData& data, const Factor& factor)
+        {
+            switch (factor)
+            {
+                case Factor::T:   return data.T;
+                case Factor::K:   return data.K;
+                case Factor::SIG: return data.sig;
+                case Factor::R:   return data.r;
+                case Factor::B:   return data.b;
+                default:          return data.S;
+            }
+        }
+        
+        // Chebyshev polynomials T_0(x) .. T_{n - 1}(x), by their recurrence
+        static void Polynomials(double* t, const std::size_t& n, const double& x)
+        {
+            t[0] = 1;
+            if (n > 1) t[1] = x;
+            for (std::size_t k = 2; k < n; k++)
+                t[k] = 2 * x * t[k - 1] - t[k - 2];
+        }
+        
+        // Restore the data of an option when leaving a scope, also by an exception
+        struct DataGuard
+        {
+            Option& option;
+            OptionData saved;
+            DataGuard(Option& o): option(o), saved(o.get_data()) {}
+            ~DataGuard() { option.set_data(saved); }
+        };
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        ChebyshevProxy::ChebyshevProxy(): data(), axes(), strides(), coefficients(), error(0) {}
+        
+        ChebyshevProxy::ChebyshevProxy(Option& option, const std::vector<ChebyshevAxis>& a)
+        : data(), axes(), strides(), coefficients(), error(0)
+        {
+            Build(option, a);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////////Building///////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price the option on the Chebyshev points of the box and compute the coefficients
+        void ChebyshevProxy::Build(Option& option, const std::vector<ChebyshevAxis>& a)
+        {
+            // Check the box
+            if (a.empty() || a.size() > 6)
+                throw InvalidValueException();
+            bool used[6] = {};
+            for (std::size_t i = 0; i < a.size(); i++)
+            {
+                int f = static_cast<int>(a[i].factor);
+                if (used[f] || a[i].nodes < 2 || !(a[i].low < a[i].high))
+                    throw InvalidValueException();
+                used[f] = true;
+            }
+            
+            // Offsets of the axes, the last one varying fastest
+            std::size_t dims = a.size(), total = 1;
+            std::vector<std::size_t> s(dims);
+            for (std::size_t i = dims; i-- > 0;)
+            {
+                s[i] = total;
+                total *= a[i].nodes;
+            }
+            
+            // Price the option on the points low + (high - low) (1 + cos(pi j / m)) / 2, j = 0 .. m
+            std::vector<double> values(total);
+            {
+                DataGuard guard(option);
+                OptionData node = guard.saved;
+                for (std::size_t k = 0; k < total; k++)
+                {
+                    for (std::size_t i = 0; i < dims; i++)
+                    {
+                        std::size_t j = (k / s[i]) % a[i].nodes, m = a[i].nodes - 1;
+                        double x = (j == 0)? 1.0 : (2 * j == m)? 0.0 : (j == m)? -1.0 : cos(Pi * j / m);
+                        FactorReference(node, a[i].factor) = 0.5 * (a[i].low + a[i].high) + 0.5 * (a[i].high - a[i].low) * x;
+                    }
+                    option.set_data(node);
+                    values[k] = option.Price();
+                }
+                data = guard.saved;
+            }
+            
+            // Discrete cosine transform of every line of every axis:
+            // c_k = 2 / m * sum'' f_j cos(pi j k / m), with the first and last terms halved (and c_0, c_m halved)
+            std::vector<double> line, table;
+            for (std::size_t i = 0; i < dims; i++)
+            {
+                std::size_t n = a[i].nodes, m = n - 1, stride = s[i];
+                line.resize(n);
+                table.resize(2 * m);
+                for (std::size_t j = 0; j < 2 * m; j++)
+                    table[j] = cos(Pi * j / m);
+                
+                for (std::size_t k = 0; k < total; k++)
+                {
+                    // Visit the first point of every line of the axis once
+                    if ((k / stride) % n != 0) continue;
+                    for (std::size_t q = 0; q < n; q++)
+                    {
+                        double sum = 0;
+                        for (std::size_t j = 0; j < n; j++)
+                        {
+                            double fj = values[k + j * stride];
+                            if (j == 0 || j == m) fj *= 0.5;
+                            sum += fj * table[(j * q) % (2 * m)];
+                        }
+                        line[q] = sum * 2.0 / m;
+                    }
+                    line[0] *= 0.5;
+                    line[m] *= 0.5;
+                    for (std::size_t q = 0; q < n; q++)
+                        values[k + q * stride] = line[q];
+                }
+            }
+            
+            // Error estimate from the two highest degrees of every axis
+            double tail = 0;
+            for (std::size_t k = 0; k < total; k++)
+                for (std::size_t i = 0; i < dims; i++)
+                    if ((k / s[i]) % a[i].nodes + 2 >= a[i].nodes)
+                    {
+                        tail += fabs(values[k]);
+                        break;
+                    }
+            
+            axes = a;
+            strides = s;
+            coefficients.swap(values);
+            error = tail;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////Getters///////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Data of the option the proxy was built from
+        const struct OptionData& ChebyshevProxy::get_data() const
+        {
+            return data;
+        }
+        
+        // Axes of the box
+        const std::vector<ChebyshevAxis>& ChebyshevProxy::get_axes() const
+        {
+            return axes;
+        }
+        
+        // Number of prices the proxy was built from
+        std::size_t ChebyshevProxy::Nodes() const
+        {
+            return coefficients.size();
+        }
+        
+        // Estimate of the largest error of the proxy in the box
+        double ChebyshevProxy::ErrorEstimate() const
+        {
+            return error;
+        }
+        
+        // Whether the proxy stands for an option with these data
+        bool ChebyshevProxy::Contains(const struct OptionData& d) const
+        {
+            if (axes.empty() || d.optType != data.optType)
+                return false;
+            
+            bool used[6] = {};
+            for (std::size_t i = 0; i < axes.size(); i++)
+            {
+                double x = FactorValue(d, axes[i].factor);
+                if (!(x >= axes[i].low && x <= axes[i].high))
+                    return false;
+                used[static_cast<int>(axes[i].factor)] = true;
+            }
+            for (int f = 0; f < 6; f++)
+                if (!used[f] && FactorValue(d, static_cast<Factor>(f)) != FactorValue(data, static_cast<Factor>(f)))
+                    return false;
+            return true;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price of an option inside the box
+        double ChebyshevProxy::Price(const struct OptionData& d) const
+        {
+            if (!Contains(d))
+                throw InvalidValueException();
+            
+            // Sum the first axis into a buffer of the thread, then every other axis of the buffer in place,
+            // first to last: each step adds slabs of contiguous values weighted by the polynomials of the
+            // axis, and it only writes below the slabs it reads
+            static thread_local std::vector<double> buffer, t;
+            std::size_t size = coefficients.size() / axes[0].nodes;
+            if (buffer.size() < size)
+                buffer.resize(size);
+            
+            double* sum = buffer.data();
+            for (std::size_t i = 0; i < axes.size(); i++)
+            {
+                const ChebyshevAxis& axis = axes[i];
+                std::size_t n = axis.nodes;
+                if (t.size() < n)
+                    t.resize(n);
+                Polynomials(t.data(), n, (2 * FactorValue(d, axis.factor) - axis.low - axis.high) / (axis.high - axis.low));
+                
+                const double* slab = (i == 0)? coefficients.data() : sum;
+                size = strides[i];
+                for (std::size_t j = 0; j < size; j++)
+                    sum[j] = t[0] * slab[j];
+                for (std::size_t q = 1; q < n; q++)
+                {
+                    const double* next = slab + q * size;
+                    double tq = t[q];
+                    for (std::size_t j = 0; j < size; j++)
+                        sum[j] += tq * next[j];
+                }
+            }
+            return buffer[0];
+        }
+        
+        // Largest difference between the proxy and the option on points of a Sobol sequence in the box
+        double ChebyshevProxy::Verify(Option& option, const std::size_t& points) const
+        {
+            if (axes.empty())
+                throw InvalidValueException();
+            
+            DataGuard guard(option);
+            MonteCarlo::SobolSequence sequence(axes.size());
+            sequence.Seek(1);
+            OptionData point = data;
+            double worst = 0;
+            for (std::size_t k = 0; k < points; k++)
+            {
+                const std::uint32_t* u = sequence.Next();
+                for (std::size_t i = 0; i < axes.size(); i++)
+                    FactorReference(point, axes[i].factor) = axes[i].low
+                        + (axes[i].high - axes[i].low) * MonteCarlo::SobolSequence::Uniform(u[i]);
+                option.set_data(point);
+                worst = std::max(worst, fabs(option.Price() - Price(point)));
+            }
+            return worst;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        std::string ChebyshevProxy::ToString() const
+        {
+            // Create a stringstream
+            std::stringstream str;
+            
+            str << "Chebyshev Proxy (" << Nodes() << " nodes, error estimate " << error << ")\n";
+            for (std::size_t i = 0; i < axes.size(); i++)
+                str << FactorName(axes[i].factor) << ": [" << axes[i].low << ", " << axes[i].high << "], "
+                    << axes[i].nodes << " points\n";
+            return str.str();
+        }
+        
+        // Get the information of the object using <<
+        std::ostream& operator << (std::ostream& os, const ChebyshevProxy& proxy)
+        {
+            // Get the description from ToString() function
+            os << proxy.ToString();
+            return os;
+        }
+    }
+}
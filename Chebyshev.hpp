@@ -0,0 +1,117 @@
+//  Chebyshev.hpp
+//  Chebyshev proxy of the price of any option over a box of factors
+//  (for example S x sig x T). The option is priced once on the tensor
+//  grid of Chebyshev points of the box; the values are turned into the
+//  coefficients of a tensor product of Chebyshev polynomials, which is
+//  summed one axis at a time over contiguous rows of coefficients, one
+//  multiply-add per coefficient. The coefficients of the highest degrees
+//  give an estimate of the interpolation error, and Verify() measures it
+//  against the option on points inside the box. The proxy only stands
+//  for the option inside its box and with the other factors unchanged:
+//  Contains() tells when the proxy has to be rebuilt.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef Chebyshev_hpp
+#define Chebyshev_hpp
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Options.hpp"
+
+namespace All_Options
+{
+    namespace Chebyshev
+    {
+        // Range [low, high] of a factor and number of Chebyshev points on it (polynomials of degree nodes - 1)
+        struct ChebyshevAxis
+        {
+            Factor factor = Factor::S;
+            double low = 0;
+            double high = 0;
+            std::size_t nodes = 12;
+            
+            ChebyshevAxis() {}
+            ChebyshevAxis(const Factor& f, const double& l, const double& h, const std::size_t& n = 12)
+            : factor(f), low(l), high(h), nodes(n) {}
+            ChebyshevAxis(const std::string& f, const double& l, const double& h, const std::size_t& n = 12)
+            : factor(ParseFactor(f)), low(l), high(h), nodes(n) {}
+        };
+        
+        class ChebyshevProxy
+        {
+        private:
+            
+            // Data of the option when the proxy was built, axes of the box and their offsets in the coefficients
+            OptionData data;
+            std::vector<ChebyshevAxis> axes;
+            std::vector<std::size_t> strides;
+            
+            // Coefficients of the tensor product, the last axis varying fastest
+            std::vector<double> coefficients;
+            
+            // Estimate of the interpolation error
+            double error;
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Empty proxy, which contains no option
+            ChebyshevProxy();
+            
+            // Proxy of an option over a box (see Build)
+            ChebyshevProxy(Option& option, const std::vector<ChebyshevAxis>& axes);
+            
+            /////////////////////////////////////////Building///////////////////////////////////////////////////
+            
+            // Price the option on the Chebyshev points of the box and compute the coefficients
+            // The option is priced through set_data, and its data are restored afterwards
+            // Throw InvalidValueException if there are no axes or more than 6, a factor appears twice, an axis has
+            // fewer than 2 points or low >= high; the option throws for values it rejects
+            void Build(Option& option, const std::vector<ChebyshevAxis>& axes);
+            
+            ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+            
+            // Data of the option the proxy was built from
+            const struct OptionData& get_data() const;
+            
+            // Axes of the box
+            const std::vector<ChebyshevAxis>& get_axes() const;
+            
+            // Number of prices the proxy was built from
+            std::size_t Nodes() const;
+            
+            // Estimate of the largest error of the proxy in the box: the sum of the magnitudes of the
+            // coefficients of the two highest degrees of every axis, which bounds the error when the
+            // coefficients decay geometrically, as they do for prices smooth in the box
+            double ErrorEstimate() const;
+            
+            // Whether the proxy stands for an option with these data: same type and factors outside the
+            // axes, factors of the axes inside the box
+            bool Contains(const struct OptionData& data) const;
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Price of an option inside the box
+            // Throw InvalidValueException if the proxy does not contain the option
+            double Price(const struct OptionData& data) const;
+            
+            // Largest difference between the proxy and the option on points of a Sobol sequence in the box
+            // (the data of the option are restored afterwards)
+            double Verify(Option& option, const std::size_t& points = 64) const;
+            
+            ////////////////////////////////////////Description/////////////////////////////////////////////////
+            
+            std::string ToString() const;
+            
+            // Get the information of the object using <<
+            friend std::ostream& operator << (std::ostream& os, const ChebyshevProxy& proxy);
+        };
+    }
+}
+
+#endif
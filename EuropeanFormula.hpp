@@ -0,0 +1,283 @@
+//  EuropeanFormula.hpp
+//  Black-Scholes formulas specialized at compile time on the option type
+//  (W = 1 for a call, -1 for a put) and on the carry regime of the
+//  underlying. The regime is picked once from r and b, so the formulas
+//  do not branch on the type and drop the terms the regime makes
+//  constant: exp((b - r) * T) is 1 for a stock (b = r) and exp(-r * T)
+//  for a futures (b = 0), and the (b - r) part of theta vanishes for a
+//  stock. Every specialization gives the same values as the general
+//  formula.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef EuropeanFormula_hpp
+#define EuropeanFormula_hpp
+
+#include <cmath>
+#include <cstddef>
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+
+namespace All_Options
+{
+    // Carry regimes of the underlying
+    // CARRY_STOCK: b = r (Black-Scholes), CARRY_FUTURES: b = 0 (Black-76),
+    // CARRY_MERTON: any other b (b = r - q for a dividend yield q),
+    // CARRY_GENERAL: b is only known at run time (batches mixing futures with other regimes)
+    enum CarryRegime { CARRY_GENERAL = 0, CARRY_STOCK = 1, CARRY_FUTURES = 2, CARRY_MERTON = 3 };
+
+    // Carry regime of one option
+    // b = r = 0 is a futures, whose rho only comes from the discounting of the premium
+    inline CarryRegime ClassifyCarry(const double& r, const double& b)
+    {
+        if (b == 0) return CARRY_FUTURES;
+        if (b == r) return CARRY_STOCK;
+        return CARRY_MERTON;
+    }
+
+    // Carry regime that fits options of both regimes
+    // Stock rows fit the Merton formulas, futures rows mixed with others need the general ones
+    inline CarryRegime CombineCarry(const CarryRegime& a, const CarryRegime& b)
+    {
+        if (a == b) return a;
+        return (a == CARRY_FUTURES || b == CARRY_FUTURES || a == CARRY_GENERAL || b == CARRY_GENERAL)? CARRY_GENERAL : CARRY_MERTON;
+    }
+    
+    // Carry regime shared by n options, looked at once for a whole batch
+    inline CarryRegime ClassifyCarry(const double* r, const double* b, const std::size_t& n)
+    {
+        if (n == 0) return CARRY_GENERAL;
+        CarryRegime carry = ClassifyCarry(r[0], b[0]);
+        for (std::size_t i = 1; i < n && carry != CARRY_GENERAL; i++)
+            carry = CombineCarry(carry, ClassifyCarry(r[i], b[i]));
+        return carry;
+    }
+
+    namespace European
+    {
+        // Terms of the formulas shared by calls and puts
+        struct EuropeanTerms
+        {
+            double sqrtT = 0;   // sqrt(T)
+            double tmp = 0;     // sig * sqrt(T)
+            double d1 = 0;
+            double d2 = 0;
+            double dfr = 0;     // exp(-r * T)
+            double dfb = 0;     // exp((b - r) * T)
+            double nd1 = 0;     // n(d1), when some output needs it
+        };
+        
+        // Formulas of a European option of type W (1 for a call, -1 for a put) in the carry regime C
+        template <int W, CarryRegime C>
+        struct EuropeanFormula
+        {
+            // exp((b - r) * T), the discounting of the underlying
+            static double CarryDiscount(const double& T, const double& r, const double& b)
+            {
+                if (C == CARRY_STOCK) return 1.0;
+                return exp((b - r) * T);
+            }
+
+            // Calculate Price
+            static double Price(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                const double& S, const NormalMode& mode)
+            {
+                double tmp = sig * sqrt(T);
+                double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
+                double d2 = d1 - tmp;
+                double dfr = exp(-r * T);
+                double dfb = (C == CARRY_FUTURES)? dfr : CarryDiscount(T, r, b);
+
+                if (W > 0)
+                    return (S * dfb * NormalCdf(d1, mode)) - (K * dfr * NormalCdf(d2, mode));
+                return (K * dfr * NormalCdf(-d2, mode)) - (S * dfb * NormalCdf(-d1, mode));
+            }
+
+            // Calculate Delta
+            static double Delta(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                const double& S, const NormalMode& mode)
+            {
+                double tmp = sig * sqrt(T);
+                double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
+
+                if (W > 0)
+                    return CarryDiscount(T, r, b) * NormalCdf(d1, mode);
+                return CarryDiscount(T, r, b) * (NormalCdf(d1, mode) - 1.0);
+            }
+
+            // Calculate Gamma (the same for calls and puts)
+            static double Gamma(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                const double& S, const NormalMode& mode)
+            {
+                double tmp = sig * sqrt(T);
+                double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
+
+                return (CarryDiscount(T, r, b) * NormalPdf(d1, mode))/S/tmp ;
+            }
+
+            // Terms shared by every output, except n(d1)
+            static EuropeanTerms Terms(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                       const double& S)
+            {
+                EuropeanTerms t;
+                t.sqrtT = sqrt(T);
+                t.tmp = sig * t.sqrtT;
+                t.d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ t.tmp;
+                t.d2 = t.d1 - t.tmp;
+                t.dfr = exp(-r * T);
+                t.dfb = (C == CARRY_FUTURES)? t.dfr : CarryDiscount(T, r, b);
+                return t;
+            }
+            
+            // Price and sensitivities selected by the mask from the terms, N(w * d1) and N(w * d2)
+            static OptionGreeks Outputs(const EuropeanTerms& t, const double& Nd1, const double& Nd2, const double& T,
+                                        const double& K, const double& sig, const double& r, const double& b,
+                                        const double& S, const unsigned& mask)
+            {
+                OptionGreeks greeks;
+                const double w = W;
+                double price = w * (S * t.dfb * Nd1 - K * t.dfr * Nd2);
+
+                if (mask & PRICE)
+                    greeks.price = price;
+                if (mask & DELTA)
+                    greeks.delta = w * t.dfb * Nd1;
+                if (mask & GAMMA)
+                    greeks.gamma = t.dfb * t.nd1 / S / t.tmp;
+                if (mask & VEGA)
+                    greeks.vega = S * t.dfb * t.nd1 * t.sqrtT;
+                if (mask & THETA)
+                {
+                    // The carry term is 0 for a stock
+                    greeks.theta = -S * t.dfb * t.nd1 * sig * 0.5 / t.sqrtT;
+                    if (C != CARRY_STOCK)
+                        greeks.theta -= w * (b - r) * S * t.dfb * Nd1;
+                    greeks.theta -= w * r * K * t.dfr * Nd2;
+                }
+                if (mask & RHO) // Futures options (b = 0) lose only the discounting of the premium
+                {
+                    if (C == CARRY_FUTURES || (C == CARRY_GENERAL && b == 0))
+                        greeks.rho = -T * price;
+                    else
+                        greeks.rho = w * T * K * t.dfr * Nd2;
+                }
+
+                return greeks;
+            }
+            
+            // Calculate the price and the sensitivities selected by the mask in one pass
+            static OptionGreeks Greeks(const double& T, const double& K, const double& sig, const double& r, const double& b,
+                                       const double& S, const unsigned& mask, const NormalMode& mode)
+            {
+                const double w = W;
+                EuropeanTerms t = Terms(T, K, sig, r, b, S);
+                
+                // Only evaluate the distribution terms some output needs
+                double Nd1 = 0, Nd2 = 0;
+                if (mask & (PRICE | DELTA | THETA | RHO))
+                    Nd1 = NormalCdf(w * t.d1, mode);
+                if (mask & (PRICE | THETA | RHO))
+                    Nd2 = NormalCdf(w * t.d2, mode);
+                if (mask & (GAMMA | VEGA | THETA))
+                    t.nd1 = NormalPdf(t.d1, mode);
+                
+                return Outputs(t, Nd1, Nd2, T, K, sig, r, b, S, mask);
+            }
+        };
+
+        // Call f.Run<W, C>() for the option type and the carry regime
+        // This is the only place the type and the regime are looked at; F declares its result_type
+        template <typename F>
+        typename F::result_type DispatchFormula(const bool& call, const CarryRegime& carry, const F& f)
+        {
+            if (call)
+            {
+                switch (carry)
+                {
+                    case CARRY_STOCK:   return f.template Run<1, CARRY_STOCK>();
+                    case CARRY_FUTURES: return f.template Run<1, CARRY_FUTURES>();
+                    case CARRY_MERTON:  return f.template Run<1, CARRY_MERTON>();
+                    default:            return f.template Run<1, CARRY_GENERAL>();
+                }
+            }
+            switch (carry)
+            {
+                case CARRY_STOCK:   return f.template Run<-1, CARRY_STOCK>();
+                case CARRY_FUTURES: return f.template Run<-1, CARRY_FUTURES>();
+                case CARRY_MERTON:  return f.template Run<-1, CARRY_MERTON>();
+                default:            return f.template Run<-1, CARRY_GENERAL>();
+            }
+        }
+
+        // Price, delta or gamma of one option for DispatchFormula
+        struct FormulaOutput
+        {
+            typedef double result_type;
+
+            const double* f;    // T, K, sig, r, b, S indexed by Factor
+            unsigned output;    // PRICE, DELTA or GAMMA
+            NormalMode mode;
+
+            FormulaOutput(const double* factors, const unsigned& out, const NormalMode& m): f(factors), output(out), mode(m) {}
+
+            template <int W, CarryRegime C>
+            double Run() const
+            {
+                if (output == DELTA)
+                    return EuropeanFormula<W, C>::Delta(f[0], f[1], f[2], f[3], f[4], f[5], mode);
+                if (output == GAMMA)
+                    return EuropeanFormula<W, C>::Gamma(f[0], f[1], f[2], f[3], f[4], f[5], mode);
+                return EuropeanFormula<W, C>::Price(f[0], f[1], f[2], f[3], f[4], f[5], mode);
+            }
+        };
+
+        // Price and sensitivities selected by a mask of one option for DispatchFormula
+        struct FormulaGreeks
+        {
+            typedef OptionGreeks result_type;
+
+            const double* f;    // T, K, sig, r, b, S indexed by Factor
+            unsigned mask;
+            NormalMode mode;
+
+            FormulaGreeks(const double* factors, const unsigned& m, const NormalMode& md): f(factors), mask(m), mode(md) {}
+
+            template <int W, CarryRegime C>
+            OptionGreeks Run() const
+            {
+                return EuropeanFormula<W, C>::Greeks(f[0], f[1], f[2], f[3], f[4], f[5], mask, mode);
+            }
+        };
+        
+        // Price and every sensitivity of one option for DispatchFormula, keeping the terms shared by calls and puts
+        // The terms and n(d1) are computed unless ready is set; N(w * d1) and N(w * d2) always are
+        struct FormulaCached
+        {
+            typedef OptionGreeks result_type;
+            
+            const double* f;        // T, K, sig, r, b, S indexed by Factor
+            EuropeanTerms* terms;
+            bool ready;
+            NormalMode mode;
+            
+            FormulaCached(const double* factors, EuropeanTerms* t, const bool& r, const NormalMode& m)
+            : f(factors), terms(t), ready(r), mode(m) {}
+            
+            template <int W, CarryRegime C>
+            OptionGreeks Run() const
+            {
+                if (!ready)
+                {
+                    *terms = EuropeanFormula<W, C>::Terms(f[0], f[1], f[2], f[3], f[4], f[5]);
+                    terms->nd1 = NormalPdf(terms->d1, mode);
+                }
+                double Nd1 = NormalCdf(W * terms->d1, mode), Nd2 = NormalCdf(W * terms->d2, mode);
+                return EuropeanFormula<W, C>::Outputs(*terms, Nd1, Nd2, f[0], f[1], f[2], f[3], f[4], f[5], ALL_GREEKS);
+            }
+        };
+    }
+}
+
+#endif
@@ -9,6 +9,8 @@
 //  Created by Yaojia Huang on 2018/10/31.
 
 #include "EuropeanOption.hpp"
+#include "EuropeanSweep.hpp"
+#include "EuropeanFormula.hpp"
 #include <cctype>
 #include <sstream>
 #include <iostream>
@@ -23,147 +25,82 @@ namespace All_Options
         ////////////////////////Private Price and Sensitivity Calculators///////////////////////////////////
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         
-        // Calculate Call Price
-        double EuropeanOption::CallPrice
-        (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S)
+        // Price, delta or gamma of the option with the factors T, K, sig, r, b, S in f
+        // The formula is specialized on the option type and on the carry regime of r and b
+        double EuropeanOption::Formula(const unsigned& output, const double (&f)[6]) const
         {
-            double tmp = sig * sqrt(T);
-            double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
-            double d2 = d1 - tmp;
-            boost::math::normal_distribution<> Normal;
-            
-            return (S * exp((b-r)*T) * cdf(Normal, d1)) - (K * exp(-r * T)* cdf(Normal, d2));
-        }
-        
-        // Calculate Put Price
-        double EuropeanOption::PutPrice
-        (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S)
-        {
-            double tmp = sig * sqrt(T);
-            double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
-            double d2 = d1 - tmp;
-            boost::math::normal_distribution<> Normal;
-            
-            return (K * exp(-r * T)* cdf(Normal, -d2)) - (S * exp((b-r)*T) * cdf(Normal, -d1));
-        }
-        
-        
-        // Calculate Call Delta
-        double EuropeanOption::CallDelta
-        (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S)
-        {
-            double tmp = sig * sqrt(T);
-            double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
-            boost::math::normal_distribution<> Normal;
-            
-            return exp((b-r)*T) * cdf(Normal, d1);
-        }
-        
-        // Calculate Put Delta
-        double EuropeanOption::PutDelta
-        (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S)
-        {
-            double tmp = sig * sqrt(T);
-            double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
-            boost::math::normal_distribution<> Normal;
-            
-            return exp((b-r)*T) * (cdf(Normal, d1) - 1.0);
-        }
-        
-        // Calculate Gamma
-        double EuropeanOption::Gamma
-        (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S)
-        {
-            double tmp = sig * sqrt(T);
-            double d1 = ( log(S/K) + (b+ (sig*sig)*0.5 ) * T )/ tmp;
-            boost::math::normal_distribution<> Normal;
-            
-            return (exp((b-r)*T) * pdf(Normal, d1))/S/tmp ;
+            return DispatchFormula(data.optType == 'C', ClassifyCarry(f[3], f[4]), FormulaOutput(f, output, mode));
         }
         
         
         // Serve for public Price(), Delta(), Gamma() function
-        // Return the call/put price, delta or gamma of the option depneding on the input function
-        double EuropeanOption::Calculate
-        (double (*func)(const double&, const double&, const double&, const double&, const double&, const double&),
-         std::string factor, const double& value) const
+        // Return the price, delta or gamma of the option with one factor changed to the given value
+        double EuropeanOption::Calculate(const unsigned& output, const Factor& factor, const double& value) const
         {
-            // Check if the input string matches any of the factors' name
-            CheckFactorName(factor);
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
             
-            // Get all factors in a map
-            std::map<std::string, double> mp = Factors();
-            
-            // Change the factor to upper case
-            boost::to_upper<std::string>(factor);
-            
-            // Change the value corresponding to the input factor name
-            mp[factor] = value;
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
             
             // Check if the values of parameter are valid
-            CheckFactorValue(mp["T"], mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]);
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
             
-            // Call the corresponding input functions depending on the option type
-            return func(mp["T"], mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]);
+            return Formula(output, f);
         }
         
         
-        // Serve for Price(), Delta(), Gamma() function that returns vectors
-        // Return the call/put price, delta or gamma vectors of the option depneding on the input function
-        std::vector<double> EuropeanOption::Mat
-        (double (*func)(const double&, const double&, const double&, const double&, const double&, const double&),
-         std::string factor, const double& start, const double& end, const double& step) const
+        // Price and every sensitivity at the current data, from the cache when caching is on
+        OptionGreeks EuropeanOption::Cached() const
         {
-            // Check if the input string matches any of the factors' name
-            CheckFactorName(factor);
-            // Check whether the step is valid
-            CheckStep(start, end, step);
-            
-            // Change the factor to upper case
-            boost::to_upper<std::string>(factor);
-            
-            // Check the value of the input factor
-            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == "K"))
-                throw InvalidValueException();
+            int state = cache_state.load(std::memory_order_acquire);
+            if (state == CACHE_FULL)
+                return cache_greeks;
             
-            // Get all factors in a map
-            std::map<std::string, double> mp = Factors();
+            double f[6];
+            FactorArray(f);
+            bool call = (data.optType != 'P');
+            CarryRegime carry = ClassifyCarry(data.r, data.b);
             
-            // Create a vector that will store data of different option parameters
-            std::vector<double> vec;
-            
-            // Used to determine whether the varying parameter is increasing or decreasing
-            int direction = (end > start)? 1:-1;
-            
-            // Loop over varying options
-            for (double i = start; (i - end) * direction <= 0; i += step)
+            // Fill the cache if no other reader is filling it, keeping the terms left by toggle()
+            if ((state == CACHE_EMPTY || state == CACHE_TERMS)
+                && cache_state.compare_exchange_strong(state, CACHE_BUSY, std::memory_order_acquire))
             {
-                // Change the value corresponding to the input factor name
-                mp[factor] = i;
-                // Call the corresponding input function and put the resultant data in the vector
-                vec.push_back(func(mp["T"], mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]));
+                OptionGreeks greeks = DispatchFormula(call, carry, FormulaCached(f, &cache_terms, state == CACHE_TERMS, mode));
+                cache_greeks = greeks;
+                cache_state.store(CACHE_FULL, std::memory_order_release);
+                return greeks;
             }
-          
-            return vec;
+            
+            // Another reader is filling the cache
+            EuropeanTerms terms;
+            return DispatchFormula(call, carry, FormulaCached(f, &terms, false, mode));
         }
+        
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////Constructors/////////////////////////////////////////////////
         ////////////////////////////////////////////////////////////////////////////////////////////////////
 
         // Default EuropeanOption Constructor
-        EuropeanOption::EuropeanOption(): Option() {}
+        EuropeanOption::EuropeanOption()
+        : Option(), mode(EXACT), caching(false), cache_state(CACHE_EMPTY), cache_terms(), cache_greeks() {}
         
         
         // Copy Constructor
-        EuropeanOption::EuropeanOption(const EuropeanOption& o2): Option(o2) {}
+        // The cache is not copied
+        EuropeanOption::EuropeanOption(const EuropeanOption& o2)
+        : Option(o2), mode(o2.mode), caching(o2.caching), cache_state(CACHE_EMPTY), cache_terms(), cache_greeks() {}
         
         
         // Constructe an option of certain type
-        EuropeanOption::EuropeanOption(const char& optionType): Option(optionType) {}
+        EuropeanOption::EuropeanOption(const char& optionType)
+        : Option(optionType), mode(EXACT), caching(false), cache_state(CACHE_EMPTY), cache_terms(), cache_greeks() {}
         
         
         // Constructe an option using given data
-        EuropeanOption::EuropeanOption(const struct OptionData& data): Option(data) {}
+        EuropeanOption::EuropeanOption(const struct OptionData& data)
+        : Option(data), mode(EXACT), caching(false), cache_state(CACHE_EMPTY), cache_terms(), cache_greeks() {}
         
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         /////////////////////////////////////////Destructor/////////////////////////////////////////////////
@@ -183,6 +120,9 @@ namespace All_Options
             
             // If addresses are not the same, assisgn.
             Option::operator = (option2);
+            mode = option2.mode;
+            caching = option2.caching;
+            cache_state.store(CACHE_EMPTY);
             return *this;
         }
         
@@ -202,10 +142,13 @@ namespace All_Options
         // Calculate the price of the option
         double EuropeanOption::Price() const
         {
-            // Call the corresponding price calculator depending on the option type
-            if (data.optType == 'C')
-                return CallPrice(data.T, data.K, data.sig, data.r, data.b, data.S);
-            return PutPrice(data.T, data.K, data.sig, data.r, data.b, data.S);
+            if (caching)
+                return Cached().price;
+            
+            // Call the price formula of the option type and carry regime
+            double f[6];
+            FactorArray(f);
+            return Formula(PRICE, f);
         }
         
         
@@ -213,9 +156,15 @@ namespace All_Options
         // The class variable is not changed to the given value.
         double EuropeanOption::Price(std::string factor, const double& value) const
         {
-            if (data.optType == 'C')
-                return Calculate(CallPrice, factor, value);
-            return Calculate(PutPrice, factor, value);
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double EuropeanOption::Price(const Factor& factor, const double& value) const
+        {
+            return Calculate(PRICE, factor, value);
         }
         
         
@@ -224,9 +173,28 @@ namespace All_Options
         std::vector<double> EuropeanOption::Price
         (std::string factor, const double& start, const double& end, const double& step) const
         {
-            if (data.optType == 'C')
-                return Mat(CallPrice, factor, start, end, step);
-            return Mat(PutPrice, factor, start, end, step);
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> EuropeanOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            // Terms that do not depend on the factor are computed once for the whole sweep
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, PRICE);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void EuropeanOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, PRICE, price, n);
         }
         
         ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -236,10 +204,13 @@ namespace All_Options
         // Calculate the delta of the option
         double EuropeanOption::Delta() const
         {
-            // Call the corresponding delta calculator depending on the option type
-            if (data.optType == 'C')
-                return CallDelta(data.T, data.K, data.sig, data.r, data.b, data.S);
-            return PutDelta(data.T, data.K, data.sig, data.r, data.b, data.S);
+            if (caching)
+                return Cached().delta;
+            
+            // Call the delta formula of the option type and carry regime
+            double f[6];
+            FactorArray(f);
+            return Formula(DELTA, f);
         }
         
         
@@ -247,9 +218,15 @@ namespace All_Options
         // The class variable is not changed to the given value.
         double EuropeanOption::Delta(std::string factor, const double& value) const
         {
-            if (data.optType == 'C')
-                return Calculate(CallDelta, factor, value);
-            return Calculate(PutDelta, factor, value);
+            return Delta(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor and its value, calculate the delta of the option
+        // The class variable is not changed to the given value.
+        double EuropeanOption::Delta(const Factor& factor, const double& value) const
+        {
+            return Calculate(DELTA, factor, value);
         }
         
         
@@ -257,9 +234,26 @@ namespace All_Options
         // Calculte the delta of the option for each variable change. Output a vector of deltas
         std::vector<double> EuropeanOption::Delta(std::string factor, const double& start, const double& end, const double& step) const
         {
-            if (data.optType == 'C')
-                return Mat(CallDelta, factor, start, end, step);
-            return Mat(PutDelta, factor, start, end, step);
+            return Delta(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the delta of the option for each variable change. Output a vector of deltas
+        std::vector<double> EuropeanOption::Delta(const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, DELTA);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the delta of the option for each variable change to a buffer of n values
+        void EuropeanOption::Delta
+        (const Factor& factor, const double& start, const double& end, const double& step, double* delta, const std::size_t& n) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, DELTA, delta, n);
         }
         
         
@@ -274,7 +268,7 @@ namespace All_Options
         // Approximate delta by finding the slope between s-h and s+h, where s is given by the user
         double EuropeanOption::Approx_Delta(const double& s, const double& h) const
         {
-            return (Price("S", s+h) - Price("S", s-h))/2/h;
+            return (Price(Factor::S, s+h) - Price(Factor::S, s-h))/2/h;
         }
         
         ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -284,8 +278,13 @@ namespace All_Options
         // Calculate the gamma of the option
         double EuropeanOption::Gamma() const
         {
-            // Call the gamma calculator
-            return Gamma(data.T, data.K, data.sig, data.r, data.b, data.S);
+            if (caching)
+                return Cached().gamma;
+            
+            // Call the gamma formula of the carry regime
+            double f[6];
+            FactorArray(f);
+            return Formula(GAMMA, f);
         }
         
         
@@ -293,7 +292,15 @@ namespace All_Options
         // The class variable is not changed to the given value.
         double EuropeanOption::Gamma(std::string factor, const double& value) const
         {
-            return Calculate(Gamma, factor, value);
+            return Gamma(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor and its value, calculate the gamma of the option
+        // The class variable is not changed to the given value.
+        double EuropeanOption::Gamma(const Factor& factor, const double& value) const
+        {
+            return Calculate(GAMMA, factor, value);
         }
         
         
@@ -301,7 +308,26 @@ namespace All_Options
         // Calculte the gamma of the option for each variable change. Output a vector of gammas
         std::vector<double> EuropeanOption::Gamma(std::string factor, const double& start, const double& end, const double& step) const
         {
-            return Mat(Gamma, factor, start, end, step);
+            return Gamma(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the gamma of the option for each variable change. Output a vector of gammas
+        std::vector<double> EuropeanOption::Gamma(const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, GAMMA);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the gamma of the option for each variable change to a buffer of n values
+        void EuropeanOption::Gamma
+        (const Factor& factor, const double& start, const double& end, const double& step, double* gamma, const std::size_t& n) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, GAMMA, gamma, n);
         }
         
         
@@ -315,7 +341,155 @@ namespace All_Options
         // Approximate gamma by finding the slope between s-h and s+h, where s is given by the user
         double EuropeanOption::Approx_Gamma(const double& s, const double& h) const
         {
-            return (Price("S", s+h) + Price("S", s-h) - 2 * Price("S", s))/h/h;
+            return (Price(Factor::S, s+h) + Price(Factor::S, s-h) - 2 * Price(Factor::S, s))/h/h;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Greeks Getter/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the price, delta, gamma, vega, theta and rho selected by the mask in one pass
+        OptionGreeks EuropeanOption::Greeks(const unsigned& mask) const
+        {
+            if (caching)
+            {
+                // Only the outputs in the mask are returned
+                OptionGreeks all = Cached(), greeks;
+                if (mask & PRICE) greeks.price = all.price;
+                if (mask & DELTA) greeks.delta = all.delta;
+                if (mask & GAMMA) greeks.gamma = all.gamma;
+                if (mask & VEGA)  greeks.vega = all.vega;
+                if (mask & THETA) greeks.theta = all.theta;
+                if (mask & RHO)   greeks.rho = all.rho;
+                return greeks;
+            }
+            
+            double f[6];
+            FactorArray(f);
+            return DispatchFormula(data.optType != 'P', ClassifyCarry(data.r, data.b), FormulaGreeks(f, mask, mode));
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculate the outputs selected by the mask for each variable change
+        BatchGreeks EuropeanOption::Greeks
+        (const Factor& factor, const double& start, const double& end, const double& step, const unsigned& mask) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.RunGreeks(start, end, step, mask);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the outputs with a non-null pointer for each variable change to buffers of n values
+        void EuropeanOption::Greeks
+        (const Factor& factor, const double& start, const double& end, const double& step,
+         const Simd::KernelOutput& out, const std::size_t& n) const
+        {
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.RunGreeks(start, end, step, out, n);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Surfaces//////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Serve for Surface() and ParallelSurface(), run on the pool if one is given
+        OptionSurface EuropeanOption::BuildSurface
+        (const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output, ThreadPool* pool, const ParallelConfig& config) const
+        {
+            OptionSurface surface;
+            PrepareSurface(surface, rows, cols);
+            std::size_t width = surface.col_values.size();
+            
+            // Each tile sweeps the column factor along its rows; the terms that do not depend on it
+            // are computed once per row
+            auto tile = [&](std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end)
+            {
+                EuropeanSweep sweep(data, cols.factor, mode);
+                for (std::size_t i = row_begin; i < row_end; i++)
+                {
+                    sweep.Set(rows.factor, surface.row_values[i]);
+                    double* out = surface.values.data() + i * width;
+                    for (std::size_t j = col_begin; j < col_end; j++)
+                        out[j] = sweep.Output(surface.col_values[j], output);
+                }
+            };
+            ForEachTile(surface, tile, pool, config);
+            
+            return surface;
+        }
+        
+        
+        // Calculate one output over a grid of two factors
+        OptionSurface EuropeanOption::Surface(const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output) const
+        {
+            return BuildSurface(rows, cols, output, 0, ParallelConfig());
+        }
+        
+        
+        // Same as Surface, with the tiles of the grid split over a pool of threads
+        OptionSurface EuropeanOption::ParallelSurface
+        (const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output, const ParallelConfig& config) const
+        {
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            return BuildSurface(rows, cols, output, &pool, config);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////Normal Distribution/////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the accuracy mode of the normal distribution
+        NormalMode EuropeanOption::get_normal_mode() const
+        {
+            return mode;
+        }
+        
+        
+        // Set the accuracy mode of the normal distribution used by every price and sensitivity
+        void EuropeanOption::set_normal_mode(const NormalMode& normal_mode)
+        {
+            mode = normal_mode;
+            cache_state.store(CACHE_EMPTY);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Modifiers/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Set the data of the object, which empties the cache
+        void EuropeanOption::set_data(const struct OptionData& source)
+        {
+            // Empty the cache first, as the data may be partly assigned when the type is rejected
+            cache_state.store(CACHE_EMPTY);
+            Option::set_data(source);
+        }
+        
+        
+        // Change option type (C/P, P/C); the cache keeps the terms shared by calls and puts
+        void EuropeanOption::toggle()
+        {
+            Option::toggle();
+            if (cache_state.load() == CACHE_FULL)
+                cache_state.store(CACHE_TERMS);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////Cache///////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Whether Price(), Delta(), Gamma() and Greeks(mask) are served from the cache
+        bool EuropeanOption::get_caching() const
+        {
+            return caching;
+        }
+        
+        
+        // Turn the cache on or off
+        void EuropeanOption::set_caching(const bool& on)
+        {
+            caching = on;
         }
         
         ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -12,6 +12,12 @@
 #define EuropeanOption_hpp
 
 #include "Options.hpp"
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+#include "Surface.hpp"
+#include "SimdKernel.hpp"
+#include "EuropeanFormula.hpp"
+#include <atomic>
 
 namespace All_Options
 {
@@ -21,41 +27,37 @@ namespace All_Options
         {
         private:
             
-            ////////////////////////Private Price and Sensitivity Calculators///////////////////////////////////
-            
-            // Calculate Call Price
-            static double CallPrice
-            (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S);
+            NormalMode mode;    // Accuracy of the normal distribution, EXACT by default
             
-            // Calculate Put Price
-            static double PutPrice
-            (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S);
+            ////////////////////////////////////////////Cache/////////////////////////////////////////////////////
             
-            // Calculate Call Delta
-            static double CallDelta
-            (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S);
+            // Opt-in cache of the terms and outputs at the current data (see set_caching)
+            // The state is EMPTY, TERMS (d1, d2, n(d1) and the discount factors, kept by toggle()) or FULL (also the
+            // outputs of the type); a reader fills it after taking it from EMPTY or TERMS to BUSY, and the readers
+            // that find it BUSY compute their outputs without it
+            enum CacheState { CACHE_EMPTY = 0, CACHE_TERMS = 1, CACHE_BUSY = 2, CACHE_FULL = 3 };
+            bool caching;
+            mutable std::atomic<int> cache_state;
+            mutable EuropeanTerms cache_terms;
+            mutable OptionGreeks cache_greeks;
             
-            // Calculate Put Delta
-            static double PutDelta
-            (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S);
+            // Price and every sensitivity at the current data, from the cache when caching is on
+            OptionGreeks Cached() const;
             
-            // Calculate Gamma
-            static double Gamma
-            (const double& T, const double& K, const double& sig, const double& r, const double& b, const double& S);
+            ////////////////////////Private Price and Sensitivity Calculators///////////////////////////////////
             
+            // Price, delta or gamma of the option with the factors T, K, sig, r, b, S in f
+            // The formula is specialized on the option type and on the carry regime of r and b
+            double Formula(const unsigned& output, const double (&f)[6]) const;
             
             // Serve for public Price(), Delta(), Gamma() function
-            // Return the call/put price, delta or gamma of the option depneding on the input function
-            double Calculate
-            (double (*func)(const double&, const double&, const double&, const double&, const double&, const double&),
-             std::string factor, const double& value) const;
+            // Return the price, delta or gamma of the option with one factor changed to the given value
+            double Calculate(const unsigned& output, const Factor& factor, const double& value) const;
             
             
-            // Serve for Price(), Delta(), Gamma() functions that return vectors of price/delta/gamma
-            // Return the call/put price, delta or gamma vectors of the option depneding on the input function
-            std::vector<double> Mat
-            (double (*func)(const double&, const double&, const double&, const double&, const double&, const double&),
-             std::string factor, const double& start, const double& end, const double& step) const;
+            // Serve for Surface() and ParallelSurface(), run on the pool if one is given
+            OptionSurface BuildSurface(const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output,
+                                       ThreadPool* pool, const ParallelConfig& config) const;
             
         public:
             
@@ -91,6 +93,15 @@ namespace All_Options
             // Calculte the price of the option for each variable change. Output a vector of prices
             virtual std::vector<double> Price(std::string factor, const double& start, const double& end, const double& step) const;
             
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            virtual double Price(const Factor& factor, const double& value) const;
+            virtual std::vector<double> Price(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) prices to a caller buffer without allocating
+            // Throw InvalidSizeException if n is not the number of values
+            void Price(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* price, const std::size_t& n) const;
+            
             //////////////////////////////////////Delta Getters/////////////////////////////////////////////////
             
             // Calculate the delta of the option
@@ -104,6 +115,14 @@ namespace All_Options
             // Calculte the delta of the option for each variable change. Output a vector of deltas
             std::vector<double> Delta(std::string factor, const double& start, const double& end, const double& step) const;
             
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            double Delta(const Factor& factor, const double& value) const;
+            std::vector<double> Delta(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) deltas to a caller buffer without allocating
+            void Delta(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* delta, const std::size_t& n) const;
+            
             // Approximate delta by finding the slope between S-h and S+h
             double Approx_Delta(const double& h) const;
             
@@ -123,12 +142,75 @@ namespace All_Options
             // Calculte the gamma of the option for each variable change. Output a vector of gammas
             std::vector<double> Gamma(std::string factor, const double& start, const double& end, const double& step) const;
             
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            double Gamma(const Factor& factor, const double& value) const;
+            std::vector<double> Gamma(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) gammas to a caller buffer without allocating
+            void Gamma(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* gamma, const std::size_t& n) const;
+            
             // Approximate gamma by finding the slope between S-h and S+h
             double Approx_Gamma(const double& h) const;
             
             // Approximate gamma by finding the slope between s-h and s+h, where s is given by the user
             double Approx_Gamma(const double& s, const double& h) const;
             
+            //////////////////////////////////////Greeks Getter/////////////////////////////////////////////////
+            
+            // Calculate the price, delta, gamma, vega, theta and rho selected by the mask in one pass
+            // d1, d2, the normal CDFs and the discount factors are computed only once
+            struct OptionGreeks Greeks(const unsigned& mask = ALL_GREEKS) const;
+            
+            // Given a factor and start, end and step of the factor
+            // Calculate the outputs selected by the mask for each variable change (see EuropeanSweep.hpp)
+            BatchGreeks Greeks(const Factor& factor, const double& start, const double& end, const double& step,
+                               const unsigned& mask = ALL_GREEKS) const;
+            
+            // Same as above, writing to caller buffers of n = SweepSize(start, end, step) values without allocating
+            // The outputs whose pointer is not null are computed
+            void Greeks(const Factor& factor, const double& start, const double& end, const double& step,
+                        const Simd::KernelOutput& out, const std::size_t& n) const;
+            
+            /////////////////////////////////////////Surfaces///////////////////////////////////////////////////
+            
+            // Calculate one output (PRICE, DELTA, GAMMA, VEGA, THETA or RHO) over a grid of two factors
+            // Row i of the grid uses the i-th value of the rows axis, column j the j-th value of the cols axis
+            OptionSurface Surface(const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output = PRICE) const;
+            
+            // Same as Surface, with the tiles of the grid split over a pool of threads
+            // The result is identical to Surface whatever the thread count
+            OptionSurface ParallelSurface(const SurfaceAxis& rows, const SurfaceAxis& cols, const unsigned& output = PRICE,
+                                          const ParallelConfig& config = ParallelConfig()) const;
+            
+            ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
+            
+            // Set the data of the object, which empties the cache
+            virtual void set_data(const struct OptionData& data);
+            
+            // Change option type (C/P, P/C); the cache keeps the terms shared by calls and puts
+            virtual void toggle();
+            
+            ////////////////////////////////////////////Cache/////////////////////////////////////////////////////
+            
+            // Whether Price(), Delta(), Gamma() and Greeks(mask) are served from the cache
+            bool get_caching() const;
+            
+            // Turn the cache on or off (off by default). With the cache on, the first of these calls computes d1, d2,
+            // N(d1), N(d2), n(d1) and every output once, with the values of Greeks(), and the next calls return them
+            // until set_data(), toggle() or set_normal_mode(). Concurrent const calls are safe; the modifiers must not
+            // run concurrently with them
+            void set_caching(const bool& on);
+            
+            ////////////////////////////////////Normal Distribution/////////////////////////////////////////////
+            
+            // Get the accuracy mode of the normal distribution
+            NormalMode get_normal_mode() const;
+            
+            // Set the accuracy mode of the normal distribution used by every price and sensitivity
+            // EXACT (boost, default), HIGH_ACCURACY (Hart) or FAST (about 1e-7), see NormalDistribution.hpp
+            void set_normal_mode(const NormalMode& normal_mode);
+            
             //////////////////////////////////////Put-Call Parity///////////////////////////////////////////////
             
             // Given a option type and a price, calculate the parity price
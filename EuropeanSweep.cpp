@@ -0,0 +1,263 @@
+//  EuropeanSweep.cpp
+//  Sweep engine for European options with one varying factor.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "EuropeanSweep.hpp"
+#include "Exception.hpp"
+#include <cmath>
+
+namespace All_Options
+{
+    namespace European
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Constructors////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Prepare a sweep of the given factor of an option
+        EuropeanSweep::EuropeanSweep(const struct OptionData& data, const Factor& varying, const NormalMode& normal_mode):
+        T(data.T), K(data.K), sig(data.sig), r(data.r), b(data.b), S(data.S),
+        w((data.optType == 'P' || data.optType == 'p')? -1.0 : 1.0), factor(varying), mode(normal_mode)
+        {
+            Init();
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Private Functions///////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Compute every term from the factors
+        // Update() then only refreshes the ones the varying factor changes
+        void EuropeanSweep::Init()
+        {
+            sqrtT = sqrt(T);
+            tmp = sig * sqrtT;
+            logS = log(S);
+            logK = log(K);
+            drift = (b + sig * sig * 0.5) * T;
+            dfb = exp((b - r) * T);
+            dfr = exp(-r * T);
+            d1 = (logS - logK + drift) / tmp;
+            d2 = d1 - tmp;
+            Nd1 = Nd2 = nd1 = 0;
+            cached = 0;
+        }
+        
+        // Recompute the terms that depend on the varying factor
+        void EuropeanSweep::Update()
+        {
+            switch (factor)
+            {
+                case Factor::T:
+                    sqrtT = sqrt(T);
+                    tmp = sig * sqrtT;
+                    drift = (b + sig * sig * 0.5) * T;
+                    dfb = exp((b - r) * T);
+                    dfr = exp(-r * T);
+                    break;
+                case Factor::K:
+                    logK = log(K);
+                    break;
+                case Factor::SIG:
+                    tmp = sig * sqrtT;
+                    drift = (b + sig * sig * 0.5) * T;
+                    break;
+                case Factor::R:
+                    // d1 and d2 do not depend on r, so the normal CDFs stay valid
+                    dfr = exp(-r * T);
+                    dfb = exp(b * T) * dfr;
+                    return;
+                case Factor::B:
+                    drift = (b + sig * sig * 0.5) * T;
+                    dfb = exp((b - r) * T);
+                    break;
+                case Factor::S:
+                    logS = log(S);
+                    break;
+            }
+            d1 = (logS - logK + drift) / tmp;
+            d2 = d1 - tmp;
+            cached = 0;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////Evaluation/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Change a factor that does not vary in the sweep
+        void EuropeanSweep::Set(const Factor& fixed, const double& value)
+        {
+            switch (fixed)
+            {
+                case Factor::T:   T = value; break;
+                case Factor::K:   K = value; break;
+                case Factor::SIG: sig = value; break;
+                case Factor::R:   r = value; break;
+                case Factor::B:   b = value; break;
+                case Factor::S:   S = value; break;
+            }
+            Init();
+        }
+        
+        
+        // Price and sensitivities selected by the mask with the varying factor set to value
+        OptionGreeks EuropeanSweep::Evaluate(const double& value, const unsigned& mask)
+        {
+            switch (factor)
+            {
+                case Factor::T:   T = value; break;
+                case Factor::K:   K = value; break;
+                case Factor::SIG: sig = value; break;
+                case Factor::R:   r = value; break;
+                case Factor::B:   b = value; break;
+                case Factor::S:   S = value; break;
+            }
+            Update();
+            
+            // Only evaluate the distribution terms some output needs and that are not cached
+            if ((mask & (PRICE | DELTA | THETA | RHO)) && !(cached & 1))
+            {
+                Nd1 = NormalCdf(w * d1, mode);
+                cached |= 1;
+            }
+            if ((mask & (PRICE | THETA | RHO)) && !(cached & 2))
+            {
+                Nd2 = NormalCdf(w * d2, mode);
+                cached |= 2;
+            }
+            if ((mask & (GAMMA | VEGA | THETA)) && !(cached & 4))
+            {
+                nd1 = NormalPdf(d1, mode);
+                cached |= 4;
+            }
+            
+            // Same formulas as EuropeanOption::Greeks()
+            OptionGreeks greeks;
+            double price = w * (S * dfb * Nd1 - K * dfr * Nd2);
+            
+            if (mask & PRICE)
+                greeks.price = price;
+            if (mask & DELTA)
+                greeks.delta = w * dfb * Nd1;
+            if (mask & GAMMA)
+                greeks.gamma = dfb * nd1 / S / tmp;
+            if (mask & VEGA)
+                greeks.vega = S * dfb * nd1 * sqrtT;
+            if (mask & THETA)
+                greeks.theta = -S * dfb * nd1 * sig * 0.5 / sqrtT - w * (b - r) * S * dfb * Nd1 - w * r * K * dfr * Nd2;
+            if (mask & RHO) // Futures options (b = 0) lose only the discounting of the premium
+                greeks.rho = (b == 0)? -T * price : w * T * K * dfr * Nd2;
+            
+            return greeks;
+        }
+        
+        
+        // One output with the varying factor set to value
+        double EuropeanSweep::Output(const double& value, const unsigned& output)
+        {
+            OptionGreeks greeks = Evaluate(value, output);
+            switch (output)
+            {
+                case DELTA: return greeks.delta;
+                case GAMMA: return greeks.gamma;
+                case VEGA:  return greeks.vega;
+                case THETA: return greeks.theta;
+                case RHO:   return greeks.rho;
+                default:    return greeks.price;
+            }
+        }
+        
+        
+        // Number of points from start to end with the given step
+        std::size_t EuropeanSweep::Points(const double& start, const double& end, const double& step)
+        {
+            return SweepSize(start, end, step);
+        }
+        
+        
+        // Output for every point from start to end
+        std::vector<double> EuropeanSweep::Run(const double& start, const double& end, const double& step, const unsigned& output)
+        {
+            std::vector<double> vec(Points(start, end, step));
+            Run(start, end, step, output, vec.data(), vec.size());
+            return vec;
+        }
+        
+        
+        // Outputs selected by the mask for every point from start to end
+        BatchGreeks EuropeanSweep::RunGreeks(const double& start, const double& end, const double& step, const unsigned& mask)
+        {
+            std::size_t n = Points(start, end, step);
+            
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            Simd::KernelOutput out;
+            if (mask & PRICE) { greeks.price.resize(n); out.price = greeks.price.data(); }
+            if (mask & DELTA) { greeks.delta.resize(n); out.delta = greeks.delta.data(); }
+            if (mask & GAMMA) { greeks.gamma.resize(n); out.gamma = greeks.gamma.data(); }
+            if (mask & VEGA)  { greeks.vega.resize(n);  out.vega = greeks.vega.data(); }
+            if (mask & THETA) { greeks.theta.resize(n); out.theta = greeks.theta.data(); }
+            if (mask & RHO)   { greeks.rho.resize(n);   out.rho = greeks.rho.data(); }
+            
+            RunGreeks(start, end, step, out, n);
+            return greeks;
+        }
+        
+        
+        // Output for every point from start to end, written to a buffer of n values
+        void EuropeanSweep::Run(const double& start, const double& end, const double& step, const unsigned& output,
+                                double* values, const std::size_t& n)
+        {
+            Simd::KernelOutput out;
+            switch (output)
+            {
+                case DELTA: out.delta = values; break;
+                case GAMMA: out.gamma = values; break;
+                case VEGA:  out.vega = values; break;
+                case THETA: out.theta = values; break;
+                case RHO:   out.rho = values; break;
+                default:    out.price = values; break;
+            }
+            RunGreeks(start, end, step, out, n);
+        }
+        
+        
+        // Outputs with a non-null pointer for every point from start to end, written to buffers of n values
+        void EuropeanSweep::RunGreeks(const double& start, const double& end, const double& step, const Simd::KernelOutput& out,
+                                      const std::size_t& n)
+        {
+            std::size_t points = Points(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the varying factor
+            if ((end < 0 || start < 0) || ((end == 0 || start == 0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Outputs to compute
+            unsigned mask = 0;
+            if (out.price) mask |= PRICE;
+            if (out.delta) mask |= DELTA;
+            if (out.gamma) mask |= GAMMA;
+            if (out.vega)  mask |= VEGA;
+            if (out.theta) mask |= THETA;
+            if (out.rho)   mask |= RHO;
+            
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                OptionGreeks point = Evaluate(i, mask);
+                if (out.price) out.price[row] = point.price;
+                if (out.delta) out.delta[row] = point.delta;
+                if (out.gamma) out.gamma[row] = point.gamma;
+                if (out.vega)  out.vega[row] = point.vega;
+                if (out.theta) out.theta[row] = point.theta;
+                if (out.rho)   out.rho[row] = point.rho;
+            }
+        }
+    }
+}
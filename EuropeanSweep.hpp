@@ -0,0 +1,92 @@
+//  EuropeanSweep.hpp
+//  Sweep engine for European options with one varying factor.
+//  The terms of the Black-Scholes formula that do not depend on the
+//  varying factor (sqrt(T), sig * sqrt(T), log(K), the discount factors,
+//  ...) are computed once, so a spot ladder costs one log and the normal
+//  CDFs per point, and a rate ladder only the two discount factors.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef EuropeanSweep_hpp
+#define EuropeanSweep_hpp
+
+#include <vector>
+#include "OptionData.hpp"
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+#include "SimdKernel.hpp"
+
+namespace All_Options
+{
+    namespace European
+    {
+        class EuropeanSweep
+        {
+        private:
+            ///////////////////////////////////////////Private data//////////////////////////////////////////////////
+            
+            double T, K, sig, r, b, S;  // Factors, the varying one is overwritten at each point
+            double w;                   // 1 for a call, -1 for a put
+            Factor factor;              // Varying factor
+            NormalMode mode;            // Accuracy of the normal distribution
+            
+            double sqrtT, tmp;          // sqrt(T) and sig * sqrt(T)
+            double logS, logK;          // log(S) and log(K)
+            double drift;               // (b + sig^2 / 2) * T
+            double dfb, dfr;            // exp((b - r) * T) and exp(-r * T)
+            double d1, d2;              // d1 and d2 of the current point
+            double Nd1, Nd2, nd1;       // N(w * d1), N(w * d2) and n(d1)
+            unsigned cached;            // Bits 1, 2, 4 set when Nd1, Nd2, nd1 are valid for d1 and d2
+            
+            ////////////////////////////////////////Private Functions///////////////////////////////////////////
+            
+            // Compute every term from the factors
+            void Init();
+            
+            // Recompute the terms that depend on the varying factor
+            void Update();
+            
+        public:
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Prepare a sweep of the given factor of an option
+            // The option type is taken from data.optType
+            EuropeanSweep(const struct OptionData& data, const Factor& factor, const NormalMode& mode = EXACT);
+            
+            /////////////////////////////////////////Evaluation/////////////////////////////////////////////////
+            
+            // Price and sensitivities selected by the mask with the varying factor set to value
+            struct OptionGreeks Evaluate(const double& value, const unsigned& mask = ALL_GREEKS);
+            
+            // One output (PRICE, DELTA, GAMMA, VEGA, THETA or RHO) with the varying factor set to value
+            double Output(const double& value, const unsigned& output);
+            
+            // Change a factor that does not vary in the sweep (used for the rows of a surface)
+            // Every term is recomputed
+            void Set(const Factor& fixed, const double& value);
+            
+            // Number of points from start to end with the given step (same points as GenerateMatrix)
+            // Throw InvalidStepException if the step does not lead from start to end
+            static std::size_t Points(const double& start, const double& end, const double& step);
+            
+            // Output (PRICE, DELTA, GAMMA, VEGA, THETA or RHO) for every point from start to end
+            // Throw InvalidValueException for negative values, or a zero strike
+            std::vector<double> Run(const double& start, const double& end, const double& step, const unsigned& output);
+            
+            // Outputs selected by the mask for every point from start to end
+            BatchGreeks RunGreeks(const double& start, const double& end, const double& step, const unsigned& mask = ALL_GREEKS);
+            
+            // Same as Run and RunGreeks, writing to caller buffers of n = Points(start, end, step) values
+            // RunGreeks computes the outputs whose pointer is not null; nothing is allocated
+            // Throw InvalidSizeException if n is not the number of points
+            void Run(const double& start, const double& end, const double& step, const unsigned& output,
+                     double* values, const std::size_t& n);
+            void RunGreeks(const double& start, const double& end, const double& step, const Simd::KernelOutput& out,
+                           const std::size_t& n);
+        };
+    }
+}
+
+#endif
@@ -20,6 +20,8 @@ InvalidStepException::~InvalidStepException() {};
 
 InvalidValueException::~InvalidValueException() {};
 
+InvalidSizeException::~InvalidSizeException() {};
+
 //////////////////Constructors for different exceptions of Option classes////////////////////////
 
 // Exception that checks the name of factors
@@ -32,6 +34,10 @@ InvalidOptionTypeException::InvalidOptionTypeException(const char& type): err(ty
 InvalidStepException::InvalidStepException(const double& Step, const double& Start, const double& End):
 step(Step), start(Start), end(End) {};
 
+// Exception that checks the length of an input or output array
+InvalidSizeException::InvalidSizeException(const std::size_t& Expected, const std::size_t& Given):
+expected(Expected), given(Given) {};
+
 ///////////////////////////////////////Error Message////////////////////////////////////////////
 
 std::string InvalidFactorException::GetMessage() const
@@ -66,3 +72,11 @@ std::string InvalidValueException::GetMessage() const
     str << "Parameters cannot be negative and K must be positive!";
     return str.str();
 }
+
+std::string InvalidSizeException::GetMessage() const
+{
+    std::stringstream str;
+    // Tell the array does not have the length of the batch
+    str << "Expected " << expected << " values but got " << given << "!";
+    return str.str();
+}
@@ -9,6 +9,7 @@
 #define Exception_hpp
 
 #include <iostream>
+#include <cstddef>
 
 // Base class of all exceptions
 class OptionException
@@ -97,4 +98,24 @@ public:
 };
 
 
+
+// Exception that checks the length of an input or output array
+class InvalidSizeException: public OptionException
+{
+private:
+    // expected and given lengths
+    std::size_t expected, given;
+    
+public:
+    // Constructor that stores the expected and the given length
+    InvalidSizeException(const std::size_t& Expected, const std::size_t& Given);
+    
+    // Default destructor
+    virtual ~InvalidSizeException();
+    
+    // Print error message
+    std::string GetMessage() const;
+};
+
+
 #endif
@@ -0,0 +1,591 @@
+//  FiniteDifference.cpp
+//  Crank-Nicolson finite-difference engine for European and American
+//  options, and the option class that prices through it.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "FiniteDifference.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    namespace FiniteDifference
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Engine Constructors/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        FiniteDifferenceEngine::FiniteDifferenceEngine(): config(FiniteDifferenceConfig()) {}
+        
+        FiniteDifferenceEngine::FiniteDifferenceEngine(const FiniteDifferenceConfig& c): config(c) {}
+        
+        // Get the settings
+        const FiniteDifferenceConfig& FiniteDifferenceEngine::get_config() const
+        {
+            return config;
+        }
+        
+        // Change the settings for the next solves
+        void FiniteDifferenceEngine::set_config(const FiniteDifferenceConfig& c)
+        {
+            config = c;
+            solved = false;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////Solver//////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Thomas algorithm with constant sub and super diagonals
+        void FiniteDifferenceEngine::SolveTridiagonal(const double& a, const double* d, const double& c, const double* r,
+                                                      double* x, double* work, const std::size_t& n)
+        {
+            if (n == 0) return;
+            
+            // Forward elimination: work holds the modified super diagonal, x the modified right-hand side
+            work[0] = c / d[0];
+            x[0] = r[0] / d[0];
+            for (std::size_t i = 1; i < n; i++)
+            {
+                double m = d[i] - a * work[i - 1];
+                work[i] = c / m;
+                x[i] = (r[i] - a * x[i - 1]) / m;
+            }
+            
+            // Back substitution
+            for (std::size_t i = n - 1; i > 0; i--)
+                x[i - 1] -= work[i - 1] * x[i];
+        }
+        
+        // Value of the option at S = 0 (outside the log grid)
+        double FiniteDifferenceEngine::ZeroSpotValue() const
+        {
+            if (call)
+                return 0.0;
+            return american? data.K : data.K * exp(-data.r * data.T);
+        }
+        
+        // Dirichlet values at the two ends of the grid, tau years before expiry
+        void FiniteDifferenceEngine::BoundaryValues(const double& tau, double& low, double& high) const
+        {
+            double dfr = exp(-data.r * tau), dfb = exp((data.b - data.r) * tau);
+            if (call)
+            {
+                low = 0.0;
+                high = spot.back() * dfb - data.K * dfr;
+                if (american) high = std::max(high, spot.back() - data.K);
+            }
+            else
+            {
+                low = data.K * dfr - spot.front() * dfb;
+                if (american) low = std::max(low, data.K - spot.front());
+                high = 0.0;
+            }
+        }
+        
+        // One theta-scheme step: (I - theta dt L) V(tau) = (I + (1 - theta) dt L) V(tau - dt)
+        void FiniteDifferenceEngine::Step(const double& tau, const double& dt, const double& theta)
+        {
+            std::size_t nodes = value.size(), m = nodes - 2;
+            
+            // L V_i = alpha V_(i-1) + beta V_i + gamma V_(i+1) in log-spot
+            double diffusion = 0.5 * data.sig * data.sig / (dx * dx);
+            double drift = (data.b - 0.5 * data.sig * data.sig) / (2 * dx);
+            double alpha = diffusion - drift, beta = -2 * diffusion - data.r, gamma = diffusion + drift;
+            
+            // Explicit part on the interior nodes 1 .. nodes - 2, stored from rhs[0]
+            double e = (1 - theta) * dt;
+            for (std::size_t i = 1; i + 1 < nodes; i++)
+                rhs[i - 1] = value[i] + e * (alpha * value[i - 1] + beta * value[i] + gamma * value[i + 1]);
+            
+            // Implicit matrix and the boundary values of the step
+            double low, high;
+            BoundaryValues(tau, low, high);
+            double lower = -theta * dt * alpha, upper = -theta * dt * gamma, center = 1 - theta * dt * beta;
+            value[0] = low;
+            value[nodes - 1] = high;
+            double* interior = value.data() + 1;
+            const double* floor = payoff.data() + 1;
+            
+            // PSOR reads the boundary values as the neighbours interior[-1] and interior[m] of the edge nodes,
+            // so only the tridiagonal solves move them to the right-hand side
+            if (american && config.method == PSOR)
+            {
+                // Projected Gauss-Seidel with over-relaxation, from the previous values
+                double tolerance = config.tolerance * data.K;
+                for (std::size_t i = 0; i < m; i++)
+                    interior[i] = std::max(interior[i], floor[i]);
+                for (int iteration = 0; iteration < 10000; iteration++)
+                {
+                    double change = 0;
+                    for (std::size_t i = 0; i < m; i++)
+                    {
+                        double y = (rhs[i] - lower * interior[i - 1] - upper * interior[i + 1]) / center;
+                        y = std::max(floor[i], interior[i] + config.omega * (y - interior[i]));
+                        change = std::max(change, std::fabs(y - interior[i]));
+                        interior[i] = y;
+                    }
+                    if (change < tolerance)
+                        break;
+                }
+                return;
+            }
+            
+            rhs[0] -= lower * low;
+            rhs[m - 1] -= upper * high;
+            
+            if (!american)
+            {
+                std::fill(diag.begin(), diag.begin() + m, center);
+                SolveTridiagonal(lower, diag.data(), upper, rhs.data(), interior, work.data(), m);
+                return;
+            }
+            
+            // Penalty iteration: nodes below the payoff get a large penalty pulling them to it,
+            // until the set of penalized nodes stops changing
+            const double penalty = 1e8;
+            for (std::size_t i = 0; i < m; i++)
+                active[i] = (interior[i] <= floor[i]);
+            for (int iteration = 0; iteration < 100; iteration++)
+            {
+                for (std::size_t i = 0; i < m; i++)
+                {
+                    diag[i] = active[i]? center + penalty : center;
+                    next[i] = active[i]? rhs[i] + penalty * floor[i] : rhs[i];
+                }
+                SolveTridiagonal(lower, diag.data(), upper, next.data(), next.data(), work.data(), m);
+                
+                bool changed = false;
+                for (std::size_t i = 0; i < m; i++)
+                {
+                    unsigned char below = (next[i] < floor[i]);
+                    changed |= (below != active[i]);
+                    active[i] = below;
+                }
+                if (!changed)
+                    break;
+            }
+            for (std::size_t i = 0; i < m; i++)
+                interior[i] = std::max(next[i], floor[i]);
+        }
+        
+        // Solve the PDE for an option on a grid covering the spots from low to high
+        void FiniteDifferenceEngine::Solve(const struct OptionData& d, const ExerciseStyle& style,
+                                           const double& low, const double& high)
+        {
+            // The grid of the last solve still holds for the same option, style and range
+            if (solved && d.T == data.T && d.K == data.K && d.sig == data.sig && d.r == data.r && d.b == data.b &&
+                d.S == data.S && d.optType == data.optType && (style == AMERICAN_EXERCISE) == american &&
+                low == range[0] && high == range[1])
+                return;
+            solved = true;
+            range[0] = low;
+            range[1] = high;
+            
+            data = d;
+            call = (data.optType == 'C');
+            american = (style == AMERICAN_EXERCISE);
+            const double& K = data.K;
+            
+            // Log-spot range: the spots and the strike plus width standard deviations on each side
+            double smin = (low > 0)? std::min(low, K) : K;
+            double smax = std::max(high, K);
+            double half = std::max(config.width * data.sig * sqrt(data.T), 0.1);
+            double xlo = log(smin) - half, xhi = log(smax) + half;
+            
+            // Put the strike on a node
+            std::size_t steps = std::max<std::size_t>(config.space_steps, 4);
+            dx = (xhi - xlo) / steps;
+            double below = std::ceil((log(K) - xlo) / dx);
+            x0 = log(K) - below * dx;
+            std::size_t nodes = static_cast<std::size_t>(std::ceil((xhi - x0) / dx)) + 1;
+            nodes = std::max<std::size_t>(nodes, 4);
+            
+            // Size the buffers (no allocation when the size does not grow)
+            spot.resize(nodes); value.resize(nodes); payoff.resize(nodes);
+            rhs.resize(nodes); diag.resize(nodes); work.resize(nodes); next.resize(nodes); active.resize(nodes);
+            
+            // Initial condition at expiry
+            double w = call? 1.0 : -1.0;
+            for (std::size_t i = 0; i < nodes; i++)
+            {
+                spot[i] = exp(x0 + i * dx);
+                payoff[i] = std::max(w * (spot[i] - K), 0.0);
+                value[i] = payoff[i];
+            }
+            if (data.T == 0)
+                return;
+            
+            // March from expiry to today, the first steps as implicit Euler half steps
+            std::size_t time_steps = std::max<std::size_t>(config.time_steps, 1);
+            double dt = data.T / time_steps;
+            for (std::size_t s = 0; s < time_steps; s++)
+            {
+                double tau = (s + 1) * dt;
+                if (s < config.rannacher_steps)
+                {
+                    Step(tau - 0.5 * dt, 0.5 * dt, 1.0);
+                    Step(tau, 0.5 * dt, 1.0);
+                }
+                else
+                    Step(tau, dt, 0.5);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////Results/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Position of S on the grid: index of the first of four interpolation nodes and the offset from it
+        void FiniteDifferenceEngine::Locate(const double& S, std::size_t& i, double& t) const
+        {
+            double u = (log(S) - x0) / dx;
+            double first = std::floor(u) - 1;
+            first = std::min(std::max(first, 0.0), static_cast<double>(value.size() - 4));
+            i = static_cast<std::size_t>(first);
+            t = u - first;
+        }
+        
+        // Price, delta and gamma selected by the mask at spot S in one interpolation
+        OptionGreeks FiniteDifferenceEngine::Greeks(const double& S, const unsigned& mask) const
+        {
+            OptionGreeks greeks;
+            double w = call? 1.0 : -1.0;
+            
+            // Exercise value at expiry
+            if (data.T == 0)
+            {
+                greeks.price = std::max(w * (S - data.K), 0.0);
+                greeks.delta = (w * (S - data.K) > 0)? w : 0.0;
+                return greeks;
+            }
+            
+            // Left end of the spot axis: a put is exercised (American) or worth its discounted strike
+            if (S == 0)
+            {
+                greeks.price = ZeroSpotValue();
+                greeks.delta = call? 0.0 : (american? -1.0 : -exp((data.b - data.r) * data.T));
+                return greeks;
+            }
+            
+            // Cubic Lagrange interpolation on four nodes at offsets 0, 1, 2, 3 from node i
+            std::size_t i;
+            double t;
+            Locate(S, i, t);
+            const double* v = value.data() + i;
+            double p = -v[0] * (t - 1) * (t - 2) * (t - 3) / 6 + v[1] * t * (t - 2) * (t - 3) / 2
+                       - v[2] * t * (t - 1) * (t - 3) / 2 + v[3] * t * (t - 1) * (t - 2) / 6;
+            if (mask & PRICE)
+                greeks.price = p;
+            if (mask & (DELTA | GAMMA))
+            {
+                // Derivatives in x = log(S): dV/dS = V_x / S and d2V/dS2 = (V_xx - V_x) / S^2
+                double dp = -v[0] * (3 * t * t - 12 * t + 11) / 6 + v[1] * (3 * t * t - 10 * t + 6) / 2
+                            - v[2] * (3 * t * t - 8 * t + 3) / 2 + v[3] * (3 * t * t - 6 * t + 2) / 6;
+                double vx = dp / dx;
+                if (mask & DELTA)
+                    greeks.delta = vx / S;
+                if (mask & GAMMA)
+                {
+                    double ddp = -v[0] * (t - 2) + v[1] * (3 * t - 5) - v[2] * (3 * t - 4) + v[3] * (t - 1);
+                    greeks.gamma = (ddp / (dx * dx) - vx) / (S * S);
+                }
+            }
+            return greeks;
+        }
+        
+        // Price at spot S from the last solve
+        double FiniteDifferenceEngine::Price(const double& S) const
+        {
+            return Greeks(S, PRICE).price;
+        }
+        
+        // Delta at spot S from the last solve
+        double FiniteDifferenceEngine::Delta(const double& S) const
+        {
+            return Greeks(S, DELTA).delta;
+        }
+        
+        // Gamma at spot S from the last solve
+        double FiniteDifferenceEngine::Gamma(const double& S) const
+        {
+            return Greeks(S, GAMMA).gamma;
+        }
+        
+        // Spots of every node of the last solve
+        const std::vector<double>& FiniteDifferenceEngine::Spots() const
+        {
+            return spot;
+        }
+        
+        // Prices of every node of the last solve
+        const std::vector<double>& FiniteDifferenceEngine::Values() const
+        {
+            return value;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Option Constructors/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Default FiniteDifferenceOption constructor
+        FiniteDifferenceOption::FiniteDifferenceOption(): Option(), style(AMERICAN_EXERCISE), engine() {}
+        
+        // Copy option
+        FiniteDifferenceOption::FiniteDifferenceOption(const FiniteDifferenceOption& o2)
+        : Option(o2), style(o2.style), engine(o2.engine.get_config()) {}
+        
+        // Create an option of certain type
+        FiniteDifferenceOption::FiniteDifferenceOption(const char& optionType, const ExerciseStyle& s,
+                                                       const FiniteDifferenceConfig& config)
+        : Option(optionType), style(s), engine(config) {}
+        
+        // Create an option using given data
+        FiniteDifferenceOption::FiniteDifferenceOption(const struct OptionData& data, const ExerciseStyle& s,
+                                                       const FiniteDifferenceConfig& config)
+        : Option(data), style(s), engine(config) {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        FiniteDifferenceOption::~FiniteDifferenceOption() {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Operators/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Assignment operator
+        FiniteDifferenceOption& FiniteDifferenceOption::operator = (const FiniteDifferenceOption& option2)
+        {
+            // Return original objects if addresses are the same
+            if (this == &option2) return *this;
+            
+            Option::operator = (option2);
+            style = option2.style;
+            engine.set_config(option2.engine.get_config());
+            return *this;
+        }
+        
+        // Get the information of the object using <<
+        std::ostream& operator << (std::ostream& os, const FiniteDifferenceOption& op)
+        {
+            // Get the description from ToString() function
+            os << op.ToString();
+            return os;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the exercise style
+        const ExerciseStyle& FiniteDifferenceOption::get_style() const
+        {
+            return style;
+        }
+        
+        // Set the exercise style
+        void FiniteDifferenceOption::set_style(const ExerciseStyle& s)
+        {
+            style = s;
+        }
+        
+        // Get the settings of the grid and the solver
+        const FiniteDifferenceConfig& FiniteDifferenceOption::get_config() const
+        {
+            return engine.get_config();
+        }
+        
+        // Set the settings of the grid and the solver
+        void FiniteDifferenceOption::set_config(const FiniteDifferenceConfig& config)
+        {
+            engine.set_config(config);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Solve for the factors indexed by Factor on a grid covering the spots from low to high
+        void FiniteDifferenceOption::Solve(const double (&f)[6], const double& low, const double& high) const
+        {
+            OptionData d = data;
+            d.T = f[0]; d.K = f[1]; d.sig = f[2]; d.r = f[3]; d.b = f[4]; d.S = f[5];
+            engine.Solve(d, style, low, high);
+        }
+        
+        // Calculate the price of the option
+        double FiniteDifferenceOption::Price() const
+        {
+            double f[6];
+            FactorArray(f);
+            Solve(f, f[5], f[5]);
+            return engine.Price(f[5]);
+        }
+        
+        // Given a factor name and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double FiniteDifferenceOption::Price(std::string factor, const double& value) const
+        {
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor name and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> FiniteDifferenceOption::Price
+        (std::string factor, const double& start, const double& end, const double& step) const
+        {
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double FiniteDifferenceOption::Price(const Factor& factor, const double& value) const
+        {
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
+            
+            // Check if the values of parameter are valid
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
+            
+            Solve(f, f[5], f[5]);
+            return engine.Price(f[5]);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> FiniteDifferenceOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            // Create a vector that will store prices of different option parameters
+            std::vector<double> price_vec(SweepSize(start, end, step));
+            Price(factor, start, end, step, price_vec.data(), price_vec.size());
+            return price_vec;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void FiniteDifferenceOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffer are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the input factor
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
+            
+            // Use to determine whether the varying parameter is increasing or decreasing
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            
+            // A spot ladder is read off one grid
+            if (factor == Factor::S)
+            {
+                Solve(f, std::min(start, end), std::max(start, end));
+                for (double i = start; (i - end) * direction <= 0; i += step, row++)
+                    price[row] = engine.Price(i);
+                return;
+            }
+            
+            // Loop over varying options, one solve each on the same buffers
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                // Change the value corresponding to the input factor
+                x = i;
+                Solve(f, f[5], f[5]);
+                price[row] = engine.Price(f[5]);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Greeks Getters////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the delta of the option from the grid
+        double FiniteDifferenceOption::Delta() const
+        {
+            return Greeks(DELTA).delta;
+        }
+        
+        // Calculate the gamma of the option from the grid
+        double FiniteDifferenceOption::Gamma() const
+        {
+            return Greeks(GAMMA).gamma;
+        }
+        
+        // Calculate the price, delta and gamma selected by the mask from one solve
+        OptionGreeks FiniteDifferenceOption::Greeks(const unsigned& mask) const
+        {
+            double f[6];
+            FactorArray(f);
+            Solve(f, f[5], f[5]);
+            return engine.Greeks(f[5], mask);
+        }
+        
+        // Given start, end and step of the spot, calculate the price, delta and gamma selected by the mask
+        BatchGreeks FiniteDifferenceOption::Greeks
+        (const double& start, const double& end, const double& step, const unsigned& mask) const
+        {
+            std::size_t n = SweepSize(start, end, step);
+            if (end < 0 || start < 0)
+                throw InvalidValueException();
+            
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            if (mask & PRICE) greeks.price.resize(n);
+            if (mask & DELTA) greeks.delta.resize(n);
+            if (mask & GAMMA) greeks.gamma.resize(n);
+            
+            double f[6];
+            FactorArray(f);
+            Solve(f, std::min(start, end), std::max(start, end));
+            
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                OptionGreeks g = engine.Greeks(i, mask);
+                if (mask & PRICE) greeks.price[row] = g.price;
+                if (mask & DELTA) greeks.delta[row] = g.delta;
+                if (mask & GAMMA) greeks.gamma[row] = g.gamma;
+            }
+            return greeks;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        std::string FiniteDifferenceOption::ToString() const
+        {
+            // Create a stringstream
+            std::stringstream str;
+            
+            // Put the content from Options to the stringstream
+            str << ((style == AMERICAN_EXERCISE)? "American" : "European") << " Option (finite difference)\n"
+                << Option::ToString();
+            return str.str();
+        }
+    }
+}
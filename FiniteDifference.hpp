@@ -0,0 +1,231 @@
+//  FiniteDifference.hpp
+//  Crank-Nicolson finite-difference engine for European and American
+//  options. The Black-Scholes PDE is solved in x = log(S) on a uniform
+//  grid that has the strike on a node, with Rannacher start-up steps
+//  (implicit Euler half steps) to damp the payoff kink, and one
+//  tridiagonal (Thomas) solve per time step on contiguous buffers. Early
+//  exercise is enforced by a penalty iteration or by PSOR. One solve
+//  gives the price on every spot node, so spot ladders, delta and gamma
+//  are read off the grid instead of solving once per spot.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef FiniteDifference_hpp
+#define FiniteDifference_hpp
+
+#include <cstddef>
+#include <vector>
+#include "Greeks.hpp"
+#include "Options.hpp"
+
+namespace All_Options
+{
+    namespace FiniteDifference
+    {
+        // Ways of enforcing V >= payoff for American exercise
+        // PENALTY: solve with a large penalty on the nodes below the payoff until they stop changing
+        // PSOR: projected successive over-relaxation on the same system
+        enum ExerciseMethod { PENALTY = 0, PSOR = 1 };
+        
+        // Grid and solver settings
+        struct FiniteDifferenceConfig
+        {
+            std::size_t space_steps = 400;      // Intervals of the log-spot grid
+            std::size_t time_steps = 200;       // Time steps from expiry to today
+            std::size_t rannacher_steps = 2;    // First time steps taken as two implicit Euler half steps each
+            double width = 5;                   // Standard deviations sig * sqrt(T) beyond the spots and the strike
+            ExerciseMethod method = PENALTY;    // Early exercise method
+            double omega = 1.2;                 // PSOR relaxation factor
+            double tolerance = 1e-10;           // PSOR tolerance on the change of a node, per unit strike
+        };
+        
+        class FiniteDifferenceEngine
+        {
+        private:
+            
+            // Settings of the grid and the solver
+            FiniteDifferenceConfig config;
+            
+            // Option of the last solve
+            struct OptionData data;
+            bool call = true;
+            bool american = false;
+            
+            // Grid of the last solve: x = log(S) from x0 with step dx, values at today
+            double x0 = 0;
+            double dx = 0;
+            std::vector<double> spot;
+            std::vector<double> value;
+            
+            // Spot range of the last solve, which is skipped when its option, style and range repeat
+            bool solved = false;
+            double range[2] = { 0, 0 };
+            
+            // Buffers reused from solve to solve
+            std::vector<double> payoff;
+            std::vector<double> rhs;
+            std::vector<double> diag;
+            std::vector<double> work;
+            std::vector<double> next;
+            std::vector<unsigned char> active;
+            
+            // Value of the option at S = 0 (outside the log grid)
+            double ZeroSpotValue() const;
+            
+            // Dirichlet values at the two ends of the grid, tau years before expiry
+            void BoundaryValues(const double& tau, double& low, double& high) const;
+            
+            // One theta-scheme step of length dt from value (tau - dt) to value (tau)
+            void Step(const double& tau, const double& dt, const double& theta);
+            
+            // Position of S on the grid: index of the first of four interpolation nodes and the offset from it
+            void Locate(const double& S, std::size_t& i, double& t) const;
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            FiniteDifferenceEngine();
+            FiniteDifferenceEngine(const FiniteDifferenceConfig& config);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the settings
+            const FiniteDifferenceConfig& get_config() const;
+            
+            // Change the settings for the next solves
+            void set_config(const FiniteDifferenceConfig& config);
+            
+            ////////////////////////////////////////Solver//////////////////////////////////////////////////////
+            
+            // Solve the PDE for an option on a grid covering the spots from low to high
+            // The buffers of the previous solve are reused, so repeated solves of the same size do not allocate,
+            // and a solve of the same option, style and range as the previous one keeps its grid
+            void Solve(const struct OptionData& data, const ExerciseStyle& style, const double& low, const double& high);
+            
+            // Solve the tridiagonal system with constant sub and super diagonals a and c and diagonal d
+            // by the Thomas algorithm; work holds n values, x may alias r
+            static void SolveTridiagonal(const double& a, const double* d, const double& c, const double* r,
+                                         double* x, double* work, const std::size_t& n);
+            
+            ////////////////////////////////////////Results/////////////////////////////////////////////////////
+            
+            // Price, delta and gamma at spot S from the last solve (cubic interpolation in log(S))
+            // S should be inside the range given to Solve
+            double Price(const double& S) const;
+            double Delta(const double& S) const;
+            double Gamma(const double& S) const;
+            
+            // Price, delta and gamma selected by the mask at spot S in one interpolation (other outputs are 0)
+            OptionGreeks Greeks(const double& S, const unsigned& mask = PRICE | DELTA | GAMMA) const;
+            
+            // Spots and prices of every node of the last solve
+            const std::vector<double>& Spots() const;
+            const std::vector<double>& Values() const;
+        };
+        
+        class FiniteDifferenceOption: public Option
+        {
+        private:
+            
+            // Exercise style of the option
+            ExerciseStyle style;
+            
+            // Engine whose buffers are reused by every call (an option object is not safe to share between threads)
+            mutable FiniteDifferenceEngine engine;
+            
+            // Solve for the factors indexed by Factor on a grid covering the spots from low to high
+            void Solve(const double (&f)[6], const double& low, const double& high) const;
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Default FiniteDifferenceOption constructor (American exercise)
+            FiniteDifferenceOption();
+            
+            // Copy Constructor
+            FiniteDifferenceOption(const FiniteDifferenceOption& option2);
+            
+            // Constructe an option of certain type
+            FiniteDifferenceOption(const char& optionType, const ExerciseStyle& style = AMERICAN_EXERCISE,
+                                   const FiniteDifferenceConfig& config = FiniteDifferenceConfig());
+            
+            // Constructe an option using given data
+            FiniteDifferenceOption(const struct OptionData& optionData, const ExerciseStyle& style = AMERICAN_EXERCISE,
+                                   const FiniteDifferenceConfig& config = FiniteDifferenceConfig());
+            
+            /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+            
+            virtual ~FiniteDifferenceOption();
+            
+            //////////////////////////////////////////Operators/////////////////////////////////////////////////
+            
+            // Assignment operator
+            FiniteDifferenceOption& operator = (const FiniteDifferenceOption& option2);
+            
+            // Get the information of the object using <<
+            friend std::ostream& operator << (std::ostream& os, const FiniteDifferenceOption& op);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the exercise style
+            const ExerciseStyle& get_style() const;
+            
+            // Set the exercise style
+            void set_style(const ExerciseStyle& style);
+            
+            // Get the settings of the grid and the solver
+            const FiniteDifferenceConfig& get_config() const;
+            
+            // Set the settings of the grid and the solver
+            void set_config(const FiniteDifferenceConfig& config);
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Calculate the price of the option
+            virtual double Price() const;
+            
+            // Given a factor name and its value, calculate the price of the option
+            // The class variable is not changed to the given value.
+            virtual double Price(std::string factor, const double& value) const;
+            
+            // Given a factor name and start, end and step of the factor
+            // Calculte the price of the option for each variable change. Output a vector of prices
+            // A spot ladder ("S") takes one solve; other factors take one solve per value
+            virtual std::vector<double> Price(std::string factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            virtual double Price(const Factor& factor, const double& value) const;
+            virtual std::vector<double> Price(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) prices to a caller buffer without allocating
+            // Throw InvalidSizeException if n is not the number of values
+            void Price(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* price, const std::size_t& n) const;
+            
+            //////////////////////////////////////Greeks Getters////////////////////////////////////////////////
+            
+            // Calculate the delta and the gamma of the option from the grid
+            // Price(), Delta() and Gamma() share the grid while the option does not change
+            double Delta() const;
+            double Gamma() const;
+            
+            // Calculate the price, delta and gamma selected by the mask from one solve (other outputs are 0)
+            OptionGreeks Greeks(const unsigned& mask = PRICE | DELTA | GAMMA) const;
+            
+            // Given start, end and step of the spot, calculate the price, delta and gamma selected by the mask
+            // for every spot from one solve (other outputs stay empty)
+            BatchGreeks Greeks(const double& start, const double& end, const double& step,
+                               const unsigned& mask = PRICE | DELTA | GAMMA) const;
+            
+            ////////////////////////////////////////Description/////////////////////////////////////////////////
+            
+            virtual std::string ToString() const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,319 @@
+//  Fourier.cpp
+//  Characteristic function engine for European options.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "Fourier.hpp"
+#include "OptionMatrix.hpp"
+#include "Exception.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace All_Options
+{
+    namespace Fourier
+    {
+        static const double Pi = 3.14159265358979323846;
+        
+        // Strikes priced side by side by the COS method
+        static const std::size_t LANES = 64;
+        
+        // In-place radix-2 FFT: a[j] = sum_m a[m] exp(-2 pi i j m / n), n a power of 2
+        static void FFT(std::vector<std::complex<double>>& a)
+        {
+            std::size_t n = a.size();
+            
+            // Bit reversal permutation
+            for (std::size_t i = 1, j = 0; i < n; i++)
+            {
+                std::size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1)
+                    j ^= bit;
+                j ^= bit;
+                if (i < j)
+                    std::swap(a[i], a[j]);
+            }
+            
+            // Butterflies of length 2, 4, .. n
+            for (std::size_t length = 2; length <= n; length <<= 1)
+            {
+                std::complex<double> step = std::polar(1.0, -2 * Pi / length);
+                for (std::size_t i = 0; i < n; i += length)
+                {
+                    std::complex<double> w(1.0, 0.0);
+                    for (std::size_t j = 0; j < length / 2; j++)
+                    {
+                        std::complex<double> even = a[i + j], odd = a[i + j + length / 2] * w;
+                        a[i + j] = even + odd;
+                        a[i + j + length / 2] = even - odd;
+                        w *= step;
+                    }
+                }
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////Private Price Calculator/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Characteristic function E[exp(i u log(S_T / S))] for an expiry
+        std::complex<double> FourierEngine::Characteristic(const std::complex<double>& u, const double& T, const double& sig,
+                                                           const double& b) const
+        {
+            const std::complex<double> i(0.0, 1.0);
+            if (model == BLACK_SCHOLES)
+                return exp(i * u * (b - 0.5 * sig * sig) * T - 0.5 * sig * sig * u * u * T);
+            
+            // Heston, in the form of Albrecher et al. that stays on the principal branch of the logarithm
+            const double &kappa = heston.kappa, &theta = heston.theta, &xi = heston.xi, &rho = heston.rho;
+            std::complex<double> beta = kappa - rho * xi * i * u;
+            std::complex<double> d = sqrt(beta * beta + xi * xi * (i * u + u * u));
+            std::complex<double> g = (beta - d) / (beta + d), e = exp(-d * T);
+            std::complex<double> C = kappa * theta / (xi * xi) * ((beta - d) * T - 2.0 * log((1.0 - g * e) / (1.0 - g)));
+            std::complex<double> D = (beta - d) / (xi * xi) * (1.0 - e) / (1.0 - g * e);
+            return exp(i * u * b * T + C + D * sig * sig);
+        }
+        
+        // Price n options of one expiry with strikes K and types type
+        void FourierEngine::PriceExpiry(const double& T, const double& sig, const double& r, const double& b, const double& S,
+                                        const double* K, const char* type, const std::size_t& n, double* price) const
+        {
+            double df = exp(-r * T), forward = S * exp(b * T);
+            auto put = [&](const char& t) { return t == 'P' || t == 'p'; };
+            
+            // Cumulants of log(S_T / S), which size the interval of the COS method
+            double c1, c2;
+            if (model == BLACK_SCHOLES)
+            {
+                c1 = (b - 0.5 * sig * sig) * T;
+                c2 = sig * sig * T;
+            }
+            else
+            {
+                const double &kappa = heston.kappa, &theta = heston.theta, &xi = heston.xi, &rho = heston.rho;
+                double v0 = sig * sig, e1 = exp(-kappa * T), e2 = exp(-2 * kappa * T);
+                c1 = b * T + (1 - e1) * (theta - v0) / (2 * kappa) - 0.5 * theta * T;
+                c2 = (xi * T * kappa * e1 * (v0 - theta) * (8 * kappa * rho - 4 * xi)
+                      + kappa * rho * xi * (1 - e1) * (16 * theta - 8 * v0)
+                      + 2 * theta * kappa * T * (-4 * kappa * rho * xi + xi * xi + 4 * kappa * kappa)
+                      + xi * xi * ((theta - 2 * v0) * e2 + theta * (6 * e1 - 7) + 2 * v0)
+                      + 8 * kappa * kappa * (v0 - theta) * (1 - e1)) / (8 * kappa * kappa * kappa);
+            }
+            
+            // Without randomness the terminal price is the forward
+            if (T == 0 || S == 0 || !(c2 > 0))
+            {
+                for (std::size_t j = 0; j < n; j++)
+                    price[j] = df * std::max((put(type[j])? -1.0 : 1.0) * (forward - K[j]), 0.0);
+                return;
+            }
+            
+            if (config.method == CARR_MADAN)
+            {
+                // Call prices on the log strikes k0 + j lambda, centered on log(S)
+                const std::complex<double> i(0.0, 1.0);
+                std::size_t N = config.points;
+                double eta = config.eta, alpha = config.alpha, lambda = 2 * Pi / (N * eta);
+                double k0 = log(S) - 0.5 * N * lambda;
+                double scale = df * pow(S, alpha + 1) * eta / 3;
+                
+                // Damped call transform with Simpson weights; exp(i u N lambda / 2) is (-1)^m
+                std::vector<std::complex<double>> x(N);
+                for (std::size_t m = 0; m < N; m++)
+                {
+                    double u = m * eta, weight = (m == 0)? 1.0 : (m % 2 == 1)? 4.0 : 2.0;
+                    std::complex<double> psi = Characteristic(u - (alpha + 1) * i, T, sig, b)
+                                               / std::complex<double>(alpha * alpha + alpha - u * u, (2 * alpha + 1) * u);
+                    x[m] = ((m % 2 == 1)? -scale : scale) * weight * psi;
+                }
+                FFT(x);
+                auto call = [&](const std::size_t& j) { return exp(-alpha * (k0 + j * lambda)) / Pi * x[j].real(); };
+                
+                // Cubic Lagrange interpolation on four grid points around log(K)
+                for (std::size_t j = 0; j < n; j++)
+                {
+                    double position = (log(K[j]) - k0) / lambda;
+                    std::size_t first = static_cast<std::size_t>(std::min(std::max(floor(position) - 1, 0.0), N - 4.0));
+                    double t = position - first;
+                    double c = -call(first) * (t - 1) * (t - 2) * (t - 3) / 6 + call(first + 1) * t * (t - 2) * (t - 3) / 2
+                               - call(first + 2) * t * (t - 1) * (t - 3) / 2 + call(first + 3) * t * (t - 1) * (t - 2) / 6;
+                    price[j] = put(type[j])? c - df * (forward - K[j]) : c;
+                }
+                return;
+            }
+            
+            // COS: log(S_T / K) = log(S / K) + log(S_T / S) lies in [x + a0, x + b0] for x = log(S / K)
+            std::size_t N = config.terms;
+            double width = config.truncation * sqrt(c2), a0 = c1 - width, b0 = c1 + width, range = b0 - a0;
+            
+            // Coefficients Re(phi(u_k) exp(-i u_k a0)) with u_k = k pi / range, shared by all strikes
+            std::vector<double> A(N);
+            for (std::size_t k = 0; k < N; k++)
+            {
+                double u = k * Pi / range;
+                A[k] = (Characteristic(u, T, sig, b) * std::polar(1.0, -u * a0)).real();
+            }
+            A[0] *= 0.5;
+            
+            // Put on [a, d] with a = x + a0, d = min(x + b0, 0): the cosine coefficients of the payoff
+            // K (1 - exp(y)) are 2 / range (psi_k - chi_k), where with w = k pi / range and t = (d - a) / range,
+            // psi_k = sin(k pi t) / w and chi_k = (cos(k pi t) exp(d) - exp(a) + w sin(k pi t) exp(d)) / (1 + w^2)
+            double c[LANES], s[LANES], cr[LANES], sr[LANES], ea[LANES], ed[LANES], sum[LANES];
+            for (std::size_t first = 0; first < n; first += LANES)
+            {
+                std::size_t lanes = std::min(LANES, n - first);
+                for (std::size_t p = 0; p < lanes; p++)
+                {
+                    double x = log(S / K[first + p]), a = x + a0, d = std::min(x + b0, 0.0);
+                    if (a >= d)
+                        a = d;
+                    double t = (d - a) / range;
+                    c[p] = 1;
+                    s[p] = 0;
+                    cr[p] = cos(Pi * t);
+                    sr[p] = sin(Pi * t);
+                    ea[p] = exp(a);
+                    ed[p] = exp(d);
+                    sum[p] = A[0] * ((d - a) - (ed[p] - ea[p]));
+                }
+                for (std::size_t k = 1; k < N; k++)
+                {
+                    double w = k * Pi / range, inv_w = 1 / w, inv_norm = 1 / (1 + w * w), Ak = A[k];
+                    for (std::size_t p = 0; p < lanes; p++)
+                    {
+                        double ck = c[p] * cr[p] - s[p] * sr[p], sk = s[p] * cr[p] + c[p] * sr[p];
+                        c[p] = ck;
+                        s[p] = sk;
+                        sum[p] += Ak * (sk * inv_w - (ck * ed[p] - ea[p] + w * sk * ed[p]) * inv_norm);
+                    }
+                }
+                for (std::size_t p = 0; p < lanes; p++)
+                {
+                    double strike = K[first + p], p_price = std::max(strike * df * 2 / range * sum[p], 0.0);
+                    price[first + p] = put(type[first + p])? p_price : p_price + df * (forward - strike);
+                }
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        FourierEngine::FourierEngine(): model(BLACK_SCHOLES), heston(), config() {}
+        
+        FourierEngine::FourierEngine(const FourierModel& m, const HestonParameters& h, const FourierConfig& c)
+        : model(m), heston(), config()
+        {
+            set_heston(h);
+            set_config(c);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the model
+        const FourierModel& FourierEngine::get_model() const
+        {
+            return model;
+        }
+        
+        // Set the model
+        void FourierEngine::set_model(const FourierModel& m)
+        {
+            model = m;
+        }
+        
+        // Get the Heston parameters
+        const HestonParameters& FourierEngine::get_heston() const
+        {
+            return heston;
+        }
+        
+        // Set the Heston parameters
+        void FourierEngine::set_heston(const HestonParameters& h)
+        {
+            if (!(h.kappa > 0) || !(h.xi > 0) || !(h.theta >= 0) || !(h.rho >= -1 && h.rho <= 1))
+                throw InvalidValueException();
+            heston = h;
+        }
+        
+        // Get the settings
+        const FourierConfig& FourierEngine::get_config() const
+        {
+            return config;
+        }
+        
+        // Set the settings
+        void FourierEngine::set_config(const FourierConfig& c)
+        {
+            if (c.points < 4 || (c.points & (c.points - 1)) != 0 || !(c.eta > 0) || !(c.alpha > 0)
+                || c.terms < 2 || !(c.truncation > 0))
+                throw InvalidValueException();
+            config = c;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price of one option
+        double FourierEngine::Price(const struct OptionData& data) const
+        {
+            return Price(data, std::vector<double>(1, data.K))[0];
+        }
+        
+        // Prices of a strike chain
+        std::vector<double> FourierEngine::Price(const struct OptionData& data, const std::vector<double>& strikes) const
+        {
+            OptionBatch chain(strikes.size(), (data.optType == 0)? 'C' : data.optType);
+            std::fill(chain.T(), chain.T() + strikes.size(), data.T);
+            std::copy(strikes.begin(), strikes.end(), chain.K());
+            std::fill(chain.sig(), chain.sig() + strikes.size(), data.sig);
+            std::fill(chain.r(), chain.r() + strikes.size(), data.r);
+            std::fill(chain.b(), chain.b() + strikes.size(), data.b);
+            std::fill(chain.S(), chain.S() + strikes.size(), data.S);
+            return Price(chain);
+        }
+        
+        // Prices of the rows of a batch
+        std::vector<double> FourierEngine::Price(const OptionBatch& chain) const
+        {
+            std::vector<double> price(chain.size());
+            Price(chain, price.data(), price.size());
+            return price;
+        }
+        
+        // Prices of the rows of a batch, written to a caller buffer
+        void FourierEngine::Price(const OptionBatch& chain, double* price, const std::size_t& n) const
+        {
+            if (n != chain.size())
+                throw InvalidSizeException(chain.size(), n);
+            
+            const double *T = chain.T(), *K = chain.K(), *sig = chain.sig(), *r = chain.r(), *b = chain.b(), *S = chain.S();
+            const char* type = chain.type();
+            
+            // Same checks as the option classes
+            CheckBatch(chain, true);
+            
+            // One pass per run of rows of the same expiry
+            for (std::size_t first = 0; first < n;)
+            {
+                std::size_t last = first + 1;
+                while (last < n && T[last] == T[first] && sig[last] == sig[first] && r[last] == r[first]
+                       && b[last] == b[first] && S[last] == S[first])
+                    last++;
+                PriceExpiry(T[first], sig[first], r[first], b[first], S[first], K + first, type + first, last - first, price + first);
+                first = last;
+            }
+        }
+        
+        // Prices of the rows of a matrix of option data
+        std::vector<double> FourierEngine::Price(const std::vector<std::vector<double>>& matrix, const char& type) const
+        {
+            return Price(OptionBatch(matrix, type));
+        }
+    }
+}
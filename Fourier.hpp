@@ -0,0 +1,136 @@
+//  Fourier.hpp
+//  Characteristic function engine for European options, which prices
+//  every strike of an expiry in one pass. The characteristic function
+//  of log(S_T / S) is known in closed form under Black-Scholes and under
+//  Heston's stochastic volatility model. Carr and Madan's method turns
+//  the damped call price into an FFT over a grid of log strikes, so one
+//  O(N log N) transform prices the whole chain, read off the grid by
+//  cubic interpolation. Fang and Oosterlee's COS method expands the
+//  density in a cosine series: the characteristic function is evaluated
+//  once per expiry, then each strike costs O(N) multiply-adds, summed
+//  over strikes side by side. Puts are priced by COS and calls follow by
+//  put-call parity, which is the stable way round for deep in-the-money
+//  calls.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef Fourier_hpp
+#define Fourier_hpp
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "OptionData.hpp"
+#include "OptionBatch.hpp"
+
+namespace All_Options
+{
+    namespace Fourier
+    {
+        // Models of the underlying
+        // BLACK_SCHOLES: constant volatility sig
+        // HESTON: variance with mean reversion, starting at v0 = sig^2 (see HestonParameters)
+        enum FourierModel { BLACK_SCHOLES = 0, HESTON = 1 };
+        
+        // Pricing methods
+        // CARR_MADAN: FFT of the damped call price over a grid of log strikes
+        // COS: Fourier-cosine expansion of the density, put-call parity for calls
+        enum FourierMethod { CARR_MADAN = 0, COS = 1 };
+        
+        // Heston model dv = kappa (theta - v) dt + xi sqrt(v) dW2, with d<W1, W2> = rho dt
+        struct HestonParameters
+        {
+            double kappa = 1.5;     // Speed of mean reversion
+            double theta = 0.04;    // Long-run variance
+            double xi = 0.5;        // Volatility of the variance
+            double rho = -0.7;      // Correlation of the spot and the variance
+        };
+        
+        // Settings of the methods
+        struct FourierConfig
+        {
+            FourierMethod method = COS;
+            std::size_t points = 4096;  // CARR_MADAN: size of the FFT (a power of 2)
+            double eta = 0.25;          // CARR_MADAN: spacing of the frequencies; log strikes are 2 pi / (points * eta) apart
+            double alpha = 1.5;         // CARR_MADAN: damping exponent of the call price
+            std::size_t terms = 256;    // COS: terms of the cosine series
+            double truncation = 16;     // COS: half-width of the interval of log(S_T / S), in standard deviations
+        };
+        
+        class FourierEngine
+        {
+        private:
+            
+            // Model and settings
+            FourierModel model;
+            HestonParameters heston;
+            FourierConfig config;
+            
+            // Characteristic function E[exp(i u log(S_T / S))] for an expiry
+            std::complex<double> Characteristic(const std::complex<double>& u, const double& T, const double& sig,
+                                                const double& b) const;
+            
+            // Price n options of one expiry (same T, sig, r, b and S) with strikes K and types type
+            void PriceExpiry(const double& T, const double& sig, const double& r, const double& b, const double& S,
+                             const double* K, const char* type, const std::size_t& n, double* price) const;
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            FourierEngine();
+            FourierEngine(const FourierModel& model, const HestonParameters& heston = HestonParameters(),
+                          const FourierConfig& config = FourierConfig());
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the model
+            const FourierModel& get_model() const;
+            
+            // Set the model
+            void set_model(const FourierModel& model);
+            
+            // Get the Heston parameters
+            const HestonParameters& get_heston() const;
+            
+            // Set the Heston parameters
+            // Throw InvalidValueException if kappa or xi is not positive, theta is negative or |rho| > 1
+            void set_heston(const HestonParameters& heston);
+            
+            // Get the settings
+            const FourierConfig& get_config() const;
+            
+            // Set the settings
+            // Throw InvalidValueException if points is not a power of 2 above 4, eta or alpha is not positive,
+            // there are fewer than 2 terms or the truncation is not positive
+            void set_config(const FourierConfig& config);
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Price of one option
+            // Throw InvalidValueException for values the option classes reject
+            double Price(const struct OptionData& data) const;
+            
+            // Prices of a strike chain: the option of data with each strike, in one pass
+            // Throw InvalidValueException for values the option classes reject
+            std::vector<double> Price(const struct OptionData& data, const std::vector<double>& strikes) const;
+            
+            // Prices of the rows of a batch; consecutive rows with the same T, sig, r, b and S are priced in one
+            // pass, so a chain listed expiry by expiry costs one pass per expiry
+            // Throw InvalidValueException for values the option classes reject
+            std::vector<double> Price(const OptionBatch& chain) const;
+            
+            // Same as above, writing the prices to a caller buffer of n values
+            // Throw InvalidSizeException if n is not the size of the batch
+            void Price(const OptionBatch& chain, double* price, const std::size_t& n) const;
+            
+            // Prices of the rows of a matrix of option data, such as GenerateMatrix(data, "K", start, end, step),
+            // all of the given type
+            std::vector<double> Price(const std::vector<std::vector<double>>& matrix, const char& type) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+//  Greeks.hpp
+//  Structures that hold the price and sensitivities of an option
+//  and the mask that selects which of them are calculated.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef Greeks_hpp
+#define Greeks_hpp
+
+#include <vector>
+
+namespace All_Options
+{
+    // Bits selecting the outputs of Greeks()/MatrixGreeks(), combine them with |
+    enum GreekMask
+    {
+        PRICE = 1, DELTA = 2, GAMMA = 4, VEGA = 8, THETA = 16, RHO = 32,
+        ALL_GREEKS = PRICE | DELTA | GAMMA | VEGA | THETA | RHO
+    };
+
+    // Price and sensitivities of one option
+    // Outputs that are not in the mask are left at 0
+    struct OptionGreeks
+    {
+        double price = 0;   // Option price
+        double delta = 0;   // dV/dS
+        double gamma = 0;   // d2V/dS2
+        double vega = 0;    // dV/dsig
+        double theta = 0;   // -dV/dT (time decay per year)
+        double rho = 0;     // dV/dr
+    };
+
+    // Price and sensitivities of a batch of options, one vector per output
+    // Vectors of outputs that are not in the mask are empty
+    struct BatchGreeks
+    {
+        std::vector<double> price;
+        std::vector<double> delta;
+        std::vector<double> gamma;
+        std::vector<double> vega;
+        std::vector<double> theta;
+        std::vector<double> rho;
+    };
+}
+
+#endif
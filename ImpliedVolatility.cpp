@@ -0,0 +1,196 @@
+//  ImpliedVolatility.cpp
+//  Implied volatility of batches of European options.
+//  The search runs on the total volatility v = sig * sqrt(T) of the
+//  out-of-the-money option (a call when K >= F, a put otherwise), with
+//  undiscounted prices, so that deep in-the-money quotes do not lose
+//  their time value in the subtraction of a large intrinsic value.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "ImpliedVolatility.hpp"
+#include "NormalDistribution.hpp"
+#include "Exception.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace All_Options
+{
+    namespace European
+    {
+        // Total volatility above which the price of an option no longer changes in double precision
+        static const double MaxTotalVol = 100.0;
+        
+        static const double Pi = 3.14159265358979323846;
+        
+        // Implied volatility of one option from its price
+        double ImpliedVolatility(const double& price, const double& T, const double& K, const double& r, const double& b,
+                                 const double& S, const char& type, ImpliedVolStatus& status, int& iterations,
+                                 const double& tolerance, const int& max_iterations)
+        {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            iterations = 0;
+            
+            // Check the inputs (NaN fails every comparison)
+            bool call = (type == 'C' || type == 'c');
+            if (!(T > 0) || !(K > 0) || !(S > 0) || !(r >= 0) || !(b >= 0) || !(price >= 0) ||
+                (!call && type != 'P' && type != 'p'))
+            {
+                status = IV_INVALID_INPUT;
+                return nan;
+            }
+            
+            // Undiscounted price and forward
+            double sqrtT = std::sqrt(T);
+            double F = S * std::exp(b * T);
+            double target = price * std::exp(r * T);
+            double w_in = call? 1.0 : -1.0;
+            
+            // No-arbitrage bounds of the quoted option
+            // Quotes within rounding error of the intrinsic value are taken as the intrinsic value
+            double intrinsic = std::max(w_in * (F - K), 0.0);
+            if (target < intrinsic && intrinsic - target <= 8 * std::numeric_limits<double>::epsilon() * (F + K))
+                target = intrinsic;
+            if (target < intrinsic)
+            {
+                status = IV_BELOW_INTRINSIC;
+                return nan;
+            }
+            if (target >= (call? F : K))
+            {
+                status = IV_ABOVE_MAXIMUM;
+                return nan;
+            }
+            
+            // Price of the out-of-the-money option by put-call parity
+            double w = (K >= F)? 1.0 : -1.0;
+            double u = (w == w_in)? target : target - w_in * (F - K);
+            if (u <= 0)
+            {
+                // The quote is its intrinsic value
+                status = IV_CONVERGED;
+                return 0.0;
+            }
+            
+            // Corrado-Miller guess on the undiscounted call price
+            double c = (w > 0)? u : u + (F - K);
+            double half = c - 0.5 * (F - K);
+            double root = half * half - (F - K) * (F - K) / Pi;
+            double v = std::sqrt(2.0 * Pi) / (F + K) * (half + std::sqrt(std::max(root, 0.0)));
+            double x = std::log(F / K);
+            if (!(v > 0) || v > MaxTotalVol)
+                v = std::sqrt(2.0 * std::fabs(x)) + 0.1;
+            
+            // Halley steps inside a bracket [lo, hi] of the root
+            double lo = 0, hi = MaxTotalVol;
+            double step_tol = tolerance * sqrtT;
+            double last_f = std::numeric_limits<double>::infinity();
+            status = IV_NOT_CONVERGED;
+            
+            for (iterations = 1; iterations <= max_iterations; iterations++)
+            {
+                double d1 = x / v + 0.5 * v;
+                double d2 = d1 - v;
+                double f = w * (F * NormalCdf(w * d1, HIGH_ACCURACY) - K * NormalCdf(w * d2, HIGH_ACCURACY)) - u;
+                if (f == 0)
+                {
+                    status = IV_CONVERGED;
+                    break;
+                }
+                
+                // The price increases with v, so the sign of f tells the side of the root
+                if (f > 0) hi = v;
+                else lo = v;
+                
+                // Halley step: f'' / f' = d1 * d2 / v
+                double vega = F * NormalPdf(d1, HIGH_ACCURACY);
+                double next = -1; // outside the bracket unless set below
+                if (vega > 0)
+                {
+                    double h = f / vega;
+                    double denom = 1.0 - 0.5 * h * d1 * d2 / v;
+                    next = (denom > 0.5)? v - h / denom : v - h;
+                    
+                    // A step below the tolerance ends the search, even if rounding puts it on the bracket
+                    if (std::fabs(next - v) <= step_tol)
+                    {
+                        v = next;
+                        status = IV_CONVERGED;
+                        break;
+                    }
+                }
+                
+                // Bisect when the step leaves the bracket or the error did not halve
+                if (!(next > lo && next < hi) || std::fabs(f) > 0.5 * last_f)
+                    next = 0.5 * (lo + hi);
+                last_f = std::fabs(f);
+                
+                v = next;
+                if (hi - lo <= step_tol)
+                {
+                    status = IV_CONVERGED;
+                    break;
+                }
+            }
+            if (iterations > max_iterations)
+                iterations = max_iterations;
+            
+            return v / sqrtT;
+        }
+        
+        
+        // Solve the rows [begin, end) of a batch
+        static void SolveRows(const OptionBatch& batch, const double* price, const double& tolerance, const int& max_iterations,
+                              std::size_t begin, std::size_t end, ImpliedVolResult& result)
+        {
+            const double *T = batch.T(), *K = batch.K(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+            const char* type = batch.type();
+            
+            for (std::size_t i = begin; i < end; i++)
+                result.sig[i] = ImpliedVolatility(price[i], T[i], K[i], r[i], b[i], S[i], type[i],
+                                                  result.status[i], result.iterations[i], tolerance, max_iterations);
+        }
+        
+        // Check the prices and size the result vectors
+        static void PrepareResult(const OptionBatch& batch, const std::vector<double>& price, ImpliedVolResult& result)
+        {
+            if (price.size() != batch.size())
+                throw InvalidSizeException(batch.size(), price.size());
+            
+            result.sig.resize(batch.size());
+            result.status.resize(batch.size());
+            result.iterations.resize(batch.size());
+        }
+        
+        
+        // Take in a batch of option data and the market price of each row and return the implied volatilities
+        ImpliedVolResult MatrixImpliedVol(const OptionBatch& batch, const std::vector<double>& price,
+                                          const double& tolerance, const int& max_iterations)
+        {
+            ImpliedVolResult result;
+            PrepareResult(batch, price, result);
+            SolveRows(batch, price.data(), tolerance, max_iterations, 0, batch.size(), result);
+            return result;
+        }
+        
+        
+        // Same as MatrixImpliedVol, with the batch split in chunks over a pool of threads
+        ImpliedVolResult ParallelMatrixImpliedVol(const OptionBatch& batch, const std::vector<double>& price,
+                                                  const ParallelConfig& config,
+                                                  const double& tolerance, const int& max_iterations)
+        {
+            ImpliedVolResult result;
+            PrepareResult(batch, price, result);
+            
+            // Each chunk solves its own rows
+            auto chunk = [&](std::size_t begin, std::size_t end)
+            { SolveRows(batch, price.data(), tolerance, max_iterations, begin, end, result); };
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            pool.ParallelFor(batch.size(), config.chunk, chunk, config.threads);
+            
+            return result;
+        }
+    }
+}
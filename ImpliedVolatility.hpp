@@ -0,0 +1,61 @@
+//  ImpliedVolatility.hpp
+//  Implied volatility of batches of European options.
+//  Each row starts from the Corrado-Miller rational guess and is refined
+//  with Halley (second order Householder) steps using the analytic vega
+//  and volga, kept inside a bracket that falls back to bisection. The
+//  status of every row is reported instead of throwing.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef ImpliedVolatility_hpp
+#define ImpliedVolatility_hpp
+
+#include <vector>
+#include "OptionBatch.hpp"
+#include "ThreadPool.hpp"
+
+namespace All_Options
+{
+    // Result of the implied volatility search of one row
+    enum ImpliedVolStatus
+    {
+        IV_CONVERGED = 0,       // sig reprices the option within the tolerance
+        IV_BELOW_INTRINSIC = 1, // Price below the discounted intrinsic value, no volatility exists
+        IV_ABOVE_MAXIMUM = 2,   // Price at or above the no-arbitrage upper bound, no volatility exists
+        IV_NOT_CONVERGED = 3,   // Iteration limit reached, sig holds the last iterate
+        IV_INVALID_INPUT = 4    // T, K or S not positive, r or b negative, bad type or price
+    };
+    
+    // Implied volatilities of a batch, one entry per row
+    // sig is NaN for rows without a solution
+    struct ImpliedVolResult
+    {
+        std::vector<double> sig;
+        std::vector<ImpliedVolStatus> status;
+        std::vector<int> iterations;
+    };
+    
+    namespace European // In the European Namespace
+    {
+        // Implied volatility of one option from its price
+        // The status of the search is written to status; sig is NaN when there is no solution
+        double ImpliedVolatility(const double& price, const double& T, const double& K, const double& r, const double& b,
+                                 const double& S, const char& type, ImpliedVolStatus& status, int& iterations,
+                                 const double& tolerance = 1e-10, const int& max_iterations = 100);
+        
+        // Take in a batch of option data and the market price of each row and return the implied volatilities
+        // The sig column of the batch is ignored. tolerance is the accuracy on sig
+        // Throw InvalidSizeException if there is not one price per row
+        ImpliedVolResult MatrixImpliedVol(const OptionBatch& batch, const std::vector<double>& price,
+                                          const double& tolerance = 1e-10, const int& max_iterations = 100);
+        
+        // Same as MatrixImpliedVol, with the batch split in chunks over a pool of threads
+        ImpliedVolResult ParallelMatrixImpliedVol(const OptionBatch& batch, const std::vector<double>& price,
+                                                  const ParallelConfig& config = ParallelConfig(),
+                                                  const double& tolerance = 1e-10, const int& max_iterations = 100);
+    }
+}
+
+#endif
@@ -0,0 +1,332 @@
+//  Lattice.cpp
+//  Binomial and trinomial trees for European and American options.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "Lattice.hpp"
+#include "EuropeanFormula.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    namespace Lattice
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Price Formula////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price when the tree degenerates (T = 0, sig = 0 or S = 0)
+        double LatticeOption::DegeneratePrice(const double& T, const double& K, const double& r, const double& b,
+                                              const double& S, const bool& call, const ExerciseStyle& style)
+        {
+            double w = call? 1.0 : -1.0;
+            bool american = (style == AMERICAN_EXERCISE);
+            
+            // Value today of exercising at t, when the underlying grows at the rate b for sure
+            auto exercise = [&](const double& t) { return std::max(w * (S * exp((b - r) * t) - K * exp(-r * t)), 0.0); };
+            if (!american)
+                return exercise(T);
+            
+            // The exercise value is monotone in t but at t* where (r - b) S exp(b t*) = r K
+            double best = std::max(exercise(0), exercise(T));
+            if (b != 0 && S > 0 && r * K / ((r - b) * S) > 0)
+            {
+                double t = log(r * K / ((r - b) * S)) / b;
+                if (t > 0 && t < T)
+                    best = std::max(best, exercise(t));
+            }
+            return best;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////Private Price Calculator/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price of one tree of n steps for factors indexed by Factor
+        double LatticeOption::Tree(const double (&f)[6], const std::size_t& n, const bool& smooth) const
+        {
+            const double &T = f[0], &K = f[1], &sig = f[2], &r = f[3], &b = f[4], &S = f[5];
+            bool call = (data.optType == 'C'), american = (style == AMERICAN_EXERCISE);
+            bool trinomial = (config.type == TRINOMIAL);
+            double w = call? 1.0 : -1.0;
+            
+            // Step h in log(S) and discounted probabilities of moving up, staying and moving down
+            double dt = T / n, disc = exp(-r * dt), h, pu, pm, pd;
+            if (trinomial)
+            {
+                h = sig * sqrt(3 * dt);
+                double nu = b - 0.5 * sig * sig;
+                double a = (sig * sig * dt + nu * nu * dt * dt) / (h * h), c = nu * dt / h;
+                pu = disc * 0.5 * (a + c);
+                pm = disc * (1 - a);
+                pd = disc * 0.5 * (a - c);
+            }
+            else
+            {
+                h = sig * sqrt(dt);
+                double u = exp(h), d = exp(-h), p = (exp(b * dt) - d) / (u - d);
+                pu = disc * p;
+                pm = 0;
+                pd = disc * (1 - p);
+            }
+            
+            // Spots S * exp(k * h) for k = -n .. n, at power[n + k]
+            value.resize(2 * n + 1);
+            power.resize(2 * n + 1);
+            for (std::size_t k = 0; k <= 2 * n; k++)
+                power[k] = S * exp((static_cast<double>(k) - static_cast<double>(n)) * h);
+            
+            // Node i of step j is at k = 2i - j (binomial, j + 1 nodes) or k = i - j (trinomial, 2j + 1 nodes),
+            // so its spot is power[n - j + stride * i]
+            std::size_t stride = trinomial? 1 : 2;
+            
+            // Values at expiry, or one step before it for BBS
+            std::size_t last = smooth? n - 1 : n;
+            std::size_t nodes = trinomial? 2 * last + 1 : last + 1;
+            const double* s = power.data() + (n - last);
+            for (std::size_t i = 0; i < nodes; i++)
+            {
+                double exercise = std::max(w * (s[stride * i] - K), 0.0);
+                if (!smooth)
+                {
+                    value[i] = exercise;
+                    continue;
+                }
+                value[i] = call? European::EuropeanFormula<1, CARRY_GENERAL>::Price(dt, K, sig, r, b, s[stride * i], HIGH_ACCURACY)
+                               : European::EuropeanFormula<-1, CARRY_GENERAL>::Price(dt, K, sig, r, b, s[stride * i], HIGH_ACCURACY);
+                if (american)
+                    value[i] = std::max(value[i], exercise);
+            }
+            
+            // Roll back in place: node i of step j only reads nodes i and above of step j + 1
+            for (std::size_t j = last; j-- > 0;)
+            {
+                nodes = trinomial? 2 * j + 1 : j + 1;
+                s = power.data() + (n - j);
+                for (std::size_t i = 0; i < nodes; i++)
+                {
+                    double v = trinomial? pd * value[i] + pm * value[i + 1] + pu * value[i + 2]
+                                        : pd * value[i] + pu * value[i + 1];
+                    value[i] = american? std::max(v, w * (s[stride * i] - K)) : v;
+                }
+            }
+            return value[0];
+        }
+        
+        // Calculate the price for factors indexed by Factor, with the smoothing of the settings
+        double LatticeOption::Calculate(const double (&f)[6]) const
+        {
+            if (f[0] == 0 || f[2] == 0 || f[5] == 0)
+                return DegeneratePrice(f[0], f[1], f[3], f[4], f[5], data.optType == 'C', style);
+            
+            switch (config.smoothing)
+            {
+                case NO_SMOOTHING: return Tree(f, config.steps, false);
+                case BBS:          return Tree(f, config.steps, true);
+                default:           return 2 * Tree(f, config.steps, true) - Tree(f, config.steps / 2, true);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Constructors/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Default LatticeOption constructor
+        LatticeOption::LatticeOption(): Option(), style(AMERICAN_EXERCISE), config() {}
+        
+        // Copy option
+        LatticeOption::LatticeOption(const LatticeOption& o2): Option(o2), style(o2.style), config(o2.config) {}
+        
+        // Create an option of certain type
+        LatticeOption::LatticeOption(const char& optionType, const ExerciseStyle& s, const LatticeConfig& c)
+        : Option(optionType), style(s), config()
+        {
+            set_config(c);
+        }
+        
+        // Create an option using given data
+        LatticeOption::LatticeOption(const struct OptionData& data, const ExerciseStyle& s, const LatticeConfig& c)
+        : Option(data), style(s), config()
+        {
+            set_config(c);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        LatticeOption::~LatticeOption() {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Operators/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Assignment operator
+        LatticeOption& LatticeOption::operator = (const LatticeOption& option2)
+        {
+            // Return original objects if addresses are the same
+            if (this == &option2) return *this;
+            
+            Option::operator = (option2);
+            style = option2.style;
+            config = option2.config;
+            return *this;
+        }
+        
+        // Get the information of the object using <<
+        std::ostream& operator << (std::ostream& os, const LatticeOption& op)
+        {
+            // Get the description from ToString() function
+            os << op.ToString();
+            return os;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the exercise style
+        const ExerciseStyle& LatticeOption::get_style() const
+        {
+            return style;
+        }
+        
+        // Set the exercise style
+        void LatticeOption::set_style(const ExerciseStyle& s)
+        {
+            style = s;
+        }
+        
+        // Get the tree settings
+        const LatticeConfig& LatticeOption::get_config() const
+        {
+            return config;
+        }
+        
+        // Set the tree settings
+        void LatticeOption::set_config(const LatticeConfig& c)
+        {
+            if (c.steps < ((c.smoothing == BBS_RICHARDSON)? 2u : 1u))
+                throw InvalidValueException();
+            config = c;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the price of the option
+        double LatticeOption::Price() const
+        {
+            double f[6];
+            FactorArray(f);
+            return Calculate(f);
+        }
+        
+        // Given a factor name and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double LatticeOption::Price(std::string factor, const double& value) const
+        {
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor name and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> LatticeOption::Price
+        (std::string factor, const double& start, const double& end, const double& step) const
+        {
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double LatticeOption::Price(const Factor& factor, const double& value) const
+        {
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
+            
+            // Check if the values of parameter are valid
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
+            
+            return Calculate(f);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> LatticeOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            // Create a vector that will store prices of different option parameters
+            std::vector<double> price_vec(SweepSize(start, end, step));
+            Price(factor, start, end, step, price_vec.data(), price_vec.size());
+            return price_vec;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void LatticeOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffer are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the input factor
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
+            
+            // Use to determine whether the varying parameter is increasing or decreasing
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            
+            // Loop over varying options, every tree on the same buffers
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                // Change the value corresponding to the input factor
+                x = i;
+                
+                // Get the price and put it in the buffer
+                price[row] = Calculate(f);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        std::string LatticeOption::ToString() const
+        {
+            // Create a stringstream
+            std::stringstream str;
+            
+            // Put the content from Options to the stringstream
+            str << ((style == AMERICAN_EXERCISE)? "American" : "European") << " Option (" << TypeName(config.type)
+                << " tree, " << config.steps << " steps)\n" << Option::ToString();
+            return str.str();
+        }
+        
+        // Name of a tree
+        std::string TypeName(const LatticeType& type)
+        {
+            return (type == TRINOMIAL)? "trinomial" : "binomial";
+        }
+    }
+}
@@ -0,0 +1,217 @@
+//  MonteCarlo.cpp
+//  Monte Carlo engine for European options.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "MonteCarlo.hpp"
+#include "EuropeanOption.hpp"
+#include "OptionMatrix.hpp"
+#include "Exception.hpp"
+#include "NormalDistribution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Reduction/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price and standard error of a run from the moments of its blocks, merged in order
+        MonteCarloResult Summarize(const std::vector<SampleMoments>& blocks, const std::size_t& replications,
+                                   const double& mean_c, const MonteCarloConfig& config, const std::size_t& samples)
+        {
+            MonteCarloResult result;
+            std::size_t blocks_per_replication = blocks.size() / replications;
+            
+            // Merge the blocks of a replication in order; the replications are merged again for their spread
+            // instead of being kept, so that nothing is allocated
+            auto replication = [&](const std::size_t& q)
+            {
+                SampleMoments moments;
+                for (std::size_t k = q * blocks_per_replication; k < (q + 1) * blocks_per_replication; k++)
+                    moments.Merge(blocks[k]);
+                return moments;
+            };
+            SampleMoments total;
+            for (std::size_t q = 0; q < replications; q++)
+                total.Merge(replication(q));
+            
+            // Control variate estimate with the coefficient fitted on all samples
+            result.beta = (config.control != NO_CONTROL && total.cc > 0)? total.yc / total.cc : 0.0;
+            result.price = total.y - result.beta * (total.c - mean_c);
+            result.paths = config.antithetic? 2 * samples : samples;
+            
+            if (config.source != SOBOL)
+            {
+                // Variance of the payoff left after the control
+                if (total.n > 1)
+                    result.standard_error = sqrt(std::max(total.yy - result.beta * total.yc, 0.0) / (total.n - 1) / total.n);
+            }
+            else if (replications > 1)
+            {
+                // Spread of the estimates of the replications
+                // (they have the same size, so their mean is the price)
+                double variance = 0;
+                for (std::size_t q = 0; q < replications; q++)
+                {
+                    SampleMoments moments = replication(q);
+                    double estimate = moments.y - result.beta * (moments.c - mean_c);
+                    variance += (estimate - result.price) * (estimate - result.price);
+                }
+                result.standard_error = sqrt(variance / (replications - 1) / replications);
+            }
+            return result;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        MonteCarloEngine::MonteCarloEngine(): config(MonteCarloConfig()) {}
+        
+        MonteCarloEngine::MonteCarloEngine(const MonteCarloConfig& c): config()
+        {
+            set_config(c);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the settings
+        const MonteCarloConfig& MonteCarloEngine::get_config() const
+        {
+            return config;
+        }
+        
+        // Change the settings
+        void MonteCarloEngine::set_config(const MonteCarloConfig& c)
+        {
+            if (c.paths == 0 || c.block == 0)
+                throw InvalidValueException();
+            config = c;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price of a European option and its standard error
+        MonteCarloResult MonteCarloEngine::Price(const struct OptionData& data, const ParallelConfig& parallel) const
+        {
+            // Same checks as the option classes
+            CheckOption(data, false);
+            if (data.optType != 'C' && data.optType != 'P')
+                throw InvalidOptionTypeException(data.optType);
+            if (config.control == GEOMETRIC_ASIAN_CONTROL)
+                throw InvalidValueException();
+            
+            const double &T = data.T, &K = data.K, &S = data.S;
+            double w = (data.optType == 'C')? 1.0 : -1.0;
+            double df = exp(-data.r * T);
+            
+            // Without randomness the terminal price is the forward
+            if (T == 0 || data.sig == 0)
+            {
+                MonteCarloResult result;
+                result.price = df * std::max(w * (S * exp(data.b * T) - K), 0.0);
+                return result;
+            }
+            
+            // Terminal price S * exp(drift + vol * z) and mean of the control
+            double drift = (data.b - 0.5 * data.sig * data.sig) * T, vol = data.sig * sqrt(T);
+            double mean_c = 0;
+            if (config.control == UNDERLYING_CONTROL)
+                mean_c = S * exp((data.b - data.r) * T);
+            else if (config.control == EUROPEAN_CONTROL)
+                mean_c = European::EuropeanOption(data).Price();
+            
+            // Discounted payoff and control of one normal number
+            auto sample = [&](const double& z, double& y, double& c)
+            {
+                double ST = S * exp(drift + vol * z);
+                y = df * std::max(w * (ST - K), 0.0);
+                c = (config.control == UNDERLYING_CONTROL)? df * ST : (config.control == EUROPEAN_CONTROL)? y : 0.0;
+            };
+            
+            // One sample is a pair of paths with antithetic variates; a Sobol run is cut into replications
+            // of the same size, each cut into blocks
+            bool sobol = (config.source == SOBOL);
+            std::size_t samples = config.antithetic? (config.paths + 1) / 2 : config.paths;
+            std::size_t replications = sobol? std::max<std::size_t>(config.replications, 1) : 1;
+            std::size_t per_replication = (samples + replications - 1) / replications;
+            std::size_t blocks_per_replication = (per_replication + config.block - 1) / config.block;
+            std::vector<SampleMoments> moments(replications * blocks_per_replication);
+            
+            std::uint32_t key[2] = { static_cast<std::uint32_t>(config.seed), static_cast<std::uint32_t>(config.seed >> 32) };
+            
+            // Every block only depends on its index, so the blocks can run on any thread in any order
+            auto chunk = [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    std::size_t replication = k / blocks_per_replication;
+                    std::size_t first = (k % blocks_per_replication) * config.block;
+                    std::size_t last = std::min(first + config.block, per_replication);
+                    SampleMoments m;
+                    
+                    // Digital shift of the replication
+                    std::uint32_t shift = 0;
+                    SobolSequence sequence(1);
+                    if (sobol)
+                    {
+                        std::uint32_t counter[4] = { static_cast<std::uint32_t>(replication), 0, 0, 1 }, bits[4];
+                        Philox::Block(counter, key, bits);
+                        shift = bits[0];
+                        sequence.Seek(first);
+                    }
+                    
+                    // Philox gives the numbers of two samples per counter: sample i uses the words 2 (i % 2) and
+                    // 2 (i % 2) + 1 of counter i / 2, so a sample still only depends on its index
+                    std::uint32_t bits[4];
+                    for (std::size_t i = first; i < last; i++)
+                    {
+                        double u;
+                        if (sobol)
+                            u = SobolSequence::Uniform(sequence.Next()[0], shift);
+                        else
+                        {
+                            std::size_t half = i / 2, pair = 2 * (i % 2);
+                            if (i == first || pair == 0)
+                            {
+                                std::uint32_t counter[4] = { static_cast<std::uint32_t>(half),
+                                                             static_cast<std::uint32_t>(static_cast<std::uint64_t>(half) >> 32), 0, 0 };
+                                Philox::Block(counter, key, bits);
+                            }
+                            u = Philox::Uniform(bits[pair], bits[pair + 1]);
+                        }
+                        
+                        double z = InverseNormalCdf(u), y, c;
+                        sample(z, y, c);
+                        if (config.antithetic)
+                        {
+                            double y2, c2;
+                            sample(-z, y2, c2);
+                            y = 0.5 * (y + y2);
+                            c = 0.5 * (c + c2);
+                        }
+                        m.Add(y, c);
+                    }
+                    moments[k] = m;
+                }
+            };
+            ThreadPool& pool = parallel.pool? *parallel.pool : ThreadPool::Shared();
+            pool.ParallelFor(moments.size(), 1, chunk, parallel.threads);
+            
+            // Rounding per_replication up can simulate a few more samples than asked for
+            MonteCarloResult result = Summarize(moments, replications, mean_c, config, replications * per_replication);
+            return result;
+        }
+    }
+}
@@ -0,0 +1,143 @@
+//  MonteCarlo.hpp
+//  Monte Carlo engine for European options. The terminal price is
+//  sampled exactly under Black-Scholes from Philox random numbers or a
+//  randomly shifted Sobol sequence, with antithetic variates and a
+//  control variate (the discounted underlying, or the European payoff
+//  priced by EuropeanOption). The samples are cut into blocks of a
+//  fixed size whose moments are merged in block order, so the price and
+//  its standard error are the same whatever the number of threads.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef MonteCarlo_hpp
+#define MonteCarlo_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "OptionData.hpp"
+#include "ThreadPool.hpp"
+#include "RandomNumbers.hpp"
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        // Sources of the normal numbers
+        // PSEUDO_RANDOM: Philox4x32-10, the standard error comes from the sample variance
+        // SOBOL: Sobol sequence with a random digital shift per replication, the standard error comes from
+        // the spread of the replications
+        enum RandomSource { PSEUDO_RANDOM = 0, SOBOL = 1 };
+        
+        // Control variates
+        // UNDERLYING_CONTROL: the discounted terminal price, whose mean is S * exp((b - r) * T)
+        // EUROPEAN_CONTROL: the discounted European payoff, priced in closed form by EuropeanOption
+        // (for a European option it is the payoff itself, so the estimate is the closed-form price;
+        // it is meant for payoffs close to the European one, such as barriers)
+        // GEOMETRIC_ASIAN_CONTROL: the discounted geometric average payoff on the fixing dates, priced in
+        // closed form by PathDependentOption::GeometricAsianPrice (path payoffs only)
+        enum ControlVariate { NO_CONTROL = 0, UNDERLYING_CONTROL = 1, EUROPEAN_CONTROL = 2, GEOMETRIC_ASIAN_CONTROL = 3 };
+        
+        // Simulation settings
+        struct MonteCarloConfig
+        {
+            std::size_t paths = 1 << 20;                // Paths simulated (with antithetic variates, half are mirrored)
+            std::uint64_t seed = 20181105;              // Key of the random numbers and the shifts
+            RandomSource source = PSEUDO_RANDOM;        // Philox or Sobol
+            bool antithetic = true;                     // Pair every normal number z with -z
+            ControlVariate control = UNDERLYING_CONTROL; // Control variate
+            std::size_t replications = 16;              // Shifted copies of the Sobol sequence (at least 2 for an error)
+            std::size_t block = 8192;                   // Samples per block, the unit of work of a thread
+            std::size_t steps = 12;                     // Equally spaced fixing or monitoring dates of path payoffs
+        };
+        
+        // Price and standard error of a simulation
+        struct MonteCarloResult
+        {
+            double price = 0;           // Estimate of the price
+            double standard_error = 0;  // Standard error of the estimate
+            std::size_t paths = 0;      // Paths simulated (config.paths rounded up to whole pairs and replications)
+            double beta = 0;            // Coefficient of the control variate (0 without one)
+        };
+        
+        // Count, means and centered co-moments of the payoff y and the control c over a set of samples
+        struct SampleMoments
+        {
+            double n = 0;
+            double y = 0;
+            double c = 0;
+            double yy = 0;
+            double cc = 0;
+            double yc = 0;
+            
+            // Add one sample (Welford's update)
+            void Add(const double& sample_y, const double& sample_c)
+            {
+                n += 1;
+                double dy = sample_y - y, dc = sample_c - c;
+                y += dy / n;
+                c += dc / n;
+                yy += dy * (sample_y - y);
+                cc += dc * (sample_c - c);
+                yc += dy * (sample_c - c);
+            }
+            
+            // Merge the moments of another set of samples (Chan's update)
+            void Merge(const SampleMoments& other)
+            {
+                if (other.n == 0) return;
+                double total = n + other.n, dy = other.y - y, dc = other.c - c, f = n * other.n / total;
+                y += dy * other.n / total;
+                c += dc * other.n / total;
+                yy += other.yy + dy * dy * f;
+                cc += other.cc + dc * dc * f;
+                yc += other.yc + dy * dc * f;
+                n = total;
+            }
+        };
+        
+        // Price and standard error of a run from the moments of its blocks, merged in order
+        // The blocks are split evenly between the replications (one unless the source is SOBOL); the price uses
+        // the control with mean mean_c and a coefficient fitted on all the samples; samples is the number of samples
+        // simulated (pairs of paths with antithetic variates), which gives result.paths
+        MonteCarloResult Summarize(const std::vector<SampleMoments>& blocks, const std::size_t& replications,
+                                   const double& mean_c, const MonteCarloConfig& config, const std::size_t& samples);
+        
+        class MonteCarloEngine
+        {
+        private:
+            
+            // Simulation settings
+            MonteCarloConfig config;
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            MonteCarloEngine();
+            MonteCarloEngine(const MonteCarloConfig& config);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the settings
+            const MonteCarloConfig& get_config() const;
+            
+            // Change the settings
+            // Throw InvalidValueException if there are no paths or the block is empty
+            void set_config(const MonteCarloConfig& config);
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Price of a European option and its standard error, with the blocks split over a pool of threads
+            // (parallel.chunk is not used: a thread takes one block at a time)
+            // Options with T = 0 or sig = 0 are priced exactly, with a standard error of 0
+            // Throw InvalidValueException for values the option classes reject or a GEOMETRIC_ASIAN_CONTROL,
+            // and InvalidOptionTypeException if the type is not 'C' or 'P'
+            MonteCarloResult Price(const struct OptionData& data, const ParallelConfig& parallel = ParallelConfig()) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,208 @@
+//  NormalDistribution.cpp
+//  Standard normal CDF and PDF with a selectable accuracy.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "NormalDistribution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <boost/math/distributions/normal.hpp>
+
+namespace All_Options
+{
+    // Standard normal distribution shared by the EXACT mode
+    static const boost::math::normal_distribution<> Normal;
+    
+    // Standard normal CDF from std::erfc (relative error about 1e-16), used by the bivariate and inverse CDF
+    static double ErfcCdf(const double& x)
+    {
+        return 0.5 * std::erfc(-x * 0.70710678118654752440);
+    }
+    
+    // Standard normal CDF by Hart's rational approximation, the algorithm of the vectorized kernel
+    // (SimdKernel.inl) with the same coefficients and the same continued fraction for the far tail
+    static double HartCdf(const double& x)
+    {
+        double a = std::fabs(x);
+        if (a > 37)
+            return (x > 0)? 1.0 : 0.0;
+        double e = std::exp(-0.5 * a * a);
+        
+        double tail;
+        if (a < 7.07106781186547)
+        {
+            double num = ((((((3.52624965998911e-02 * a + 0.700383064443688) * a + 6.37396220353165) * a
+                           + 33.912866078383) * a + 112.079291497871) * a + 221.213596169931) * a + 220.206867912376);
+            double den = (((((((8.83883476483184e-02 * a + 1.75566716318264) * a + 16.064177579207) * a
+                            + 86.7807322029461) * a + 296.564248779674) * a + 637.333633378831) * a
+                          + 793.826512519948) * a + 440.413735824752);
+            tail = e * num / den;
+        }
+        else
+        {
+            double c = a + 0.65;
+            c = a + 4.0 / c;
+            c = a + 3.0 / c;
+            c = a + 2.0 / c;
+            c = a + 1.0 / c;
+            tail = e / (c * 2.506628274631);
+        }
+        return (x > 0)? 1.0 - tail : tail;
+    }
+    
+    // Cumulative distribution function of the standard normal distribution
+    double NormalCdf(const double& x, const NormalMode& mode)
+    {
+        switch (mode)
+        {
+            case HIGH_ACCURACY:
+                return HartCdf(x);
+                
+            case FAST:
+            {
+                // Abramowitz-Stegun 26.2.17 on |x|, reflected for x > 0
+                double a = std::fabs(x);
+                double t = 1.0 / (1.0 + 0.2316419 * a);
+                double poly = t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 + t * (-1.821255978 + t * 1.330274429))));
+                double tail = 0.39894228040143267794 * std::exp(-0.5 * a * a) * poly;
+                return (x > 0)? 1.0 - tail : tail;
+            }
+                
+            default:
+                return boost::math::cdf(Normal, x);
+        }
+    }
+    
+    // Density function of the standard normal distribution
+    double NormalPdf(const double& x, const NormalMode& mode)
+    {
+        if (mode == EXACT)
+            return boost::math::pdf(Normal, x);
+        return 0.39894228040143267794 * std::exp(-0.5 * x * x);
+    }
+    
+    // Cumulative distribution function of the standard bivariate normal distribution with correlation rho
+    // Genz's BVND computes P(X > h, Y > k), so P(X < x, Y < y) is BVND(-x, -y, rho)
+    double BivariateNormalCdf(const double& x, const double& y, const double& rho)
+    {
+        // Gauss-Legendre abscissae (negative half) and weights with 6, 12 and 20 points
+        static const double W[3][10] = {
+            { 0.1713244923791705, 0.3607615730481384, 0.4679139345726904 },
+            { 0.04717533638651177, 0.1069393259953183, 0.1600783285433464, 0.2031674267230659,
+              0.2334925365383547, 0.2491470458134029 },
+            { 0.01761400713915212, 0.04060142980038694, 0.06267204833410906, 0.08327674157670475,
+              0.1019301198172404, 0.1181945319615184, 0.1316886384491766, 0.1420961093183821,
+              0.1491729864726037, 0.1527533871307259 } };
+        static const double X[3][10] = {
+            { -0.9324695142031522, -0.6612093864662647, -0.2386191860831970 },
+            { -0.9815606342467191, -0.9041172563704750, -0.7699026741943050, -0.5873179542866171,
+              -0.3678314989981802, -0.1252334085114692 },
+            { -0.9931285991850949, -0.9639719272779138, -0.9122344282513259, -0.8391169718222188,
+              -0.7463319064601508, -0.6360536807265150, -0.5108670019508271, -0.3737060887154196,
+              -0.2277858511416451, -0.07652652113349733 } };
+        const double twopi = 6.283185307179586;
+        
+        // More points as |rho| grows
+        int ng, lg;
+        if (std::fabs(rho) < 0.3) { ng = 0; lg = 3; }
+        else if (std::fabs(rho) < 0.75) { ng = 1; lg = 6; }
+        else { ng = 2; lg = 10; }
+        
+        double h = -x, k = -y, hk = h * k, bvn = 0;
+        
+        if (std::fabs(rho) < 0.925)
+        {
+            double hs = (h * h + k * k) / 2, asr = std::asin(rho);
+            for (int i = 0; i < lg; i++)
+            {
+                double sn = std::sin(asr * (X[ng][i] + 1) / 2);
+                bvn += W[ng][i] * std::exp((sn * hk - hs) / (1 - sn * sn));
+                sn = std::sin(asr * (-X[ng][i] + 1) / 2);
+                bvn += W[ng][i] * std::exp((sn * hk - hs) / (1 - sn * sn));
+            }
+            return bvn * asr / (2 * twopi) + ErfcCdf(-h) * ErfcCdf(-k);
+        }
+        
+        // |rho| close to 1: integrate the difference from the perfectly correlated case
+        if (rho < 0) { k = -k; hk = -hk; }
+        if (std::fabs(rho) < 1)
+        {
+            double as = (1 - rho) * (1 + rho), a = std::sqrt(as), bs = (h - k) * (h - k);
+            double c = (4 - hk) / 8, d = (12 - hk) / 16;
+            bvn = a * std::exp(-(bs / as + hk) / 2) * (1 - c * (bs - as) * (1 - d * bs / 5) / 3 + c * d * as * as / 5);
+            if (hk > -160)
+            {
+                double b = std::sqrt(bs);
+                bvn -= std::exp(-hk / 2) * std::sqrt(twopi) * ErfcCdf(-b / a) * b
+                       * (1 - c * bs * (1 - d * bs / 5) / 3);
+            }
+            a /= 2;
+            for (int i = 0; i < lg; i++)
+            {
+                double xs = (a * (X[ng][i] + 1)) * (a * (X[ng][i] + 1));
+                double rs = std::sqrt(1 - xs);
+                bvn += a * W[ng][i] * (std::exp(-bs / (2 * xs) - hk / (1 + rs)) / rs
+                                       - std::exp(-(bs / xs + hk) / 2) * (1 + c * xs * (1 + d * xs)));
+                xs = as * (-X[ng][i] + 1) * (-X[ng][i] + 1) / 4;
+                rs = std::sqrt(1 - xs);
+                bvn += a * W[ng][i] * std::exp(-(bs / xs + hk) / 2)
+                       * (std::exp(-hk * xs / (2 * (1 + rs) * (1 + rs))) / rs - (1 + c * xs * (1 + d * xs)));
+            }
+            bvn = -bvn / twopi;
+        }
+        if (rho > 0)
+            return bvn + ErfcCdf(-std::max(h, k));
+        return -bvn + std::max(0.0, ErfcCdf(-h) - ErfcCdf(-k));
+    }
+    
+    // Inverse of the standard normal CDF (Acklam's approximation, relative error 1.15e-9, and one Halley step)
+    double InverseNormalCdf(const double& p)
+    {
+        static const double a[6] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                     1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+        static const double b[5] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                     6.680131188771972e+01, -1.328068155288572e+01 };
+        static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                     -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+        static const double d[4] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                     3.754408661907416e+00 };
+        const double low = 0.02425;
+        
+        if (p <= 0) return -HUGE_VAL;
+        if (p >= 1) return HUGE_VAL;
+        
+        // Rational approximation on the lower tail, the central region and the upper tail
+        double x;
+        if (p < low || p > 1 - low)
+        {
+            double q = std::sqrt(-2 * std::log((p < low)? p : 1 - p));
+            x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+            if (p > low) x = -x;
+        }
+        else
+        {
+            double q = p - 0.5, t = q * q;
+            x = (((((a[0] * t + a[1]) * t + a[2]) * t + a[3]) * t + a[4]) * t + a[5]) * q /
+                (((((b[0] * t + b[1]) * t + b[2]) * t + b[3]) * t + b[4]) * t + 1);
+        }
+        
+        // One Halley step on N(x) - p
+        double e = ErfcCdf(x) - p;
+        double u = e * 2.50662827463100050242 * std::exp(0.5 * x * x);
+        return x - u / (1 + 0.5 * x * u);
+    }
+    
+    // Name of an accuracy mode
+    std::string NormalModeName(const NormalMode& mode)
+    {
+        switch (mode)
+        {
+            case HIGH_ACCURACY: return "High accuracy";
+            case FAST:          return "Fast";
+            default:            return "Exact";
+        }
+    }
+}
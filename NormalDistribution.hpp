@@ -0,0 +1,43 @@
+//  NormalDistribution.hpp
+//  Standard normal CDF and PDF with a selectable accuracy.
+//  EXACT is boost::math (the original behaviour of the library),
+//  HIGH_ACCURACY uses Hart's double precision rational approximation,
+//  the same algorithm as the vectorized kernel (absolute error about
+//  2e-16 against std::erfc), and FAST uses the Abramowitz-Stegun
+//  polynomial 26.2.17 (absolute error below 7.5e-8) with one exp and
+//  one division.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef NormalDistribution_hpp
+#define NormalDistribution_hpp
+
+#include <string>
+
+namespace All_Options
+{
+    // Accuracy modes of the normal distribution
+    enum NormalMode { EXACT = 0, HIGH_ACCURACY = 1, FAST = 2 };
+    
+    // Cumulative distribution function of the standard normal distribution
+    double NormalCdf(const double& x, const NormalMode& mode = EXACT);
+    
+    // Density function of the standard normal distribution
+    double NormalPdf(const double& x, const NormalMode& mode = EXACT);
+    
+    // Cumulative distribution function of the standard bivariate normal distribution with correlation rho,
+    // P(X < x, Y < y), by Genz's method (Gauss-Legendre quadrature of Drezner-Wesolowsky's integral,
+    // absolute error about 1e-15)
+    double BivariateNormalCdf(const double& x, const double& y, const double& rho);
+    
+    // Inverse of the standard normal CDF for p in (0, 1), by Acklam's rational approximation refined by one
+    // Halley step on std::erfc (relative error about 1e-15); returns -/+ infinity for p = 0 or 1
+    double InverseNormalCdf(const double& p);
+    
+    // Name of an accuracy mode
+    std::string NormalModeName(const NormalMode& mode);
+}
+
+#endif
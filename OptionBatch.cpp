@@ -0,0 +1,254 @@
+//  OptionBatch.cpp
+//  Contiguous, column-major storage for a batch of options.
+//  Each factor (T, K, sig, r, b, S) and the option type live in their
+//  own aligned column, so batch functions can stream through a whole
+//  column instead of chasing one heap allocation per row.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "OptionBatch.hpp"
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace All_Options
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Memory Management/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Allocate aligned columns for n rows
+    void OptionBatch::Allocate(std::size_t n)
+    {
+        rows = n;
+
+        // Round the column length up so that every column starts on an aligned address
+        const std::size_t per_line = Alignment / sizeof(double);
+        stride = (n + per_line - 1) / per_line * per_line;
+
+        if (n == 0)
+        {
+            buffer = 0;
+            types = 0;
+            return;
+        }
+
+        // Over-allocate and keep the original pointer right before the aligned block
+        std::size_t bytes = 6 * stride * sizeof(double) + stride;
+        char* raw = static_cast<char*>(::operator new(bytes + Alignment + sizeof(void*)));
+        std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+        std::uintptr_t aligned = (start + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+
+        buffer = reinterpret_cast<double*>(aligned);
+        types = reinterpret_cast<char*>(buffer + 6 * stride);
+    }
+
+    // Free the columns
+    void OptionBatch::Release()
+    {
+        if (buffer != 0)
+            ::operator delete(reinterpret_cast<void**>(buffer)[-1]);
+        buffer = 0;
+        types = 0;
+        rows = 0;
+        stride = 0;
+    }
+
+    // Pointer to the start of the i-th factor column
+    double* OptionBatch::Column(std::size_t i) const
+    {
+        return buffer + i * stride;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Constructors////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Default Constructor (empty batch)
+    OptionBatch::OptionBatch(): buffer(0), types(0), rows(0), stride(0) {}
+
+    // Create a batch of n rows with all factors set to 0 and the given option type
+    OptionBatch::OptionBatch(std::size_t n, const char& type)
+    {
+        Allocate(n);
+        if (n == 0) return;
+        std::memset(buffer, 0, 6 * stride * sizeof(double));
+        std::memset(types, toupper(type), rows);
+    }
+
+    // Copy Constructor
+    OptionBatch::OptionBatch(const OptionBatch& source)
+    {
+        Allocate(source.rows);
+        if (rows == 0) return;
+        std::memcpy(buffer, source.buffer, 6 * stride * sizeof(double) + stride);
+    }
+
+    // Move Constructor
+    OptionBatch::OptionBatch(OptionBatch&& source):
+    buffer(source.buffer), types(source.types), rows(source.rows), stride(source.stride)
+    {
+        source.buffer = 0; source.types = 0; source.rows = 0; source.stride = 0;
+    }
+
+    // Create a batch from a vector of OptionData structures
+    OptionBatch::OptionBatch(const std::vector<struct OptionData>& batches)
+    {
+        Allocate(batches.size());
+        for (std::size_t i = 0; i < rows; i++)
+            set_row(i, batches[i]);
+    }
+
+    // Create a batch from a matrix of option data (rows of T, K, sig, r, b, S)
+    OptionBatch::OptionBatch(const std::vector<std::vector<double>>& matrix, const char& type)
+    {
+        Allocate(matrix.size());
+
+        // Scatter each row into the columns
+        for (std::size_t i = 0; i < rows; i++)
+        {
+            for (std::size_t j = 0; j < 6; j++)
+                Column(j)[i] = matrix[i][j];
+            types[i] = toupper(type);
+        }
+    }
+
+    // Create a batch from one OptionData structure by varying one factor
+    OptionBatch::OptionBatch(const struct OptionData& source, const std::string& factor,
+                             const double& start, const double& end, const double& step)
+    : OptionBatch(source, ParseFactor(factor), start, end, step) {}
+
+    // Create a batch from one OptionData structure by varying one factor
+    OptionBatch::OptionBatch(const struct OptionData& source, const Factor& factor,
+                             const double& start, const double& end, const double& step)
+    {
+        // Check range and step
+        if (((end - start) < 0 && step >= 0) || ((end - start) > 0 && step <= 0) || step == 0)
+            throw InvalidStepException(step, start, end);
+
+        // Record whether the varying parameter is increasing or decreasing
+        int direction = (end > start)? 1:-1;
+
+        // Count the rows with the same accumulation the fill loop uses
+        std::size_t n = 0;
+        for (double i = start; (i - end) * direction <= 0; i += step)
+            n++;
+
+        Allocate(n);
+
+        // Fill every row with the source data
+        for (std::size_t i = 0; i < rows; i++)
+            set_row(i, source);
+
+        // Overwrite the varying factor
+        double* col = Column(static_cast<std::size_t>(factor));
+        std::size_t row = 0;
+        for (double i = start; (i - end) * direction <= 0; i += step)
+            col[row++] = i;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Destructor//////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    OptionBatch::~OptionBatch()
+    {
+        Release();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////Operators/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Assignment operator
+    OptionBatch& OptionBatch::operator = (const OptionBatch& source)
+    {
+        // Check whether the address of the two objects are the same. If same, return itself
+        if (this == &source) return *this;
+
+        Release();
+        Allocate(source.rows);
+        if (rows != 0)
+            std::memcpy(buffer, source.buffer, 6 * stride * sizeof(double) + stride);
+
+        return *this;
+    }
+
+    // Move assignment operator
+    OptionBatch& OptionBatch::operator = (OptionBatch&& source)
+    {
+        if (this == &source) return *this;
+
+        Release();
+        buffer = source.buffer; types = source.types; rows = source.rows; stride = source.stride;
+        source.buffer = 0; source.types = 0; source.rows = 0; source.stride = 0;
+
+        return *this;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of rows
+    std::size_t OptionBatch::size() const { return rows; }
+
+    // Factor columns
+    const double* OptionBatch::T() const   { return Column(0); }
+    const double* OptionBatch::K() const   { return Column(1); }
+    const double* OptionBatch::sig() const { return Column(2); }
+    const double* OptionBatch::r() const   { return Column(3); }
+    const double* OptionBatch::b() const   { return Column(4); }
+    const double* OptionBatch::S() const   { return Column(5); }
+
+    // Option type column
+    const char* OptionBatch::type() const { return types; }
+
+    // Get the i-th row as an OptionData structure
+    struct OptionData OptionBatch::row(std::size_t i) const
+    {
+        OptionData data;
+        data.T = T()[i]; data.K = K()[i]; data.sig = sig()[i];
+        data.r = r()[i]; data.b = b()[i]; data.S = S()[i]; data.optType = types[i];
+        return data;
+    }
+
+    // Convert the batch back to a matrix of option data (rows of T, K, sig, r, b, S)
+    std::vector<std::vector<double>> OptionBatch::ToMatrix() const
+    {
+        std::vector<std::vector<double>> matrix(rows, std::vector<double>(6));
+        for (std::size_t i = 0; i < rows; i++)
+            for (std::size_t j = 0; j < 6; j++)
+                matrix[i][j] = Column(j)[i];
+        return matrix;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Writable factor columns
+    double* OptionBatch::T()   { return Column(0); }
+    double* OptionBatch::K()   { return Column(1); }
+    double* OptionBatch::sig() { return Column(2); }
+    double* OptionBatch::r()   { return Column(3); }
+    double* OptionBatch::b()   { return Column(4); }
+    double* OptionBatch::S()   { return Column(5); }
+
+    // Writable option type column
+    char* OptionBatch::type() { return types; }
+
+    // Set the i-th row from an OptionData structure
+    void OptionBatch::set_row(std::size_t i, const struct OptionData& data)
+    {
+        T()[i] = data.T; K()[i] = data.K; sig()[i] = data.sig;
+        r()[i] = data.r; b()[i] = data.b; S()[i] = data.S;
+
+        // Keep the option type uppercase, 'C' if it was not set
+        types[i] = (data.optType != 0)? toupper(data.optType) : 'C';
+    }
+}
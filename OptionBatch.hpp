@@ -0,0 +1,128 @@
+//  OptionBatch.hpp
+//  Contiguous, column-major storage for a batch of options.
+//  Each factor (T, K, sig, r, b, S) and the option type live in their
+//  own aligned column, so batch functions can stream through a whole
+//  column instead of chasing one heap allocation per row.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef OptionBatch_hpp
+#define OptionBatch_hpp
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Exception.hpp"
+#include "OptionData.hpp"
+
+namespace All_Options
+{
+    class OptionBatch
+    {
+    private:
+        ///////////////////////////////////////////Private data//////////////////////////////////////////////////
+
+        double* buffer;       // Aligned block that holds the six factor columns one after another
+        char* types;          // Option type column ('C' or 'P')
+        std::size_t rows;     // Number of options in the batch
+        std::size_t stride;   // Distance between two factor columns (rows rounded up to the alignment)
+
+        ////////////////////////////////////////Memory Management//////////////////////////////////////////////
+
+        // Allocate aligned columns for n rows
+        void Allocate(std::size_t n);
+
+        // Free the columns
+        void Release();
+
+        // Pointer to the start of the i-th factor column
+        double* Column(std::size_t i) const;
+
+    public:
+        // Alignment in bytes of every column (one cache line, enough for AVX-512 loads)
+        static const std::size_t Alignment = 64;
+
+        ////////////////////////////////////////Constructors///////////////////////////////////////////////
+
+        // Default Constructor (empty batch)
+        OptionBatch();
+
+        // Create a batch of n rows with all factors set to 0 and the given option type
+        explicit OptionBatch(std::size_t n, const char& type = 'C');
+
+        // Copy Constructor
+        OptionBatch(const OptionBatch& source);
+
+        // Move Constructor
+        OptionBatch(OptionBatch&& source);
+
+        // Create a batch from a vector of OptionData structures
+        // optType of each structure is kept ('C' if it was not set)
+        OptionBatch(const std::vector<struct OptionData>& batches);
+
+        // Create a batch from a matrix of option data (rows of T, K, sig, r, b, S)
+        // Every row gets the same option type
+        OptionBatch(const std::vector<std::vector<double>>& matrix, const char& type = 'C');
+
+        // Create a batch from one OptionData structure by varying one factor
+        // from start to end with the given step (same rows as GenerateMatrix)
+        OptionBatch(const struct OptionData& source, const std::string& factor,
+                    const double& start, const double& end, const double& step);
+        OptionBatch(const struct OptionData& source, const Factor& factor,
+                    const double& start, const double& end, const double& step);
+
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+
+        ~OptionBatch();
+
+        //////////////////////////////////////////Operators/////////////////////////////////////////////////
+
+        // Assignment operator
+        OptionBatch& operator = (const OptionBatch& source);
+
+        // Move assignment operator
+        OptionBatch& operator = (OptionBatch&& source);
+
+        ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+
+        // Number of rows
+        std::size_t size() const;
+
+        // Factor columns
+        const double* T() const;
+        const double* K() const;
+        const double* sig() const;
+        const double* r() const;
+        const double* b() const;
+        const double* S() const;
+
+        // Option type column
+        const char* type() const;
+
+        // Get the i-th row as an OptionData structure
+        struct OptionData row(std::size_t i) const;
+
+        // Convert the batch back to a matrix of option data (rows of T, K, sig, r, b, S)
+        std::vector<std::vector<double>> ToMatrix() const;
+
+        ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
+
+        // Writable factor columns
+        double* T();
+        double* K();
+        double* sig();
+        double* r();
+        double* b();
+        double* S();
+
+        // Writable option type column
+        char* type();
+
+        // Set the i-th row from an OptionData structure
+        void set_row(std::size_t i, const struct OptionData& data);
+    };
+}
+
+#endif
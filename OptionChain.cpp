@@ -0,0 +1,249 @@
+//  OptionChain.cpp
+//  European options on one underlying and one expiry, priced in one pass.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "OptionChain.hpp"
+#include "Exception.hpp"
+#include <cctype>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    // Check the shared factors of a chain
+    static void CheckTerms(const double& T, const double& r, const double& b, const double& S)
+    {
+        // The kernel divides by sqrt(T) and takes log(S), so T and S have to be larger than 0
+        if (!(T > 0) || !(S > 0) || r < 0 || b < 0)
+            throw InvalidValueException();
+    }
+    
+    // Check a strike, a volatility and a type
+    static void CheckStrike(const double& K, const double& sig, const char& type)
+    {
+        if (type != 'C' && type != 'P' && type != 'c' && type != 'p')
+            throw InvalidOptionTypeException(type);
+        if (!(K > 0) || !(sig > 0))
+            throw InvalidValueException();
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Private Functions/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Compute the shared terms from T, r, b and S
+    void OptionChain::Init()
+    {
+        terms.sqrtT = sqrt(terms.T);
+        terms.logS = log(terms.S);
+        terms.dfr = exp(-terms.r * terms.T);
+        terms.dfb = exp((terms.b - terms.r) * terms.T);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    OptionChain::OptionChain(): name(), terms(), strikes(), logK(), vols(), types() {}
+    
+    OptionChain::OptionChain(const std::string& underlying, const double& T, const double& r, const double& b, const double& S)
+    : name(underlying), terms(), strikes(), logK(), vols(), types()
+    {
+        CheckTerms(T, r, b, S);
+        terms.T = T; terms.r = r; terms.b = b; terms.S = S;
+        Init();
+    }
+    
+    OptionChain::OptionChain(const struct OptionData& data, const std::vector<double>& K)
+    : OptionChain(data.name, data.T, data.r, data.b, data.S)
+    {
+        char type = (data.optType != 0)? data.optType : 'C';
+        for (std::size_t i = 0; i < K.size(); i++)
+            CheckStrike(K[i], data.sig, type);
+        
+        strikes = K;
+        logK.resize(K.size());
+        for (std::size_t i = 0; i < K.size(); i++)
+            logK[i] = log(K[i]);
+        vols.assign(K.size(), data.sig);
+        
+        // Make the type uppercase, as Option::set_data does
+        types.assign(K.size(), static_cast<char>(toupper(type)));
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////Getters///////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Number of options
+    std::size_t OptionChain::size() const
+    {
+        return strikes.size();
+    }
+    
+    // Underlying and shared factors
+    const std::string& OptionChain::get_name() const
+    {
+        return name;
+    }
+    
+    double OptionChain::get_T() const
+    {
+        return terms.T;
+    }
+    
+    double OptionChain::get_r() const
+    {
+        return terms.r;
+    }
+    
+    double OptionChain::get_b() const
+    {
+        return terms.b;
+    }
+    
+    double OptionChain::get_S() const
+    {
+        return terms.S;
+    }
+    
+    // Columns of the options
+    const double* OptionChain::K() const
+    {
+        return strikes.data();
+    }
+    
+    const double* OptionChain::sig() const
+    {
+        return vols.data();
+    }
+    
+    const char* OptionChain::type() const
+    {
+        return types.data();
+    }
+    
+    // Get the i-th option as an OptionData structure
+    struct OptionData OptionChain::get_data(const std::size_t& i) const
+    {
+        OptionData data;
+        data.name = name;
+        data.T = terms.T; data.K = strikes[i]; data.sig = vols[i];
+        data.r = terms.r; data.b = terms.b; data.S = terms.S; data.optType = types[i];
+        return data;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////Modifiers//////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Add an option with strike K, volatility sig and type 'C' or 'P'
+    void OptionChain::Add(const double& K, const double& sig, const char& type)
+    {
+        // An empty chain has no expiry or spot to share
+        if (!(terms.T > 0))
+            throw InvalidValueException();
+        CheckStrike(K, sig, type);
+        
+        strikes.push_back(K);
+        logK.push_back(log(K));
+        vols.push_back(sig);
+        types.push_back(static_cast<char>(toupper(type)));
+    }
+    
+    // Move the spot, in place: only log(S) is recomputed
+    void OptionChain::set_S(const double& S)
+    {
+        if (!(S > 0))
+            throw InvalidValueException();
+        terms.S = S;
+        terms.logS = log(S);
+    }
+    
+    // Change the volatility of the i-th option, in place
+    void OptionChain::set_sig(const std::size_t& i, const double& sig)
+    {
+        if (i >= vols.size() || !(sig > 0))
+            throw InvalidValueException();
+        vols[i] = sig;
+    }
+    
+    // Change the volatility of every option
+    void OptionChain::set_sig(const double& sig)
+    {
+        if (!(sig > 0))
+            throw InvalidValueException();
+        vols.assign(vols.size(), sig);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Prices of every option, in one vectorized pass
+    std::vector<double> OptionChain::Price(const NormalMode& mode) const
+    {
+        std::vector<double> price(size());
+        Simd::KernelOutput out;
+        out.price = price.data();
+        Greeks(out, price.size(), mode);
+        return price;
+    }
+    
+    // Price and sensitivities selected by the mask of every option, in one vectorized pass
+    BatchGreeks OptionChain::Greeks(const unsigned& mask, const NormalMode& mode) const
+    {
+        BatchGreeks greeks;
+        std::size_t n = size();
+        Simd::KernelOutput out;
+        if (mask & PRICE) { greeks.price.resize(n); out.price = greeks.price.data(); }
+        if (mask & DELTA) { greeks.delta.resize(n); out.delta = greeks.delta.data(); }
+        if (mask & GAMMA) { greeks.gamma.resize(n); out.gamma = greeks.gamma.data(); }
+        if (mask & VEGA)  { greeks.vega.resize(n);  out.vega = greeks.vega.data(); }
+        if (mask & THETA) { greeks.theta.resize(n); out.theta = greeks.theta.data(); }
+        if (mask & RHO)   { greeks.rho.resize(n);   out.rho = greeks.rho.data(); }
+        
+        Greeks(out, n, mode);
+        return greeks;
+    }
+    
+    // Same as above, writing to caller buffers of n values
+    void OptionChain::Greeks(const Simd::KernelOutput& out, const std::size_t& n, const NormalMode& mode) const
+    {
+        if (n != size())
+            throw InvalidSizeException(size(), n);
+        if (n == 0)
+            return;
+        
+        // The data were checked when they were set, so the kernel runs on the arrays as they are
+        Simd::ChainKernel(terms, strikes.data(), logK.data(), vols.data(), types.data(), 0, n, out, mode);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Description/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    std::string OptionChain::ToString() const
+    {
+        // Create a stringstream
+        std::stringstream str;
+        
+        str << "Option Chain: " << name << " (" << size() << " options)\n";
+        str << "T:   " << terms.T << "\n";
+        str << "r:   " << terms.r << "\n";
+        str << "b:   " << terms.b << "\n";
+        str << "S:   " << terms.S;
+        return str.str();
+    }
+    
+    // Get the information of the object using <<
+    std::ostream& operator << (std::ostream& os, const OptionChain& chain)
+    {
+        // Get the description from ToString() function
+        os << chain.ToString();
+        return os;
+    }
+}
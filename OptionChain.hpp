@@ -0,0 +1,122 @@
+//  OptionChain.hpp
+//  European options on one underlying and one expiry. The strikes share
+//  S, T, r and b, so the terms that only depend on them (sqrt(T),
+//  log(S), exp(-r * T), exp((b - r) * T)) are stored once for the whole
+//  chain, and the strikes, their logs, the volatilities and the types
+//  are stored as contiguous arrays. The whole chain is priced or Greeked
+//  in one pass of the vectorized kernel, where each strike only costs
+//  d1 and the normal distribution. Moving the spot only recomputes
+//  log(S), and a new volatility only touches its own strike.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef OptionChain_hpp
+#define OptionChain_hpp
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "OptionData.hpp"
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+#include "SimdKernel.hpp"
+
+namespace All_Options
+{
+    class OptionChain
+    {
+    private:
+        ///////////////////////////////////////////Private data//////////////////////////////////////////////////
+        
+        std::string name;               // Underlying, the key of the chain with the expiry T
+        Simd::ChainTerms terms;         // T, r, b, S and the terms they share
+        
+        std::vector<double> strikes;    // Strike of each option
+        std::vector<double> logK;       // log(K) of each option
+        std::vector<double> vols;       // Volatility of each option
+        std::vector<char> types;        // Type of each option ('C' or 'P', made uppercase when it is added)
+        
+        ////////////////////////////////////////Private Functions///////////////////////////////////////////
+        
+        // Compute the shared terms from T, r, b and S
+        void Init();
+    
+    public:
+        ////////////////////////////////////////Constructors///////////////////////////////////////////////
+        
+        // Default Constructor (empty chain)
+        OptionChain();
+        
+        // Empty chain of an underlying and an expiry
+        // Throw InvalidValueException if T or S is not positive, or r or b is negative
+        OptionChain(const std::string& underlying, const double& T, const double& r, const double& b, const double& S);
+        
+        // Chain of the option of data with each strike, all with the volatility and type of data
+        // Throw InvalidValueException as above, or if a strike or the volatility is not positive,
+        // and InvalidOptionTypeException if the type is not C or P
+        OptionChain(const struct OptionData& data, const std::vector<double>& strikes);
+        
+        ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+        
+        // Number of options
+        std::size_t size() const;
+        
+        // Underlying and shared factors
+        const std::string& get_name() const;
+        double get_T() const;
+        double get_r() const;
+        double get_b() const;
+        double get_S() const;
+        
+        // Columns of the options
+        const double* K() const;
+        const double* sig() const;
+        const char* type() const;
+        
+        // Get the i-th option as an OptionData structure
+        struct OptionData get_data(const std::size_t& i) const;
+        
+        ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
+        
+        // Add an option with strike K, volatility sig and type 'C' or 'P'
+        // Throw InvalidValueException if K or sig is not positive or the chain has no expiry (default constructor),
+        // and InvalidOptionTypeException for another type
+        void Add(const double& K, const double& sig, const char& type);
+        
+        // Move the spot, in place: only log(S) is recomputed
+        // Throw InvalidValueException if S is not positive
+        void set_S(const double& S);
+        
+        // Change the volatility of the i-th option, in place
+        // Throw InvalidValueException if sig is not positive or i is not an option
+        void set_sig(const std::size_t& i, const double& sig);
+        
+        // Change the volatility of every option
+        // Throw InvalidValueException if sig is not positive
+        void set_sig(const double& sig);
+        
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        
+        // Prices of every option, in one vectorized pass
+        std::vector<double> Price(const NormalMode& mode = HIGH_ACCURACY) const;
+        
+        // Price and sensitivities selected by the mask of every option, in one vectorized pass
+        BatchGreeks Greeks(const unsigned& mask = ALL_GREEKS, const NormalMode& mode = HIGH_ACCURACY) const;
+        
+        // Same as above, writing to caller buffers of n values; the outputs whose pointer is null are skipped
+        // Throw InvalidSizeException if n is not the number of options
+        void Greeks(const Simd::KernelOutput& out, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY) const;
+        
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        
+        std::string ToString() const;
+        
+        // Get the information of the object using <<
+        friend std::ostream& operator << (std::ostream& os, const OptionChain& chain);
+    };
+}
+
+#endif
@@ -8,8 +8,30 @@
 #ifndef OptionData_hpp
 #define OptionData_hpp
 
+#include <cstddef>
+#include <string>
+
 namespace All_Options
 {
+    // Factors of an option, in the order of the columns of GenerateMatrix
+    // Use these instead of factor names ("T", "K", "sig", "r", "b", "S") on hot paths
+    enum class Factor { T = 0, K = 1, SIG = 2, R = 3, B = 4, S = 5 };
+    
+    // Exercise styles of the engines that price both (finite difference, lattice)
+    enum ExerciseStyle { EUROPEAN_EXERCISE = 0, AMERICAN_EXERCISE = 1 };
+    
+    // Convert a factor name ("T", "K", "sig", "r", "b", "S", any case) to a Factor
+    // Throw InvalidFactorException if the name is not valid
+    Factor ParseFactor(const std::string& factor);
+    
+    // Name of a factor ("T", "K", "sig", "r", "b" or "S")
+    std::string FactorName(const Factor& factor);
+    
+    // Number of values from start to end with the given step, i.e. the size of the output of
+    // a function taking (factor, start, end, step); use it to size a buffer in advance
+    // Throw InvalidStepException if the step does not lead from start to end
+    std::size_t SweepSize(const double& start, const double& end, const double& step);
+    
     struct OptionData
     {
         double T = 0;   // Expiry time
@@ -21,6 +43,20 @@ namespace All_Options
         char   optType = 0; // Option Type
         std::string name = "Default"; // Asset name
     };
+    
+    // Get the value of a factor of an OptionData structure
+    inline double FactorValue(const struct OptionData& data, const Factor& factor)
+    {
+        switch (factor)
+        {
+            case Factor::T:   return data.T;
+            case Factor::K:   return data.K;
+            case Factor::SIG: return data.sig;
+            case Factor::R:   return data.r;
+            case Factor::B:   return data.b;
+            default:          return data.S;
+        }
+    }
 }
 
 #endif
@@ -11,8 +11,11 @@
 #include "Exception.hpp"
 #include "EuropeanOption.hpp"
 #include "PerpetualAmericanOption.hpp"
+#include "SimdKernel.hpp"
+#include "EuropeanSweep.hpp"
 #include <boost/math/distributions/normal.hpp>
 #include <cctype>
+#include <limits>
 
 namespace All_Options
 {
@@ -23,29 +26,29 @@ namespace All_Options
     std::vector<std::vector<double>> GenerateMatrix
     (const struct OptionData& source, const std::string& factor, const double& start, const double& end, const double& step)
     {
-        // Make the factor uppercase
-        std::string str = boost::to_upper_copy(factor);
-        
-        // Check factors' names
-        if (str != "R" && str != "T" && str != "K" && str != "B" && str != "S" && str != "SIG")
-            throw InvalidFactorException(factor);
-        
+        return GenerateMatrix(source, ParseFactor(factor), start, end, step);
+    }
+    
+    
+    // The function takes in one OptionData structure
+    // Also take the varying factor and its range and step size
+    // Return a matrix of option data
+    std::vector<std::vector<double>> GenerateMatrix
+    (const struct OptionData& source, const Factor& factor, const double& start, const double& end, const double& step)
+    {
         // Check range and step
         if (((end - start) < 0 && step >= 0) || ((end - start) > 0 && step <= 0) || step == 0)
             throw InvalidStepException(step, start, end);
         
-        // Create a matrix, a vector and a map
+        // Create a matrix and a row holding the data in the order T, K, sig, r, b, S
         std::vector<std::vector<double>> matrix;
-        std::vector<double> each;
-        std::map<std::string, double> mp;
-        
-        // Put the data in the map
-        mp["R"] = source.r;
-        mp["B"] = source.b;
-        mp["SIG"] = source.sig;
-        mp["T"] = source.T;
-        mp["K"] = source.K;
-        mp["S"] = source.S;
+        std::vector<double> each(6);
+        each[0] = source.T;
+        each[1] = source.K;
+        each[2] = source.sig;
+        each[3] = source.r;
+        each[4] = source.b;
+        each[5] = source.S;
         
         // Record whether the varying parameter is increasing or decreasing
         int direction = (end > start)? 1:-1;
@@ -54,21 +57,10 @@ namespace All_Options
         for (double i = start; (i - end) * direction <= 0; i += step)
         {
             // Change the value of the specified factor
-            mp[str] = i;
-            
-            // Fill the vector with the data
-            each.push_back(mp["T"]);
-            each.push_back(mp["K"]);
-            each.push_back(mp["SIG"]);
-            each.push_back(mp["R"]);
-            each.push_back(mp["B"]);
-            each.push_back(mp["S"]);
+            each[static_cast<int>(factor)] = i;
             
             // Put the vector in the matrix
             matrix.push_back(each);
-            
-            // Clear the vector and ready for the next iteration
-            each.clear();
         }
         return matrix;
     }
@@ -106,128 +98,654 @@ namespace All_Options
     
     
     
-    namespace European
+    // Check every row of a batch the same way Option::set_data does
+    // Throw on the first invalid row so that nothing is priced from bad data
+    void CheckBatch(const OptionBatch& batch, const bool& check_type, const bool& positive)
     {
-        // Take in a matrix of option data and return a vector of prices
-        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type)
+        const double *T = batch.T(), *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+        const char* type = batch.type();
+        
+        for (std::size_t i = 0; i < batch.size(); i++)
         {
-            // Create a option data structure
-            OptionData batch;
+            // Values cannot be negative and K must be positive
+            if (T[i] < 0 || sig[i] < 0 || K[i] <= 0 || r[i] < 0 || b[i] < 0 || S[i] < 0)
+                throw InvalidValueException();
             
-            // Create a European option
-            EuropeanOption opt;
+            // The kernels divide by sig sqrt(T) and take log(S)
+            if (positive && (!(T[i] > 0) || !(sig[i] > 0) || !(S[i] > 0)))
+                throw InvalidValueException();
             
-            // Vector that stores the prices
-            std::vector<double> price;
+            // Type has to be one of C, P, c, p
+            if (check_type && type[i] != 'C' && type[i] != 'P' && type[i] != 'c' && type[i] != 'p')
+                throw InvalidOptionTypeException(type[i]);
+        }
+    }
+    
+    
+    // Check the factors and the type of one option the same way as CheckBatch
+    void CheckOption(const struct OptionData& data, const bool& check_type, const bool& positive)
+    {
+        if (data.T < 0 || data.sig < 0 || data.K <= 0 || data.r < 0 || data.b < 0 || data.S < 0)
+            throw InvalidValueException();
+        if (positive && (!(data.T > 0) || !(data.sig > 0) || !(data.S > 0)))
+            throw InvalidValueException();
+        
+        // An unset type (0) is a call, as in OptionBatch
+        char type = data.optType;
+        if (check_type && type != 0 && type != 'C' && type != 'P' && type != 'c' && type != 'p')
+            throw InvalidOptionTypeException(type);
+    }
+    
+    
+    // RowStatus bits of the rows [begin, end) of a batch
+    // The factor checks have no branch so that the loop over the columns vectorizes
+    static void ValidateRows(const OptionBatch& batch, std::size_t begin, std::size_t end, const bool& check_type,
+                             unsigned char* status)
+    {
+        const double *T = batch.T(), *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+        const char* type = batch.type();
+        
+        // Written as !(x >= 0) so that NaN fails as well
+        for (std::size_t i = begin; i < end; i++)
+        {
+            status[i] = static_cast<unsigned char>((!(T[i] >= 0)) * ROW_INVALID_T | (!(K[i] > 0)) * ROW_INVALID_K |
+                                                   (!(sig[i] >= 0)) * ROW_INVALID_SIG | (!(r[i] >= 0)) * ROW_INVALID_R |
+                                                   (!(b[i] >= 0)) * ROW_INVALID_B | (!(S[i] >= 0)) * ROW_INVALID_S);
+        }
+        
+        // Type has to be one of C, P, c, p
+        if (check_type)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                if (type[i] != 'C' && type[i] != 'P' && type[i] != 'c' && type[i] != 'p')
+                    status[i] |= ROW_INVALID_TYPE;
+        }
+    }
+    
+    
+    // Check every row of a batch without throwing and return the status of each row
+    std::vector<unsigned char> ValidateBatch(const OptionBatch& batch, const bool& check_type)
+    {
+        std::vector<unsigned char> status(batch.size());
+        ValidateRows(batch, 0, batch.size(), check_type, status.data());
+        return status;
+    }
+    
+    
+    // Size the vectors selected by the mask and point the kernel output at them
+    static Simd::KernelOutput PrepareGreeks(BatchGreeks& greeks, const std::size_t& n, const unsigned& mask)
+    {
+        Simd::KernelOutput out;
+        if (mask & PRICE) { greeks.price.resize(n); out.price = greeks.price.data(); }
+        if (mask & DELTA) { greeks.delta.resize(n); out.delta = greeks.delta.data(); }
+        if (mask & GAMMA) { greeks.gamma.resize(n); out.gamma = greeks.gamma.data(); }
+        if (mask & VEGA)  { greeks.vega.resize(n);  out.vega = greeks.vega.data(); }
+        if (mask & THETA) { greeks.theta.resize(n); out.theta = greeks.theta.data(); }
+        if (mask & RHO)   { greeks.rho.resize(n);   out.rho = greeks.rho.data(); }
+        return out;
+    }
+    
+    
+    namespace European
+    {
+        // Check a batch and the size of the output buffers, then run the vectorized kernel on every row
+        // The kernel is specialized once for the carry regime of the batch; the rows are split in chunks
+        // over the pool if one is given
+        static void RunKernel(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                              const NormalMode& mode, ThreadPool* pool, const ParallelConfig& config)
+        {
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
+            
+            // Check the data before pricing anything
+            // Gamma and vega are the same for calls and puts, so the type is only checked for the other outputs
+            CheckBatch(batch, out.price || out.delta || out.theta || out.rho);
             
-            // Iterate every row of the matrix
-            for (int i = 0; i < matrix.size(); i++)
+            CarryRegime carry = ClassifyCarry(batch.r(), batch.b(), batch.size());
+            if (pool)
             {
-                // the data structure takes the data from each row of the matrix
-                batch.T = matrix[i][0]; batch.K = matrix[i][1]; batch.sig = matrix[i][2];
-                batch.r = matrix[i][3]; batch.b = matrix[i][4]; batch.S = matrix[i][5]; batch.optType = type;
-                
-                // Set the data of the European option
-                opt.set_data(batch);
-                
-                // Get the price of the option and put the price in the vector
-                price.push_back(opt.Price());
-                
+                // Each chunk computes its own rows
+                auto chunk = [&](std::size_t begin, std::size_t end) { Simd::EuropeanKernel(batch, begin, end, out, mode, carry); };
+                pool->ParallelFor(batch.size(), config.chunk, chunk, config.threads);
             }
-            
+            else
+                Simd::EuropeanKernel(batch, 0, batch.size(), out, mode, carry);
+        }
+        
+        // Take in a batch of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const NormalMode& mode)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            MatrixPricer(batch, price.data(), price.size(), mode);
             return price;
         }
         
-        // Take in a matrix of option data and return a vector of deltas
-        std::vector<double> MatrixDelta(const std::vector<std::vector<double>>& matrix, const char& type)
+        // Take in a batch of option data and return a vector of deltas
+        std::vector<double> MatrixDelta(const OptionBatch& batch, const NormalMode& mode)
         {
-            // Create a option data structure
-            OptionData batch;
+            // Vector that stores the deltas
+            std::vector<double> delta(batch.size());
+            MatrixDelta(batch, delta.data(), delta.size(), mode);
+            return delta;
+        }
+        
+        // Take in a batch of option data and return a vector of gammas
+        std::vector<double> MatrixGamma(const OptionBatch& batch, const NormalMode& mode)
+        {
+            // Vector that stores the gammas
+            std::vector<double> gamma(batch.size());
+            MatrixGamma(batch, gamma.data(), gamma.size(), mode);
+            return gamma;
+        }
+        
+        // Take in a batch of option data and return the price and sensitivities selected by the mask
+        BatchGreeks MatrixGreeks(const OptionBatch& batch, const unsigned& mask, const NormalMode& mode)
+        {
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            Simd::KernelOutput out = PrepareGreeks(greeks, batch.size(), mask);
             
-            // Create a European option
-            EuropeanOption opt;
+            // One pass of the kernel computes every selected output
+            MatrixGreeks(batch, out, batch.size(), mode);
+            return greeks;
+        }
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ParallelConfig& config, const NormalMode& mode)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            ParallelMatrixPricer(batch, price.data(), price.size(), config, mode);
+            return price;
+        }
+        
+        // Same as MatrixGreeks, with the batch split in chunks over a pool of threads
+        BatchGreeks ParallelMatrixGreeks(const OptionBatch& batch, const unsigned& mask, const ParallelConfig& config,
+                                         const NormalMode& mode)
+        {
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            Simd::KernelOutput out = PrepareGreeks(greeks, batch.size(), mask);
+            ParallelMatrixGreeks(batch, out, batch.size(), config, mode);
+            return greeks;
+        }
+        
+        // Write the prices of a batch to a caller buffer of n = batch.size() values
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const NormalMode& mode)
+        {
+            Simd::KernelOutput out;
+            out.price = price;
+            RunKernel(batch, out, n, mode, 0, ParallelConfig());
+        }
+        
+        // Write the deltas of a batch to a caller buffer of n = batch.size() values
+        void MatrixDelta(const OptionBatch& batch, double* delta, const std::size_t& n, const NormalMode& mode)
+        {
+            Simd::KernelOutput out;
+            out.delta = delta;
+            RunKernel(batch, out, n, mode, 0, ParallelConfig());
+        }
+        
+        // Write the gammas of a batch to a caller buffer of n = batch.size() values
+        void MatrixGamma(const OptionBatch& batch, double* gamma, const std::size_t& n, const NormalMode& mode)
+        {
+            Simd::KernelOutput out;
+            out.gamma = gamma;
+            RunKernel(batch, out, n, mode, 0, ParallelConfig());
+        }
+        
+        // Write the outputs with a non-null pointer to caller buffers of n = batch.size() values
+        void MatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n, const NormalMode& mode)
+        {
+            RunKernel(batch, out, n, mode, 0, ParallelConfig());
+        }
+        
+        // Same as MatrixPricer with a caller buffer, with the batch split in chunks over a pool of threads
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const ParallelConfig& config,
+                                  const NormalMode& mode)
+        {
+            Simd::KernelOutput out;
+            out.price = price;
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            RunKernel(batch, out, n, mode, &pool, config);
+        }
+        
+        // Same as MatrixGreeks with caller buffers, with the batch split in chunks over a pool of threads
+        void ParallelMatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                                  const ParallelConfig& config, const NormalMode& mode)
+        {
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            RunKernel(batch, out, n, mode, &pool, config);
+        }
+        
+        // Price the rows [begin, end) of a checked batch
+        // Each run of valid rows goes through the kernel in one call, the outputs of invalid rows are set to NaN
+        // Without a status every row is valid
+        static void PriceCheckedRows(const OptionBatch& batch, std::size_t begin, std::size_t end, const unsigned char* status,
+                                     const Simd::KernelOutput& out, const NormalMode& mode, const CarryRegime& carry)
+        {
+            if (!status)
+            {
+                Simd::EuropeanKernel(batch, begin, end, out, mode, carry);
+                return;
+            }
             
-            // Vector that stores the deltas
-            std::vector<double> delta;
+            double* const dst[6] = { out.price, out.delta, out.gamma, out.vega, out.theta, out.rho };
+            const double nan = std::numeric_limits<double>::quiet_NaN();
             
-            // Iterate every row of the matrix
-            for (int i = 0; i < matrix.size(); i++)
+            std::size_t i = begin;
+            while (i < end)
             {
-                // the data structure takes the data from each row of the matrix
-                batch.T = matrix[i][0]; batch.K = matrix[i][1]; batch.sig = matrix[i][2];
-                batch.r = matrix[i][3]; batch.b = matrix[i][4]; batch.S = matrix[i][5]; batch.optType = type;
-                
-                // Set the data of the European option
-                opt.set_data(batch);
-                
-                // Get the delta of the option and put the delta in the vector
-                delta.push_back(opt.Delta());
+                if (status[i] != ROW_VALID)
+                {
+                    for (int k = 0; k < 6; k++)
+                        if (dst[k]) dst[k][i] = nan;
+                    i++;
+                    continue;
+                }
                 
+                // Find the end of the run of valid rows
+                std::size_t j = i + 1;
+                while (j < end && status[j] == ROW_VALID)
+                    j++;
+                Simd::EuropeanKernel(batch, i, j, out, mode, carry);
+                i = j;
             }
-
-            return delta;
         }
         
-        // Take in a matrix of option data and return a vector of gammas
-        std::vector<double> MatrixGamma(const std::vector<std::vector<double>>& matrix)
+        // Serve for CheckedMatrixGreeks() and ParallelCheckedMatrixGreeks(), run on the pool if one is given
+        static CheckedGreeks CheckedGreeksOf(const OptionBatch& batch, const unsigned& mask, const bool& trusted,
+                                             const NormalMode& mode, ThreadPool* pool, const ParallelConfig& config)
         {
-            // Create a option data structure
-            OptionData batch;
+            CheckedGreeks result;
+            Simd::KernelOutput out = PrepareGreeks(result.greeks, batch.size(), mask);
+            unsigned char* status = 0;
+            CarryRegime carry;
             
-            // Create a European option
-            EuropeanOption opt;
-            
-            // Vector that stores the gammas
-            std::vector<double> gamma;
-            
-            // Iterate every row of the matrix
-            for (int i = 0; i < matrix.size(); i++)
+            if (trusted)
+                carry = ClassifyCarry(batch.r(), batch.b(), batch.size());
+            else
             {
-                // the data structure takes the data from each row of the matrix
-                batch.T = matrix[i][0]; batch.K = matrix[i][1]; batch.sig = matrix[i][2];
-                batch.r = matrix[i][3]; batch.b = matrix[i][4]; batch.S = matrix[i][5];
-                
-                // Set the data of the European option
-                opt.set_data(batch);
+                // Validation pass; the type only matters for the outputs that differ between calls and puts
+                bool check_type = (mask & (PRICE | DELTA | THETA | RHO)) != 0;
+                result.status.resize(batch.size());
+                status = result.status.data();
+                auto validate = [&](std::size_t begin, std::size_t end) { ValidateRows(batch, begin, end, check_type, status); };
+                if (pool)
+                    pool->ParallelFor(batch.size(), config.chunk, validate, config.threads);
+                else
+                    validate(0, batch.size());
                 
-                // Get the gamma of the option and put the gamma in the vector
-                gamma.push_back(opt.Gamma());
+                // Count the invalid rows and pick the carry regime of the valid ones
+                const double *r = batch.r(), *b = batch.b();
+                bool first = true;
+                carry = CARRY_GENERAL;
+                for (std::size_t i = 0; i < batch.size(); i++)
+                {
+                    if (status[i] != ROW_VALID)
+                        result.invalid++;
+                    else if (first)
+                    {
+                        carry = ClassifyCarry(r[i], b[i]);
+                        first = false;
+                    }
+                    else
+                        carry = CombineCarry(carry, ClassifyCarry(r[i], b[i]));
+                }
             }
             
-            return gamma;
+            // Pricing pass over the valid rows
+            auto price = [&](std::size_t begin, std::size_t end) { PriceCheckedRows(batch, begin, end, status, out, mode, carry); };
+            if (pool)
+                pool->ParallelFor(batch.size(), config.chunk, price, config.threads);
+            else
+                price(0, batch.size());
+            
+            return result;
+        }
+        
+        // Take in a batch that may hold bad rows and return the outputs selected by the mask and the status of each row
+        CheckedGreeks CheckedMatrixGreeks(const OptionBatch& batch, const unsigned& mask, const bool& trusted,
+                                          const NormalMode& mode)
+        {
+            return CheckedGreeksOf(batch, mask, trusted, mode, 0, ParallelConfig());
+        }
+        
+        // Same as CheckedMatrixGreeks, with the batch split in chunks over a pool of threads
+        CheckedGreeks ParallelCheckedMatrixGreeks(const OptionBatch& batch, const unsigned& mask, const ParallelConfig& config,
+                                                  const bool& trusted, const NormalMode& mode)
+        {
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            return CheckedGreeksOf(batch, mask, trusted, mode, &pool, config);
+        }
+        
+        // Take in a matrix of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type)
+        {
+            return MatrixPricer(OptionBatch(matrix, type));
+        }
+        
+        // Take in a matrix of option data and return a vector of deltas
+        std::vector<double> MatrixDelta(const std::vector<std::vector<double>>& matrix, const char& type)
+        {
+            return MatrixDelta(OptionBatch(matrix, type));
+        }
+        
+        // Take in a matrix of option data and return a vector of gammas
+        std::vector<double> MatrixGamma(const std::vector<std::vector<double>>& matrix)
+        {
+            return MatrixGamma(OptionBatch(matrix));
+        }
+        
+        // Take in one OptionData structure, the varying factor and its range and return a vector of prices
+        std::vector<double> SweepPricer(const struct OptionData& data, const Factor& factor, const double& start,
+                                        const double& end, const double& step, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, PRICE);
+        }
+        
+        // Take in one OptionData structure, the varying factor and its range and return a vector of deltas
+        std::vector<double> SweepDelta(const struct OptionData& data, const Factor& factor, const double& start,
+                                       const double& end, const double& step, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, DELTA);
+        }
+        
+        // Take in one OptionData structure, the varying factor and its range and return a vector of gammas
+        std::vector<double> SweepGamma(const struct OptionData& data, const Factor& factor, const double& start,
+                                       const double& end, const double& step, const NormalMode& mode)
+        {
+            CheckOption(data, false);
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.Run(start, end, step, GAMMA);
+        }
+        
+        // Take in one OptionData structure, the varying factor and its range
+        // Return the price and sensitivities selected by the mask
+        BatchGreeks SweepGreeks(const struct OptionData& data, const Factor& factor, const double& start,
+                                const double& end, const double& step, const unsigned& mask, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            return sweep.RunGreeks(start, end, step, mask);
+        }
+        
+        // Take in one OptionData structure, the varying factor and its range
+        // Write the prices to a caller buffer of n = SweepSize(start, end, step) values
+        void SweepPricer(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                         const double& step, double* price, const std::size_t& n, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, PRICE, price, n);
+        }
+        
+        // Same as above for deltas
+        void SweepDelta(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                        const double& step, double* delta, const std::size_t& n, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, DELTA, delta, n);
+        }
+        
+        // Same as above for gammas
+        void SweepGamma(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                        const double& step, double* gamma, const std::size_t& n, const NormalMode& mode)
+        {
+            CheckOption(data, false);
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.Run(start, end, step, GAMMA, gamma, n);
+        }
+        
+        // Same as above for the outputs with a non-null pointer
+        void SweepGreeks(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                         const double& step, const Simd::KernelOutput& out, const std::size_t& n, const NormalMode& mode)
+        {
+            CheckOption(data, true);
+            EuropeanSweep sweep(data, factor, mode);
+            sweep.RunGreeks(start, end, step, out, n);
         }
     }
     
     
     namespace PerpetualAmerican
     {
-        // Take in a matrix of option data and return a vector of prices
-        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type)
+        // Check a batch and the size of the output buffers, then run the vectorized kernel on every row
+        // The rows are split in chunks over the pool if one is given; every row only depends on itself,
+        // so the chunks do not change the result
+        static void RunKernel(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                              ThreadPool* pool, const ParallelConfig& config)
         {
-            // Create a option data structure
-            OptionData batch;
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
             
-            // Create a perpetual American option
-            PerpetualAmericanOption opt;
+            // Check the whole batch before pricing anything
+            CheckBatch(batch, true);
             
+            if (pool)
+            {
+                // Each chunk computes its own rows
+                auto chunk = [&](std::size_t begin, std::size_t end) { Simd::PerpetualKernel(batch, begin, end, out); };
+                pool->ParallelFor(batch.size(), config.chunk, chunk, config.threads);
+            }
+            else
+                Simd::PerpetualKernel(batch, 0, batch.size(), out);
+        }
+        
+        // Take in a batch of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const OptionBatch& batch)
+        {
             // Vector that stores the prices
-            std::vector<double> price;
+            std::vector<double> price(batch.size());
+            MatrixPricer(batch, price.data(), price.size());
+            return price;
+        }
+        
+        // Take in a batch of option data and return the outputs selected by the mask, computed in one pass
+        BatchGreeks MatrixGreeks(const OptionBatch& batch, const unsigned& mask)
+        {
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            Simd::KernelOutput out = PrepareGreeks(greeks, batch.size(), mask);
+            MatrixGreeks(batch, out, batch.size());
+            return greeks;
+        }
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ParallelConfig& config)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            ParallelMatrixPricer(batch, price.data(), price.size(), config);
+            return price;
+        }
+        
+        // Same as MatrixGreeks, with the batch split in chunks over a pool of threads
+        BatchGreeks ParallelMatrixGreeks(const OptionBatch& batch, const unsigned& mask, const ParallelConfig& config)
+        {
+            BatchGreeks greeks;
+            Simd::KernelOutput out = PrepareGreeks(greeks, batch.size(), mask);
+            ParallelMatrixGreeks(batch, out, batch.size(), config);
+            return greeks;
+        }
+        
+        // Write the prices of a batch to a caller buffer of n = batch.size() values
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n)
+        {
+            Simd::KernelOutput out;
+            out.price = price;
+            RunKernel(batch, out, n, 0, ParallelConfig());
+        }
+        
+        // Write the outputs with a non-null pointer to caller buffers of n = batch.size() values
+        void MatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n)
+        {
+            RunKernel(batch, out, n, 0, ParallelConfig());
+        }
+        
+        // Same as MatrixPricer with a caller buffer, with the batch split in chunks over a pool of threads
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const ParallelConfig& config)
+        {
+            Simd::KernelOutput out;
+            out.price = price;
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            RunKernel(batch, out, n, &pool, config);
+        }
+        
+        // Same as MatrixGreeks with caller buffers, with the batch split in chunks over a pool of threads
+        void ParallelMatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                                  const ParallelConfig& config)
+        {
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            RunKernel(batch, out, n, &pool, config);
+        }
+        
+        // Take in a matrix of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type)
+        {
+            return MatrixPricer(OptionBatch(matrix, type));
+        }
+    }
+    
+    
+    namespace American
+    {
+        // Price the rows [begin, end) of a batch, reusing the boundary terms while T, sig, r, b and the type repeat
+        static void PriceRows(const OptionBatch& batch, std::size_t begin, std::size_t end, const AmericanMethod& method,
+                              double* price)
+        {
+            const double *T = batch.T(), *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+            const char* type = batch.type();
             
-            // Iterate every row of the matrix
-            for (int i = 0; i < matrix.size(); i++)
+            // Group of the last row, NaN so that the first row starts a group
+            double group[4] = { std::numeric_limits<double>::quiet_NaN(), 0, 0, 0 };
+            bool group_call = true;
+            AmericanTerms terms;
+            
+            for (std::size_t i = begin; i < end; i++)
             {
-                // the data structure takes the data from each row of the matrix
-                batch.K = matrix[i][1]; batch.sig = matrix[i][2]; batch.r = matrix[i][3];
-                batch.b = matrix[i][4]; batch.S = matrix[i][5]; batch.optType = type;
-                
-                // Set the data of the European option
-                opt.set_data(batch);
-                
-                // Get the price of the option and put the price in the vector
-                price.push_back(opt.Price());
+                bool call = (toupper(type[i]) == 'C');
+                if (T[i] != group[0] || sig[i] != group[1] || r[i] != group[2] || b[i] != group[3] || call != group_call)
+                {
+                    group[0] = T[i]; group[1] = sig[i]; group[2] = r[i]; group[3] = b[i]; group_call = call;
+                    terms = AmericanOption::Boundary(T[i], sig[i], r[i], b[i], call, method);
+                }
+                price[i] = AmericanOption::BoundaryPrice(T[i], K[i], sig[i], r[i], b[i], S[i], call, method, terms);
             }
+        }
+        
+        // Take in a batch of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const AmericanMethod& method)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            MatrixPricer(batch, price.data(), price.size(), method);
+            return price;
+        }
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const AmericanMethod& method,
+                                                 const ParallelConfig& config)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            ParallelMatrixPricer(batch, price.data(), price.size(), method, config);
+            return price;
+        }
+        
+        // Write the prices of a batch to a caller buffer of n = batch.size() values
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const AmericanMethod& method)
+        {
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
+            
+            // Check the whole batch before pricing anything
+            CheckBatch(batch, true);
+            PriceRows(batch, 0, batch.size(), method, price);
+        }
+        
+        // Same as MatrixPricer with a caller buffer, with the batch split in chunks over a pool of threads
+        // A chunk starting inside a group computes its terms again, which gives the same values
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const AmericanMethod& method,
+                                  const ParallelConfig& config)
+        {
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
             
+            CheckBatch(batch, true);
+            auto chunk = [&](std::size_t begin, std::size_t end) { PriceRows(batch, begin, end, method, price); };
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            pool.ParallelFor(batch.size(), config.chunk, chunk, config.threads);
+        }
+        
+        // Take in a matrix of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type,
+                                         const AmericanMethod& method)
+        {
+            return MatrixPricer(OptionBatch(matrix, type), method);
+        }
+    }
+    
+    namespace Lattice
+    {
+        // Check the tree settings of a batch function
+        static void CheckConfig(const LatticeConfig& config)
+        {
+            if (config.steps < ((config.smoothing == BBS_RICHARDSON)? 2u : 1u))
+                throw InvalidValueException();
+        }
+        
+        // Take in a batch of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const ExerciseStyle& style, const LatticeConfig& config)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            MatrixPricer(batch, price.data(), price.size(), style, config);
+            return price;
+        }
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ExerciseStyle& style,
+                                                 const LatticeConfig& config, const ParallelConfig& parallel)
+        {
+            // Vector that stores the prices
+            std::vector<double> price(batch.size());
+            ParallelMatrixPricer(batch, price.data(), price.size(), style, config, parallel);
             return price;
         }
+        
+        // Write the prices of a batch to a caller buffer of n = batch.size() values
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const ExerciseStyle& style,
+                          const LatticeConfig& config)
+        {
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
+            
+            // Check the whole batch before pricing anything
+            CheckConfig(config);
+            CheckBatch(batch, true);
+            Simd::LatticeKernel(batch, 0, batch.size(), config, style, price);
+        }
+        
+        // Same as MatrixPricer with a caller buffer, with the batch split in chunks over a pool of threads
+        // Every row only depends on its own inputs, so the chunking does not change the values
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const ExerciseStyle& style,
+                                  const LatticeConfig& config, const ParallelConfig& parallel)
+        {
+            if (n != batch.size())
+                throw InvalidSizeException(batch.size(), n);
+            
+            CheckConfig(config);
+            CheckBatch(batch, true);
+            auto chunk = [&](std::size_t begin, std::size_t end) { Simd::LatticeKernel(batch, begin, end, config, style, price); };
+            ThreadPool& pool = parallel.pool? *parallel.pool : ThreadPool::Shared();
+            pool.ParallelFor(batch.size(), parallel.chunk, chunk, parallel.threads);
+        }
     }
 }
@@ -12,6 +12,12 @@
 #include <cmath>
 #include <vector>
 #include "Exception.hpp"
+#include "OptionBatch.hpp"
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+#include "ThreadPool.hpp"
+#include "SimdKernel.hpp"
+#include "AmericanOption.hpp"
 
 namespace All_Options
 {
@@ -21,6 +27,8 @@ namespace All_Options
     // Return a matrix of option data
     std::vector<std::vector<double>> GenerateMatrix
     (const struct OptionData& data, const std::string& factor, const double& start, const double& end, const double& step);
+    std::vector<std::vector<double>> GenerateMatrix
+    (const struct OptionData& data, const Factor& factor, const double& start, const double& end, const double& step);
     
     
     // The function takes in a vector of OptionData structures
@@ -28,8 +36,89 @@ namespace All_Options
     std::vector<std::vector<double>> GenerateMatrix(const std::vector<struct OptionData>& batches);
     
     
+    // Bits of the status of one row of a checked batch, ROW_VALID (0) when the row can be priced
+    enum RowStatus
+    {
+        ROW_VALID = 0,
+        ROW_INVALID_T = 1, ROW_INVALID_K = 2, ROW_INVALID_SIG = 4, ROW_INVALID_R = 8, ROW_INVALID_B = 16, ROW_INVALID_S = 32,
+        ROW_INVALID_TYPE = 64
+    };
+    
+    // Check every row of a batch with the rules of Option::set_data without throwing
+    // A NaN factor is invalid too; the type is only checked when check_type is true
+    // Return the RowStatus bits of each row
+    std::vector<unsigned char> ValidateBatch(const OptionBatch& batch, const bool& check_type = true);
+    
+    // Check every row of a batch, or one option, with the rules of Option::set_data; with positive, T, sig and S
+    // have to be larger than 0 as well, as the batch kernels need. The type is only checked when check_type is
+    // true, and an unset type (0) of an option is a call
+    // Throw InvalidValueException for the first invalid factor and InvalidOptionTypeException for an invalid type
+    void CheckBatch(const OptionBatch& batch, const bool& check_type = true, const bool& positive = false);
+    void CheckOption(const struct OptionData& data, const bool& check_type = true, const bool& positive = false);
+    
+    // Outputs of a checked batch with the status of each row
+    struct CheckedGreeks
+    {
+        BatchGreeks greeks;                 // Outputs selected by the mask, NaN on invalid rows
+        std::vector<unsigned char> status;  // RowStatus bits of each row, empty for trusted input
+        std::size_t invalid = 0;            // Number of invalid rows
+    };
+    
+    
     namespace European // In the European Namespace
     {
+        // Take in a batch of option data and return a vector of prices
+        // The option type of each row is taken from the type column
+        // The mode sets the accuracy of the normal CDF for the whole batch (see SimdKernel.hpp)
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Take in a batch of option data and return a vector of deltas
+        std::vector<double> MatrixDelta(const OptionBatch& batch, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Take in a batch of option data and return a vector of gammas
+        std::vector<double> MatrixGamma(const OptionBatch& batch, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Take in a batch of option data and return the price, delta, gamma, vega, theta and rho
+        // selected by the mask, all computed in one pass (see EuropeanOption::Greeks)
+        BatchGreeks MatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS,
+                                 const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        // The result is identical to MatrixPricer whatever the thread count and chunk size
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ParallelConfig& config = ParallelConfig(),
+                                                 const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as MatrixGreeks, with the batch split in chunks over a pool of threads
+        BatchGreeks ParallelMatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS,
+                                         const ParallelConfig& config = ParallelConfig(),
+                                         const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as the batch functions above, writing to caller buffers of n = batch.size() values
+        // Nothing is allocated, so a buffer reused from call to call keeps the pricing free of allocations
+        // MatrixGreeks computes the outputs whose pointer is not null
+        // Throw InvalidSizeException if n is not the size of the batch
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void MatrixDelta(const OptionBatch& batch, double* delta, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void MatrixGamma(const OptionBatch& batch, double* gamma, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void MatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                          const NormalMode& mode = HIGH_ACCURACY);
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                                  const ParallelConfig& config = ParallelConfig(), const NormalMode& mode = HIGH_ACCURACY);
+        void ParallelMatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                                  const ParallelConfig& config = ParallelConfig(), const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as MatrixGreeks for feeds that may hold bad rows, without exceptions
+        // The rows are validated first (see ValidateBatch), only the valid rows are priced and the invalid rows
+        // get NaN; MatrixGreeks instead throws on the first bad row and prices nothing
+        // With trusted set the validation is skipped and every row is priced as it is
+        CheckedGreeks CheckedMatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS,
+                                          const bool& trusted = false, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as CheckedMatrixGreeks, with the batch split in chunks over a pool of threads
+        CheckedGreeks ParallelCheckedMatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS,
+                                                  const ParallelConfig& config = ParallelConfig(),
+                                                  const bool& trusted = false, const NormalMode& mode = HIGH_ACCURACY);
+        
         // Take in a matrix of option data and return a vector of prices
         std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type = 'C');
         
@@ -38,13 +127,120 @@ namespace All_Options
         
         // Take in a matrix of option data and return a vector of gammas
         std::vector<double> MatrixGamma(const std::vector<std::vector<double>>& matrix);
+        
+        // Take in one OptionData structure, the varying factor and its range and step size
+        // Return the same prices as MatrixPricer(GenerateMatrix(data, factor, start, end, step), data.optType)
+        // without building the matrix; the terms that do not depend on the factor are computed once
+        std::vector<double> SweepPricer(const struct OptionData& data, const Factor& factor, const double& start,
+                                        const double& end, const double& step, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as SweepPricer for deltas
+        std::vector<double> SweepDelta(const struct OptionData& data, const Factor& factor, const double& start,
+                                       const double& end, const double& step, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as SweepPricer for gammas
+        std::vector<double> SweepGamma(const struct OptionData& data, const Factor& factor, const double& start,
+                                       const double& end, const double& step, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as SweepPricer for the price and sensitivities selected by the mask
+        BatchGreeks SweepGreeks(const struct OptionData& data, const Factor& factor, const double& start,
+                                const double& end, const double& step, const unsigned& mask = ALL_GREEKS,
+                                const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Same as the sweep functions above, writing to caller buffers of n = SweepSize(start, end, step) values
+        // Throw InvalidSizeException if n is not the number of values
+        void SweepPricer(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                         const double& step, double* price, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void SweepDelta(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                        const double& step, double* delta, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void SweepGamma(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                        const double& step, double* gamma, const std::size_t& n, const NormalMode& mode = HIGH_ACCURACY);
+        void SweepGreeks(const struct OptionData& data, const Factor& factor, const double& start, const double& end,
+                         const double& step, const Simd::KernelOutput& out, const std::size_t& n,
+                         const NormalMode& mode = HIGH_ACCURACY);
     }
     
     namespace PerpetualAmerican // In the PerpetualAmerican Namespace
     {
+        // Take in a batch of option data and return a vector of prices
+        // The option type of each row is taken from the type column
+        std::vector<double> MatrixPricer(const OptionBatch& batch);
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        // The result is identical to MatrixPricer whatever the thread count and chunk size
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ParallelConfig& config = ParallelConfig());
+        
+        // Take in a batch of option data and return the price, delta, gamma, vega, theta and rho
+        // selected by the mask, all computed in one pass (see PerpetualAmericanOption::ExponentGreeks)
+        BatchGreeks MatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS);
+        
+        // Same as MatrixGreeks, with the batch split in chunks over a pool of threads
+        BatchGreeks ParallelMatrixGreeks(const OptionBatch& batch, const unsigned& mask = ALL_GREEKS,
+                                         const ParallelConfig& config = ParallelConfig());
+        
+        // Same as above, writing to caller buffers of n = batch.size() values without allocating
+        // MatrixGreeks computes the outputs whose pointer is not null
+        // Throw InvalidSizeException if n is not the size of the batch
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n);
+        void MatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n);
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                                  const ParallelConfig& config = ParallelConfig());
+        void ParallelMatrixGreeks(const OptionBatch& batch, const Simd::KernelOutput& out, const std::size_t& n,
+                                  const ParallelConfig& config = ParallelConfig());
+        
         // Take in a matrix of option data and return a vector of prices
         std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type = 'C');
     }
+    
+    namespace American // In the American Namespace
+    {
+        // Take in a batch of option data and return a vector of American prices by the given approximation
+        // The option type of each row is taken from the type column. The boundary terms are computed again
+        // only when T, sig, r, b or the type change from one row to the next, so a batch sorted by expiry
+        // and underlying solves each boundary once
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const AmericanMethod& method = BJERKSUND_STENSLAND);
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        // The result is identical to MatrixPricer whatever the thread count and chunk size
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const AmericanMethod& method = BJERKSUND_STENSLAND,
+                                                 const ParallelConfig& config = ParallelConfig());
+        
+        // Same as above, writing to a caller buffer of n = batch.size() values without allocating
+        // Throw InvalidSizeException if n is not the size of the batch
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                          const AmericanMethod& method = BJERKSUND_STENSLAND);
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                                  const AmericanMethod& method = BJERKSUND_STENSLAND,
+                                  const ParallelConfig& config = ParallelConfig());
+        
+        // Take in a matrix of option data and return a vector of prices
+        std::vector<double> MatrixPricer(const std::vector<std::vector<double>>& matrix, const char& type = 'C',
+                                         const AmericanMethod& method = BJERKSUND_STENSLAND);
+    }
+    
+    namespace Lattice // In the Lattice Namespace
+    {
+        // Take in a batch of option data and return a vector of tree prices with the given style and settings
+        // The option type of each row is taken from the type column. The rows share the step count, so they are
+        // rolled back in lockstep by the vectorized kernel (see Simd::LatticeKernel)
+        // Throw InvalidValueException if the settings have no steps, or fewer than 2 for BBS_RICHARDSON
+        std::vector<double> MatrixPricer(const OptionBatch& batch, const ExerciseStyle& style = AMERICAN_EXERCISE,
+                                         const LatticeConfig& config = LatticeConfig());
+        
+        // Same as MatrixPricer, with the batch split in chunks over a pool of threads
+        // The result is identical to MatrixPricer whatever the thread count and chunk size
+        std::vector<double> ParallelMatrixPricer(const OptionBatch& batch, const ExerciseStyle& style = AMERICAN_EXERCISE,
+                                                 const LatticeConfig& config = LatticeConfig(),
+                                                 const ParallelConfig& parallel = ParallelConfig());
+        
+        // Same as above, writing to a caller buffer of n = batch.size() values without allocating
+        // Throw InvalidSizeException if n is not the size of the batch
+        void MatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                          const ExerciseStyle& style = AMERICAN_EXERCISE, const LatticeConfig& config = LatticeConfig());
+        void ParallelMatrixPricer(const OptionBatch& batch, double* price, const std::size_t& n,
+                                  const ExerciseStyle& style = AMERICAN_EXERCISE, const LatticeConfig& config = LatticeConfig(),
+                                  const ParallelConfig& parallel = ParallelConfig());
+    }
 }
 
 #endif
@@ -13,6 +13,40 @@
 
 namespace All_Options
 {
+    // Convert a factor name ("T", "K", "sig", "r", "b", "S", any case) to a Factor
+    Factor ParseFactor(const std::string& factor)
+    {
+        std::string str = boost::to_upper_copy<std::string>(factor);
+        if (str == "T")   return Factor::T;
+        if (str == "K")   return Factor::K;
+        if (str == "SIG") return Factor::SIG;
+        if (str == "R")   return Factor::R;
+        if (str == "B")   return Factor::B;
+        if (str == "S")   return Factor::S;
+        throw InvalidFactorException(factor);
+    }
+    
+    // Name of a factor ("T", "K", "sig", "r", "b" or "S")
+    std::string FactorName(const Factor& factor)
+    {
+        static const char* names[6] = { "T", "K", "sig", "r", "b", "S" };
+        return names[static_cast<int>(factor)];
+    }
+    
+    // Number of values from start to end with the given step
+    std::size_t SweepSize(const double& start, const double& end, const double& step)
+    {
+        if (((end - start) < 0 && step >= 0) || ((end - start) > 0 && step <= 0) || step == 0)
+            throw InvalidStepException(step, start, end);
+        
+        // Count with the same accumulation as the functions filling the values
+        int direction = (end > start)? 1:-1;
+        std::size_t n = 0;
+        for (double i = start; (i - end) * direction <= 0; i += step)
+            n++;
+        return n;
+    }
+    
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////Checking Functions//////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,9 +72,7 @@ namespace All_Options
     void Option::CheckFactorName(const std::string& factor) const
     {
         // Check if the name of the factor is valid. If not throw exception
-        std::string str = boost::to_upper_copy<std::string>(factor);
-        if (str != "R" && str != "T" && str != "K" && str != "B" && str != "S" && str != "SIG")
-            throw InvalidFactorException(factor);
+        ParseFactor(factor);
     }
     
     // Check whether the step works for the varying range of a factor
@@ -155,6 +187,13 @@ namespace All_Options
         return data;
     }
     
+    // Copy the factors into an array indexed by Factor (T, K, sig, r, b, S)
+    void Option::FactorArray(double (&factors)[6]) const
+    {
+        factors[0] = data.T; factors[1] = data.K; factors[2] = data.sig;
+        factors[3] = data.r; factors[4] = data.b; factors[5] = data.S;
+    }
+    
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////////
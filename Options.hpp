@@ -71,13 +71,17 @@ namespace All_Options
         // Get the OptionData structure
         const struct OptionData& get_data() const;
         
+        // Copy the factors into an array indexed by Factor (T, K, sig, r, b, S)
+        void FactorArray(double (&factors)[6]) const;
+        
         ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
         
         // Set the data of the object
-        void set_data(const struct OptionData& data);
+        // Virtual so that derived classes keeping terms of the data (see EuropeanOption) can drop them
+        virtual void set_data(const struct OptionData& data);
         
         // Change option type (C/P, P/C)
-        void toggle();
+        virtual void toggle();
     };
 }
 
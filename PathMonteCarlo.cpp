@@ -0,0 +1,545 @@
+//  PathMonteCarlo.cpp
+//  Monte Carlo pricing of Asian and barrier options.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "PathMonteCarlo.hpp"
+#include "EuropeanOption.hpp"
+#include "NormalDistribution.hpp"
+#include "SimdKernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        // Paths built together in the time-major arrays
+        static const std::size_t LANES = 64;
+        
+        // One step of the Brownian bridge: W[index] = wl * W[left] + wr * W[right] + sd * z
+        // (rows 0 .. n - 1 are the dates, row n is W(0) = 0)
+        struct BridgeStep
+        {
+            std::size_t index, left, right;
+            double wl, wr, sd;
+        };
+        
+        // Buffers of one thread, kept between blocks and calls so that they are allocated once
+        struct PathArena
+        {
+            std::vector<double> z;              // Normal numbers of the lanes, z[d * LANES + p] for dimension d
+            std::vector<double> w;              // Brownian motion on the dates, w[t * LANES + p], and a row of 0
+            std::vector<double> sum, logsum;    // Sum of the prices and of their logs on the dates
+            std::vector<double> y, c;           // Payoff and control of the lanes, summed over the antithetic pair
+            std::vector<double> hit;            // 1 once the barrier was touched, else 0
+            
+            // Make room for paths of n dates
+            void Reserve(const std::size_t& n)
+            {
+                if (z.size() < n * LANES) z.resize(n * LANES);
+                if (w.size() < (n + 1) * LANES) w.resize((n + 1) * LANES);
+                if (sum.size() < LANES)
+                {
+                    sum.resize(LANES); logsum.resize(LANES);
+                    y.resize(LANES); c.resize(LANES);
+                    hit.resize(LANES);
+                }
+            }
+        };
+        
+        // Arena of the calling thread
+        static PathArena& LocalArena()
+        {
+            static thread_local PathArena arena;
+            return arena;
+        }
+        
+        // Terms of one simulation, kept by the thread that runs Simulate so that a sweep allocates them once
+        struct PathSetup
+        {
+            std::vector<double> mu;                 // Drift of the log price on the dates
+            std::vector<BridgeStep> bridge;         // Steps of the Brownian bridge
+            std::vector<std::size_t> left, right;   // Intervals of dates still to fill while building the bridge
+            std::vector<SampleMoments> moments;     // Moments of the blocks
+        };
+        
+        // Setup of the calling thread
+        static PathSetup& LocalSetup()
+        {
+            static thread_local PathSetup setup;
+            return setup;
+        }
+        
+        // Steps of the Brownian bridge on the dates (t + 1) * T / n, t = 0 .. n - 1: the last date first,
+        // then the middles of the intervals, coarsest first
+        static void BuildBridge(const std::size_t& n, const double& T, PathSetup& setup)
+        {
+            auto time = [&](const std::size_t& row) { return (row == n)? 0.0 : (row + 1) * T / n; };
+            std::vector<BridgeStep>& steps = setup.bridge;
+            steps.clear();
+            
+            BridgeStep last = { n - 1, n, n, 0.0, 0.0, sqrt(T) };
+            steps.push_back(last);
+            
+            // Intervals (left, right) of dates still to fill, row n standing for time 0
+            std::vector<std::size_t> &left = setup.left, &right = setup.right;
+            left.assign(1, n);
+            right.assign(1, n - 1);
+            for (std::size_t k = 0; k < left.size(); k++)
+            {
+                std::size_t l = left[k], r = right[k];
+                std::size_t first = (l == n)? 0 : l + 1;
+                if (r <= first) continue;
+                std::size_t m = first + (r - first - 1) / 2;
+                double tl = time(l), tm = time(m), tr = time(r);
+                BridgeStep step = { m, l, r, (tr - tm) / (tr - tl), (tm - tl) / (tr - tl), sqrt((tm - tl) * (tr - tm) / (tr - tl)) };
+                steps.push_back(step);
+                left.push_back(l); right.push_back(m);
+                left.push_back(m); right.push_back(r);
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Price Formula////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price of a geometric Asian option on n equally spaced fixing dates
+        double PathDependentOption::GeometricAsianPrice(const double& T, const double& K, const double& sig, const double& r,
+                                                        const double& b, const double& S, const std::size_t& n, const bool& call)
+        {
+            double w = call? 1.0 : -1.0, df = exp(-r * T);
+            double mean = (b - 0.5 * sig * sig) * T * (n + 1) / (2.0 * n);
+            double var = sig * sig * T * (n + 1) * (2.0 * n + 1) / (6.0 * n * n);
+            
+            // Forward of the average, priced with Black's formula
+            double F = S * exp(mean + 0.5 * var);
+            if (var == 0 || S == 0)
+                return df * std::max(w * (F - K), 0.0);
+            
+            double v = sqrt(var), d1 = (log(F / K) + 0.5 * var) / v, d2 = d1 - v;
+            return df * w * (F * NormalCdf(w * d1) - K * NormalCdf(w * d2));
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////Private Price Calculator/////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Simulate the option for factors indexed by Factor
+        MonteCarloResult PathDependentOption::Simulate(const double (&f)[6], const ParallelConfig& parallel) const
+        {
+            const double &T = f[0], &K = f[1], &sig = f[2], &r = f[3], &b = f[4], &S = f[5];
+            const std::size_t& n = config.steps;
+            bool call = (data.optType == 'C'), barrier = (payoff.type == BARRIER);
+            bool knock_in = (payoff.barrier == DOWN_AND_IN || payoff.barrier == UP_AND_IN);
+            double w = call? 1.0 : -1.0, df = exp(-r * T);
+            
+            // The barrier is touched when side * (level - price) >= 0
+            double side = (payoff.barrier == DOWN_AND_OUT || payoff.barrier == DOWN_AND_IN)? 1.0 : -1.0;
+            const double& level = payoff.level;
+            
+            // Discounted payoff of a path from the sum and log sum of its prices, its last price and the barrier
+            auto value = [&](const double& sum, const double& logsum, const double& last, const bool& hit)
+            {
+                switch (payoff.type)
+                {
+                    case ARITHMETIC_ASIAN: return df * std::max(w * (sum / n - K), 0.0);
+                    case GEOMETRIC_ASIAN:  return df * std::max(w * (exp(logsum / n) - K), 0.0);
+                    default:               return (hit == knock_in)? df * std::max(w * (last - K), 0.0) : 0.0;
+                }
+            };
+            
+            // Without randomness the price grows at the rate b for sure
+            if (T == 0 || sig == 0 || S == 0)
+            {
+                MonteCarloResult result;
+                bool hit = barrier && side * (level - S) >= 0;
+                double sum = 0, last = S;
+                for (std::size_t t = 0; t < n; t++)
+                {
+                    last = S * exp(b * (t + 1) * T / n);
+                    sum += last;
+                    hit = hit || (barrier && side * (level - last) >= 0);
+                }
+                double geometric = (S == 0)? 0.0 : S * exp(b * T * (n + 1) / (2.0 * n));
+                result.price = (payoff.type == GEOMETRIC_ASIAN)? df * std::max(w * (geometric - K), 0.0)
+                                                               : value(sum, 0.0, last, hit);
+                return result;
+            }
+            
+            // Log price log(S) + mu[t] + sig * W on the dates, and the mean of the control
+            PathSetup& setup = LocalSetup();
+            std::vector<double>& mu = setup.mu;
+            mu.resize(n);
+            for (std::size_t t = 0; t < n; t++)
+                mu[t] = (b - 0.5 * sig * sig) * (t + 1) * T / n;
+            double logS = log(S);
+            double mean_c = 0;
+            if (config.control == UNDERLYING_CONTROL)
+                mean_c = S * exp((b - r) * T);
+            else if (config.control == EUROPEAN_CONTROL)
+            {
+                OptionData vanilla = data;
+                vanilla.T = T; vanilla.K = K; vanilla.sig = sig; vanilla.r = r; vanilla.b = b; vanilla.S = S;
+                mean_c = European::EuropeanOption(vanilla).Price();
+            }
+            else if (config.control == GEOMETRIC_ASIAN_CONTROL)
+                mean_c = GeometricAsianPrice(T, K, sig, r, b, S, n, call);
+            
+            BuildBridge(n, T, setup);
+            const std::vector<BridgeStep>& bridge = setup.bridge;
+            
+            // One sample is a pair of paths with antithetic variates; a Sobol run is cut into replications
+            // of the same size, each cut into blocks
+            bool sobol = (config.source == SOBOL);
+            std::size_t sobol_dimensions = std::min(n, SobolSequence::MAX_DIMENSIONS);
+            std::size_t samples = config.antithetic? (config.paths + 1) / 2 : config.paths;
+            std::size_t replications = sobol? std::max<std::size_t>(config.replications, 1) : 1;
+            std::size_t per_replication = (samples + replications - 1) / replications;
+            std::size_t blocks_per_replication = (per_replication + config.block - 1) / config.block;
+            std::vector<SampleMoments>& moments = setup.moments;
+            moments.assign(replications * blocks_per_replication, SampleMoments());
+            
+            std::uint32_t key[2] = { static_cast<std::uint32_t>(config.seed), static_cast<std::uint32_t>(config.seed >> 32) };
+            
+            // Every block only depends on its index, so the blocks can run on any thread in any order
+            auto chunk = [&](std::size_t begin, std::size_t end)
+            {
+                PathArena& arena = LocalArena();
+                arena.Reserve(n);
+                double *z = arena.z.data(), *W = arena.w.data();
+                double *sum = arena.sum.data(), *logsum = arena.logsum.data(), *y = arena.y.data(), *c = arena.c.data();
+                double* hit = arena.hit.data();
+                for (std::size_t p = 0; p < LANES; p++)
+                    W[n * LANES + p] = 0;
+                
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    std::size_t replication = k / blocks_per_replication;
+                    std::size_t first = (k % blocks_per_replication) * config.block;
+                    std::size_t last = std::min(first + config.block, per_replication);
+                    SampleMoments m;
+                    
+                    // Digital shifts of the dimensions of the replication
+                    std::uint32_t shift[SobolSequence::MAX_DIMENSIONS] = {};
+                    SobolSequence sequence(sobol_dimensions);
+                    if (sobol)
+                    {
+                        for (std::size_t d = 0; d < sobol_dimensions; d++)
+                        {
+                            std::uint32_t counter[4] = { static_cast<std::uint32_t>(replication), 0, static_cast<std::uint32_t>(d), 1 }, bits[4];
+                            Philox::Block(counter, key, bits);
+                            shift[d] = bits[0];
+                        }
+                        sequence.Seek(first);
+                    }
+                    
+                    for (std::size_t i0 = first; i0 < last; i0 += LANES)
+                    {
+                        std::size_t lanes = std::min(LANES, last - i0);
+                        
+                        // Uniform numbers of the lanes: the Sobol point, then Philox for the dimensions past it
+                        // (Philox gives the numbers of two dimensions per counter)
+                        for (std::size_t p = 0; p < lanes; p++)
+                        {
+                            std::uint64_t i = i0 + p;
+                            std::size_t d = 0;
+                            if (sobol)
+                            {
+                                const std::uint32_t* point = sequence.Next();
+                                for (; d < sobol_dimensions; d++)
+                                    z[d * LANES + p] = SobolSequence::Uniform(point[d], shift[d]);
+                            }
+                            std::uint32_t stream = sobol? static_cast<std::uint32_t>(2 + replication) : 0;
+                            for (; d < n; d += 2)
+                            {
+                                std::uint32_t counter[4] = { static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i >> 32),
+                                                             static_cast<std::uint32_t>(d / 2), stream }, bits[4];
+                                Philox::Block(counter, key, bits);
+                                z[d * LANES + p] = Philox::Uniform(bits[0], bits[1]);
+                                if (d + 1 < n)
+                                    z[(d + 1) * LANES + p] = Philox::Uniform(bits[2], bits[3]);
+                            }
+                        }
+                        
+                        // Normal numbers, one dimension for all lanes at a time
+                        for (std::size_t d = 0; d < n; d++)
+                            Simd::InverseNormalKernel(z + d * LANES, z + d * LANES, lanes);
+                        
+                        for (std::size_t p = 0; p < lanes; p++)
+                            y[p] = c[p] = 0;
+                        
+                        // The path of z, then the path of -z
+                        for (int pass = 0; pass < (config.antithetic? 2 : 1); pass++)
+                        {
+                            double sign = (pass == 0)? 1.0 : -1.0;
+                            
+                            // Brownian bridge, one date for all lanes at a time
+                            for (std::size_t j = 0; j < bridge.size(); j++)
+                            {
+                                const BridgeStep& s = bridge[j];
+                                double *Wi = W + s.index * LANES, *zj = z + j * LANES;
+                                const double *Wl = W + s.left * LANES, *Wr = W + s.right * LANES;
+                                double sd = sign * s.sd;
+                                for (std::size_t p = 0; p < lanes; p++)
+                                    Wi[p] = s.wl * Wl[p] + s.wr * Wr[p] + sd * zj[p];
+                            }
+                            
+                            // Prices on the dates, one date for all lanes at a time
+                            for (std::size_t p = 0; p < lanes; p++)
+                            {
+                                sum[p] = logsum[p] = 0;
+                                hit[p] = (barrier && side * (level - S) >= 0)? 1.0 : 0.0;
+                            }
+                            for (std::size_t t = 0; t < n; t++)
+                                Simd::PathDateKernel(W + t * LANES, logS + mu[t], sig, lanes, barrier, side, level, sum, logsum, hit);
+                            
+                            // Payoff and control of the lanes
+                            const double* WT = W + (n - 1) * LANES;
+                            for (std::size_t p = 0; p < lanes; p++)
+                            {
+                                double ST = exp(logS + mu[n - 1] + sig * WT[p]);
+                                y[p] += value(sum[p], logsum[p], ST, hit[p] != 0);
+                                switch (config.control)
+                                {
+                                    case UNDERLYING_CONTROL:      c[p] += df * ST; break;
+                                    case EUROPEAN_CONTROL:        c[p] += df * std::max(w * (ST - K), 0.0); break;
+                                    case GEOMETRIC_ASIAN_CONTROL: c[p] += df * std::max(w * (exp(logsum[p] / n) - K), 0.0); break;
+                                    default:                      break;
+                                }
+                            }
+                        }
+                        
+                        double scale = config.antithetic? 0.5 : 1.0;
+                        for (std::size_t p = 0; p < lanes; p++)
+                            m.Add(scale * y[p], scale * c[p]);
+                    }
+                    moments[k] = m;
+                }
+            };
+            ThreadPool& pool = parallel.pool? *parallel.pool : ThreadPool::Shared();
+            pool.ParallelFor(moments.size(), 1, chunk, parallel.threads);
+            
+            // Rounding per_replication up can simulate a few more samples than asked for
+            MonteCarloResult result = Summarize(moments, replications, mean_c, config, replications * per_replication);
+            return result;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Constructors/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Default PathDependentOption constructor
+        PathDependentOption::PathDependentOption(): Option(), payoff(), config() {}
+        
+        // Copy option
+        PathDependentOption::PathDependentOption(const PathDependentOption& o2): Option(o2), payoff(o2.payoff), config(o2.config) {}
+        
+        // Create an option of certain type
+        PathDependentOption::PathDependentOption(const char& optionType, const PathPayoff& p, const MonteCarloConfig& c)
+        : Option(optionType), payoff(), config()
+        {
+            set_payoff(p);
+            set_config(c);
+        }
+        
+        // Create an option using given data
+        PathDependentOption::PathDependentOption(const struct OptionData& data, const PathPayoff& p, const MonteCarloConfig& c)
+        : Option(data), payoff(), config()
+        {
+            set_payoff(p);
+            set_config(c);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        PathDependentOption::~PathDependentOption() {}
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Operators/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Assignment operator
+        PathDependentOption& PathDependentOption::operator = (const PathDependentOption& option2)
+        {
+            // Return original objects if addresses are the same
+            if (this == &option2) return *this;
+            
+            Option::operator = (option2);
+            payoff = option2.payoff;
+            config = option2.config;
+            return *this;
+        }
+        
+        // Get the information of the object using <<
+        std::ostream& operator << (std::ostream& os, const PathDependentOption& op)
+        {
+            // Get the description from ToString() function
+            os << op.ToString();
+            return os;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Get the payoff
+        const PathPayoff& PathDependentOption::get_payoff() const
+        {
+            return payoff;
+        }
+        
+        // Set the payoff
+        void PathDependentOption::set_payoff(const PathPayoff& p)
+        {
+            if (p.type == BARRIER && p.level <= 0)
+                throw InvalidValueException();
+            payoff = p;
+        }
+        
+        // Get the simulation settings
+        const MonteCarloConfig& PathDependentOption::get_config() const
+        {
+            return config;
+        }
+        
+        // Set the simulation settings
+        void PathDependentOption::set_config(const MonteCarloConfig& c)
+        {
+            if (c.paths == 0 || c.block == 0 || c.steps == 0)
+                throw InvalidValueException();
+            config = c;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Price and standard error of the option
+        MonteCarloResult PathDependentOption::Simulate(const ParallelConfig& parallel) const
+        {
+            double f[6];
+            FactorArray(f);
+            return Simulate(f, parallel);
+        }
+        
+        // Calculate the price of the option
+        double PathDependentOption::Price() const
+        {
+            return Simulate().price;
+        }
+        
+        // Given a factor name and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double PathDependentOption::Price(std::string factor, const double& value) const
+        {
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor name and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> PathDependentOption::Price
+        (std::string factor, const double& start, const double& end, const double& step) const
+        {
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double PathDependentOption::Price(const Factor& factor, const double& value) const
+        {
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
+            
+            // Check if the values of parameter are valid
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
+            
+            return Simulate(f, ParallelConfig()).price;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> PathDependentOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step) const
+        {
+            // Create a vector that will store prices of different option parameters
+            std::vector<double> price_vec(SweepSize(start, end, step));
+            Price(factor, start, end, step, price_vec.data(), price_vec.size());
+            return price_vec;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void PathDependentOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffer are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the input factor
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
+            
+            // Use to determine whether the varying parameter is increasing or decreasing
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            
+            // Loop over varying options, every simulation on the same random numbers
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                // Change the value corresponding to the input factor
+                x = i;
+                
+                // Get the price and put it in the buffer
+                price[row] = Simulate(f, ParallelConfig()).price;
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        std::string PathDependentOption::ToString() const
+        {
+            // Create a stringstream
+            std::stringstream str;
+            
+            // Put the content from Options to the stringstream
+            str << "Path-Dependent Option (" << PayoffName(payoff) << ", " << config.steps << " dates, "
+                << config.paths << " paths)\n" << Option::ToString();
+            return str.str();
+        }
+        
+        // Name of a payoff
+        std::string PayoffName(const PathPayoff& payoff)
+        {
+            if (payoff.type == ARITHMETIC_ASIAN) return "arithmetic Asian";
+            if (payoff.type == GEOMETRIC_ASIAN) return "geometric Asian";
+            
+            std::stringstream str;
+            const char* names[4] = { "down-and-out", "down-and-in", "up-and-out", "up-and-in" };
+            str << names[payoff.barrier] << " barrier at " << payoff.level;
+            return str.str();
+        }
+    }
+}
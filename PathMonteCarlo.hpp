@@ -0,0 +1,146 @@
+//  PathMonteCarlo.hpp
+//  Monte Carlo pricing of path-dependent options: arithmetic and
+//  geometric Asians on equally spaced fixing dates, and knock-in or
+//  knock-out barriers monitored on the same dates. The paths of a block
+//  are built a few dozen at a time in time-major arrays (value of path
+//  p at date t in [t * lanes + p]), so every step of the construction is
+//  a loop over paths. The Brownian motion is built by a Brownian bridge,
+//  which puts most of the variance in the first normal numbers, where a
+//  Sobol sequence is the most uniform. The buffers live in an arena per
+//  thread, so nothing is allocated per path or per block.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef PathMonteCarlo_hpp
+#define PathMonteCarlo_hpp
+
+#include <cstddef>
+#include <vector>
+#include "Options.hpp"
+#include "MonteCarlo.hpp"
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        // Payoffs of path-dependent options
+        // ARITHMETIC_ASIAN, GEOMETRIC_ASIAN: the average price on the fixing dates against the strike
+        // BARRIER: the European payoff, kept or lost when the price touches the barrier on a monitoring date
+        enum PathPayoffType { ARITHMETIC_ASIAN = 0, GEOMETRIC_ASIAN = 1, BARRIER = 2 };
+        
+        // Barriers: the option dies (out) or comes alive (in) when the price falls to (down) or rises to (up) the level
+        enum BarrierType { DOWN_AND_OUT = 0, DOWN_AND_IN = 1, UP_AND_OUT = 2, UP_AND_IN = 3 };
+        
+        // Payoff of a path-dependent option
+        struct PathPayoff
+        {
+            PathPayoffType type = ARITHMETIC_ASIAN;
+            BarrierType barrier = DOWN_AND_OUT;     // Barriers only
+            double level = 0;                       // Barrier level, barriers only
+        };
+        
+        class PathDependentOption: public Option
+        {
+        private:
+            
+            // Payoff and simulation settings (config.steps is the number of fixing or monitoring dates)
+            PathPayoff payoff;
+            MonteCarloConfig config;
+            
+            // Simulate the option for factors indexed by Factor
+            MonteCarloResult Simulate(const double (&f)[6], const ParallelConfig& parallel) const;
+        
+        public:
+            
+            ///////////////////////////////////////Price Formula////////////////////////////////////////////////
+            
+            // Price of a geometric Asian option on n equally spaced fixing dates T / n, 2T / n, .. T
+            // The log of the geometric average is normal with mean log(S) + (b - sig^2 / 2) T (n + 1) / (2n)
+            // and variance sig^2 T (n + 1)(2n + 1) / (6n^2)
+            static double GeometricAsianPrice(const double& T, const double& K, const double& sig, const double& r,
+                                              const double& b, const double& S, const std::size_t& n, const bool& call);
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Default PathDependentOption constructor (arithmetic Asian)
+            PathDependentOption();
+            
+            // Copy Constructor
+            PathDependentOption(const PathDependentOption& option2);
+            
+            // Constructe an option of certain type
+            PathDependentOption(const char& optionType, const PathPayoff& payoff = PathPayoff(),
+                                const MonteCarloConfig& config = MonteCarloConfig());
+            
+            // Constructe an option using given data
+            PathDependentOption(const struct OptionData& optionData, const PathPayoff& payoff = PathPayoff(),
+                                const MonteCarloConfig& config = MonteCarloConfig());
+            
+            /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+            
+            virtual ~PathDependentOption();
+            
+            //////////////////////////////////////////Operators/////////////////////////////////////////////////
+            
+            // Assignment operator
+            PathDependentOption& operator = (const PathDependentOption& option2);
+            
+            // Get the information of the object using <<
+            friend std::ostream& operator << (std::ostream& os, const PathDependentOption& op);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Get the payoff
+            const PathPayoff& get_payoff() const;
+            
+            // Set the payoff
+            // Throw InvalidValueException if a barrier level is not positive
+            void set_payoff(const PathPayoff& payoff);
+            
+            // Get the simulation settings
+            const MonteCarloConfig& get_config() const;
+            
+            // Set the simulation settings
+            // Throw InvalidValueException if there are no paths, the block is empty or there are no dates
+            void set_config(const MonteCarloConfig& config);
+            
+            //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+            
+            // Price and standard error, with the blocks of paths split over a pool of threads
+            // The result is the same whatever the thread count
+            MonteCarloResult Simulate(const ParallelConfig& parallel = ParallelConfig()) const;
+            
+            // Calculate the price of the option
+            virtual double Price() const;
+            
+            // Given a factor name and its value, calculate the price of the option
+            // The class variable is not changed to the given value.
+            virtual double Price(std::string factor, const double& value) const;
+            
+            // Given a factor name and start, end and step of the factor
+            // Calculte the price of the option for each variable change. Output a vector of prices
+            // Every value uses the same random numbers, so the prices are smooth in the factor
+            virtual std::vector<double> Price(std::string factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            virtual double Price(const Factor& factor, const double& value) const;
+            virtual std::vector<double> Price(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) prices to a caller buffer without allocating
+            // Throw InvalidSizeException if n is not the number of values
+            void Price(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* price, const std::size_t& n) const;
+            
+            ////////////////////////////////////////Description/////////////////////////////////////////////////
+            
+            virtual std::string ToString() const;
+        };
+        
+        // Name of a payoff
+        std::string PayoffName(const PathPayoff& payoff);
+    }
+}
+
+#endif
@@ -23,20 +23,79 @@ namespace All_Options
         double PerpetualAmericanOption::CallPrice
         (const double& K, const double& sig, const double& r, const double& b, const double& S) const
         {
-            double tmp = sqrt((b/sig/sig-0.5)*(b/sig/sig-0.5) + 2*r/sig/sig);
-            double y = 0.5 - b/sig/sig + tmp;
-            return (K / (y - 1)) * pow( ( (y-1) * S / K / y ), y);
+            return ExponentPrice(K, S, Exponent(sig, r, b, true), true);
         }
         
         // Calculate Put Price
         double PerpetualAmericanOption::PutPrice
         (const double& K, const double& sig, const double& r, const double& b, const double& S) const
+        {
+            return ExponentPrice(K, S, Exponent(sig, r, b, false), false);
+        }
+        
+        // Exponent y of the call or put price, which depends on sig, r and b only
+        double PerpetualAmericanOption::Exponent(const double& sig, const double& r, const double& b, const bool& call)
         {
             double tmp = sqrt((b/sig/sig-0.5)*(b/sig/sig-0.5) + 2*r/sig/sig);
-            double y = 0.5 - b/sig/sig - tmp;
+            if (call)
+                return 0.5 - b/sig/sig + tmp;
+            return 0.5 - b/sig/sig - tmp;
+        }
+        
+        // Call or put price from the exponent y
+        double PerpetualAmericanOption::ExponentPrice(const double& K, const double& S, const double& y, const bool& call)
+        {
+            if (call)
+                return (K / (y - 1)) * pow( ( (y-1) * S / K / y ), y);
             return (K / (1 - y)) * pow( ( (y-1) * S / K / y ), y);
         }
         
+        // Exponent y of the call or put price with its derivatives in sig and r (b fixed)
+        PerpetualExponent PerpetualAmericanOption::ExponentTerms
+        (const double& sig, const double& r, const double& b, const bool& call)
+        {
+            // y = 0.5 - b/sig^2 +/- tmp with tmp = sqrt((b/sig^2 - 0.5)^2 + 2r/sig^2)
+            double w = call? 1.0 : -1.0;
+            double q = b/sig/sig - 0.5;
+            double tmp = sqrt(q*q + 2*r/sig/sig);
+            
+            PerpetualExponent e;
+            e.y = Exponent(sig, r, b, call);
+            e.dy_dsig = 2 / (sig*sig*sig) * (b - w * (b*q + r) / tmp);
+            e.dy_dr = w / (sig*sig*tmp);
+            return e;
+        }
+        
+        // Price and sensitivities selected by the mask from the exponent terms, in one pass
+        OptionGreeks PerpetualAmericanOption::ExponentGreeks
+        (const double& K, const double& S, const PerpetualExponent& e, const bool& call, const unsigned& mask)
+        {
+            OptionGreeks greeks;
+            const double& y = e.y;
+            
+            // Every output is a multiple of the price
+            double x = (y-1) * S / K / y;
+            double price = (call? K / (y - 1) : K / (1 - y)) * pow(x, y);
+            
+            if (mask & PRICE)
+                greeks.price = price;
+            if (mask & DELTA)
+                greeks.delta = y * price / S;
+            if (mask & GAMMA)
+                greeks.gamma = y * (y - 1) * price / S / S;
+            if (mask & (VEGA | RHO))
+            {
+                // dV/dy = V log(x)
+                double dv = price * log(x);
+                if (mask & VEGA)
+                    greeks.vega = dv * e.dy_dsig;
+                if (mask & RHO)
+                    greeks.rho = dv * e.dy_dr;
+            }
+            
+            return greeks;
+        }
+        
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////Constructors/////////////////////////////////////////////////
         ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,78 +158,275 @@ namespace All_Options
         // The class variable is not changed to the given value.
         double PerpetualAmericanOption::Price(std::string factor, const double& value) const
         {
-            // Check if the input string matches any of the factors' name
-            CheckFactorName(factor);
-            
-            // Get all factors in a map
-            std::map<std::string, double> mp = Factors();
-            
-            // Change the factor to upper case
-            boost::to_upper<std::string>(factor);
+            return Price(ParseFactor(factor), value);
+        }
+        
+        
+        // Given a factor name and start, end and step of the factor
+        // Calculte the price of the option for each variable change. Output a vector of prices
+        std::vector<double> PerpetualAmericanOption::Price
+        (std::string factor, const double& start, const double& end, const double& step) const
+        {
+            return Price(ParseFactor(factor), start, end, step);
+        }
+        
+        
+        // Given a factor and its value, calculate the price of the option
+        // The class variable is not changed to the given value.
+        double PerpetualAmericanOption::Price(const Factor& factor, const double& value) const
+        {
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
             
-            // Change the value corresponding to the input factor name
-            mp[factor] = value;
+            // Change the value corresponding to the input factor
+            f[static_cast<int>(factor)] = value;
             
             // Check if the values of parameter are valid
-            CheckFactorValue(mp["T"], mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]);
+            CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
             
             // Get the price
             if (data.optType == 'C')
-                return CallPrice(mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]);
-            return PutPrice(mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]);
+                return CallPrice(f[1], f[2], f[3], f[4], f[5]);
+            return PutPrice(f[1], f[2], f[3], f[4], f[5]);
         }
         
         
-        // Given a factor name and start, end and step of the factor
+        // Given a factor and start, end and step of the factor
         // Calculte the price of the option for each variable change. Output a vector of prices
         std::vector<double> PerpetualAmericanOption::Price
-        (std::string factor, const double& start, const double& end, const double& step) const
+        (const Factor& factor, const double& start, const double& end, const double& step) const
         {
-            // Check if the input string matches any of the factors' name
-            CheckFactorName(factor);
-            // Check whether the step is valid
-            CheckStep(start, end, step);
-            
-            // Change the factor to upper case
-            boost::to_upper<std::string>(factor);
+            // Create a vector that will store prices of different option parameters
+            std::vector<double> price_vec(SweepSize(start, end, step));
+            Price(factor, start, end, step, price_vec.data(), price_vec.size());
+            return price_vec;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the price of the option for each variable change to a buffer of n values
+        void PerpetualAmericanOption::Price
+        (const Factor& factor, const double& start, const double& end, const double& step, double* price, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffer are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
             
             // Check the value of the input factor
-            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == "K"))
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
                 throw InvalidValueException();
             
-            // Get all factors in a map
-            std::map<std::string, double> mp = Factors();
-            
-            // Create a vector that will store prices of different option parameters
-            std::vector<double> price_vec;
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
             
             // Use to determine whether the varying parameter is increasing or decreasing
             int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
             
             if (data.optType == 'C')
             {
                 // Loop over varying options
-                for (double i = start; (i - end) * direction <= 0; i += step)
+                for (double i = start; (i - end) * direction <= 0; i += step, row++)
                 {
-                    // Change the value corresponding to the input factor name
-                    mp[factor] = i;
-                    // Get the price and put it in the vector
-                    price_vec.push_back(CallPrice(mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]));
+                    // Change the value corresponding to the input factor
+                    x = i;
+                    // Get the price and put it in the buffer
+                    price[row] = CallPrice(f[1], f[2], f[3], f[4], f[5]);
                 }
             }
             else
             {
                 // Loop over varying options
-                for (double i = start; (i - end) * direction <= 0; i += step)
+                for (double i = start; (i - end) * direction <= 0; i += step, row++)
+                {
+                    // Change the value corresponding to the input factor
+                    x = i;
+                    // Get the price and put it in the buffer
+                    price[row] = PutPrice(f[1], f[2], f[3], f[4], f[5]);
+                }
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////Greeks Getters////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Calculate the delta of the option
+        double PerpetualAmericanOption::Delta() const
+        {
+            return Greeks(DELTA).delta;
+        }
+        
+        // Calculate the gamma of the option
+        double PerpetualAmericanOption::Gamma() const
+        {
+            return Greeks(GAMMA).gamma;
+        }
+        
+        // Calculate the price, delta, gamma, vega, theta and rho selected by the mask in one pass
+        OptionGreeks PerpetualAmericanOption::Greeks(const unsigned& mask) const
+        {
+            bool call = (data.optType == 'C');
+            return ExponentGreeks(data.K, data.S, ExponentTerms(data.sig, data.r, data.b, call), call, mask);
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Calculate the outputs selected by the mask for each variable change
+        BatchGreeks PerpetualAmericanOption::Greeks
+        (const Factor& factor, const double& start, const double& end, const double& step, const unsigned& mask) const
+        {
+            std::size_t n = SweepSize(start, end, step);
+            
+            // Size only the vectors in the mask, the others stay empty
+            BatchGreeks greeks;
+            Simd::KernelOutput out;
+            if (mask & PRICE) { greeks.price.resize(n); out.price = greeks.price.data(); }
+            if (mask & DELTA) { greeks.delta.resize(n); out.delta = greeks.delta.data(); }
+            if (mask & GAMMA) { greeks.gamma.resize(n); out.gamma = greeks.gamma.data(); }
+            if (mask & VEGA)  { greeks.vega.resize(n);  out.vega = greeks.vega.data(); }
+            if (mask & THETA) { greeks.theta.resize(n); out.theta = greeks.theta.data(); }
+            if (mask & RHO)   { greeks.rho.resize(n);   out.rho = greeks.rho.data(); }
+            
+            Greeks(factor, start, end, step, out, n);
+            return greeks;
+        }
+        
+        
+        // Given a factor and start, end and step of the factor
+        // Write the outputs with a non-null pointer for each variable change to buffers of n values
+        void PerpetualAmericanOption::Greeks
+        (const Factor& factor, const double& start, const double& end, const double& step,
+         const Simd::KernelOutput& out, const std::size_t& n) const
+        {
+            // Check whether the step and the size of the buffers are valid
+            std::size_t points = SweepSize(start, end, step);
+            if (n != points)
+                throw InvalidSizeException(points, n);
+            
+            // Check the value of the input factor
+            if ((end < 0 || start < 0) || ((end == 0 || start ==0) && factor == Factor::K))
+                throw InvalidValueException();
+            
+            // Output columns in mask bit order
+            double* const dst[6] = { out.price, out.delta, out.gamma, out.vega, out.theta, out.rho };
+            unsigned mask = 0;
+            for (unsigned k = 0; k < 6; k++)
+                if (dst[k]) mask |= 1u << k;
+            
+            // Get all factors in an array indexed by Factor
+            double f[6];
+            FactorArray(f);
+            double& x = f[static_cast<int>(factor)];
+            bool call = (data.optType == 'C');
+            
+            // The exponent terms only depend on sig, r and b
+            bool fixed_exponent = (factor != Factor::SIG && factor != Factor::R && factor != Factor::B);
+            PerpetualExponent e = ExponentTerms(f[2], f[3], f[4], call);
+            
+            // Use to determine whether the varying parameter is increasing or decreasing
+            int direction = (end > start)? 1:-1;
+            std::size_t row = 0;
+            
+            // Loop over varying options
+            for (double i = start; (i - end) * direction <= 0; i += step, row++)
+            {
+                // Change the value corresponding to the input factor
+                x = i;
+                if (!fixed_exponent)
+                    e = ExponentTerms(f[2], f[3], f[4], call);
+                
+                OptionGreeks g = ExponentGreeks(f[1], f[5], e, call, mask);
+                const double values[6] = { g.price, g.delta, g.gamma, g.vega, g.theta, g.rho };
+                for (unsigned k = 0; k < 6; k++)
+                    if (dst[k]) dst[k][row] = values[k];
+            }
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////Surfaces//////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Serve for Surface() and ParallelSurface(), run on the pool if one is given
+        OptionSurface PerpetualAmericanOption::BuildSurface
+        (const SurfaceAxis& rows, const SurfaceAxis& cols, ThreadPool* pool, const ParallelConfig& config) const
+        {
+            OptionSurface surface;
+            PrepareSurface(surface, rows, cols);
+            std::size_t width = surface.col_values.size();
+            bool call = (data.optType == 'C');
+            
+            // Check the factors at both ends of each axis; y divides by sig, so sig has to be larger than 0
+            const SurfaceAxis* axes[2] = { &rows, &cols };
+            for (int a = 0; a < 2; a++)
+            {
+                double ends[2] = { axes[a]->start, axes[a]->end };
+                for (int e = 0; e < 2; e++)
                 {
-                    // Change the value corresponding to the input factor name
-                    mp[factor] = i;
-                    // Get the price and put it in the vector
-                    price_vec.push_back(PutPrice(mp["K"], mp["SIG"], mp["R"], mp["B"], mp["S"]));
+                    double f[6];
+                    FactorArray(f);
+                    f[static_cast<int>(axes[a]->factor)] = ends[e];
+                    CheckFactorValue(f[0], f[1], f[2], f[3], f[4], f[5]);
+                    if (!(f[static_cast<int>(Factor::SIG)] > 0))
+                        throw InvalidValueException();
                 }
             }
             
-            return price_vec;
+            // The exponent y only depends on sig, r and b, so it is computed once per row
+            // unless the columns vary one of them
+            bool row_exponent = (cols.factor != Factor::SIG && cols.factor != Factor::R && cols.factor != Factor::B);
+            
+            auto tile = [&](std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end)
+            {
+                double f[6];
+                FactorArray(f);
+                double& x = f[static_cast<int>(cols.factor)];
+                for (std::size_t i = row_begin; i < row_end; i++)
+                {
+                    f[static_cast<int>(rows.factor)] = surface.row_values[i];
+                    double* out = surface.values.data() + i * width;
+                    if (row_exponent)
+                    {
+                        double y = Exponent(f[2], f[3], f[4], call);
+                        for (std::size_t j = col_begin; j < col_end; j++)
+                        {
+                            x = surface.col_values[j];
+                            out[j] = ExponentPrice(f[1], f[5], y, call);
+                        }
+                    }
+                    else
+                    {
+                        for (std::size_t j = col_begin; j < col_end; j++)
+                        {
+                            x = surface.col_values[j];
+                            out[j] = ExponentPrice(f[1], f[5], Exponent(f[2], f[3], f[4], call), call);
+                        }
+                    }
+                }
+            };
+            ForEachTile(surface, tile, pool, config);
+            
+            return surface;
+        }
+        
+        
+        // Calculate the price over a grid of two factors
+        OptionSurface PerpetualAmericanOption::Surface(const SurfaceAxis& rows, const SurfaceAxis& cols) const
+        {
+            return BuildSurface(rows, cols, 0, ParallelConfig());
+        }
+        
+        
+        // Same as Surface, with the tiles of the grid split over a pool of threads
+        OptionSurface PerpetualAmericanOption::ParallelSurface
+        (const SurfaceAxis& rows, const SurfaceAxis& cols, const ParallelConfig& config) const
+        {
+            ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+            return BuildSurface(rows, cols, &pool, config);
         }
         
         ////////////////////////////////////////////////////////////////////////////////////////////////////
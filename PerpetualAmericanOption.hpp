@@ -10,12 +10,24 @@
 #ifndef PerpetualAmericanOption_hpp
 #define PerpetualAmericanOption_hpp
 
+#include "Greeks.hpp"
 #include "Options.hpp"
+#include "SimdKernel.hpp"
+#include "Surface.hpp"
 
 namespace All_Options
 {
     namespace PerpetualAmerican
     {
+        // Exponent y of the price and its derivatives in sig and r
+        // They depend on sig, r, b and the option type only, so options sharing them share the terms
+        struct PerpetualExponent
+        {
+            double y = 0;
+            double dy_dsig = 0;
+            double dy_dr = 0;
+        };
+        
         class PerpetualAmericanOption: public Option
         {
         private:
@@ -30,8 +42,30 @@ namespace All_Options
             double PutPrice
             (const double& K, const double& sig, const double& r, const double& b, const double& S) const;
             
+            // Serve for Surface() and ParallelSurface(), run on the pool if one is given
+            OptionSurface BuildSurface(const SurfaceAxis& rows, const SurfaceAxis& cols,
+                                       ThreadPool* pool, const ParallelConfig& config) const;
+            
         public:
             
+            ///////////////////////////////////////Price Formula////////////////////////////////////////////////
+            
+            // Exponent y of the call or put price, which depends on sig, r and b only
+            // Options sharing sig, r and b (spot or strike ladders, books on one underlying) can share y
+            static double Exponent(const double& sig, const double& r, const double& b, const bool& call);
+            
+            // Call or put price from the exponent y
+            static double ExponentPrice(const double& K, const double& S, const double& y, const bool& call);
+            
+            // Exponent y of the call or put price with its derivatives in sig and r (b fixed)
+            static PerpetualExponent ExponentTerms(const double& sig, const double& r, const double& b, const bool& call);
+            
+            // Price and sensitivities selected by the mask from the exponent terms, in one pass
+            // With V the price and x = (y - 1) S / (y K): delta = y V / S, gamma = y (y - 1) V / S^2 and
+            // dV/dy = V log(x), so vega = V log(x) dy/dsig and rho = V log(x) dy/dr. Theta is 0 (no expiry).
+            static OptionGreeks ExponentGreeks(const double& K, const double& S, const PerpetualExponent& e,
+                                               const bool& call, const unsigned& mask);
+            
             ////////////////////////////////////////Constructors///////////////////////////////////////////////
             
             // Default PerpetualAmericanOption constructor
@@ -71,6 +105,51 @@ namespace All_Options
             // Calculte the price of the option for each variable change. Output a vector of prices
             virtual std::vector<double> Price(std::string factor, const double& start, const double& end, const double& step) const;
             
+            // Same as above with the factor given as a Factor, without parsing or looking up names
+            virtual double Price(const Factor& factor, const double& value) const;
+            virtual std::vector<double> Price(const Factor& factor, const double& start, const double& end, const double& step) const;
+            
+            // Same as above, writing the n = SweepSize(start, end, step) prices to a caller buffer without allocating
+            // Throw InvalidSizeException if n is not the number of values
+            void Price(const Factor& factor, const double& start, const double& end, const double& step,
+                       double* price, const std::size_t& n) const;
+            
+            //////////////////////////////////////Greeks Getters////////////////////////////////////////////////
+            
+            // Calculate the delta of the option
+            double Delta() const;
+            
+            // Calculate the gamma of the option
+            double Gamma() const;
+            
+            // Calculate the price, delta, gamma, vega, theta and rho selected by the mask in one pass
+            // The price and log(x) are computed only once (see ExponentGreeks)
+            struct OptionGreeks Greeks(const unsigned& mask = ALL_GREEKS) const;
+            
+            // Given a factor and start, end and step of the factor
+            // Calculate the outputs selected by the mask for each variable change
+            // The exponent terms are computed once unless the factor is sig, r or b
+            BatchGreeks Greeks(const Factor& factor, const double& start, const double& end, const double& step,
+                               const unsigned& mask = ALL_GREEKS) const;
+            
+            // Same as above, writing to caller buffers of n = SweepSize(start, end, step) values without allocating
+            // The outputs whose pointer is not null are computed
+            void Greeks(const Factor& factor, const double& start, const double& end, const double& step,
+                        const Simd::KernelOutput& out, const std::size_t& n) const;
+            
+            /////////////////////////////////////////Surfaces///////////////////////////////////////////////////
+            
+            // Calculate the price over a grid of two factors
+            // Row i of the grid uses the i-th value of the rows axis, column j the j-th value of the cols axis
+            // Throw InvalidValueException if a factor at either end of an axis is rejected by CheckFactorValue
+            // or sig is not larger than 0
+            OptionSurface Surface(const SurfaceAxis& rows, const SurfaceAxis& cols) const;
+            
+            // Same as Surface, with the tiles of the grid split over a pool of threads
+            // The result is identical to Surface whatever the thread count
+            OptionSurface ParallelSurface(const SurfaceAxis& rows, const SurfaceAxis& cols,
+                                          const ParallelConfig& config = ParallelConfig()) const;
+            
             ////////////////////////////////////////Description/////////////////////////////////////////////////
             
             virtual std::string ToString() const;
@@ -0,0 +1,438 @@
+//  Portfolio.cpp
+//  Positions over many underlyings, aggregated by underlying and in total.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "Portfolio.hpp"
+#include "EuropeanFormula.hpp"
+#include "SimdKernel.hpp"
+#include "OptionMatrix.hpp"
+#include "Exception.hpp"
+#include <algorithm>
+#include <sstream>
+
+namespace All_Options
+{
+    // Sum of two risks
+    static PortfolioRisk Sum(const PortfolioRisk& a, const PortfolioRisk& b)
+    {
+        PortfolioRisk risk;
+        risk.price = a.price + b.price;
+        risk.delta = a.delta + b.delta;
+        risk.gamma = a.gamma + b.gamma;
+        risk.vega = a.vega + b.vega;
+        return risk;
+    }
+    
+    // Double the rows of a batch, keeping its first count rows
+    static void Grow(OptionBatch& batch, const std::size_t& count)
+    {
+        OptionBatch larger(std::max<std::size_t>(16, 2 * batch.size()));
+        double* from[6] = { batch.T(), batch.K(), batch.sig(), batch.r(), batch.b(), batch.S() };
+        double* to[6] = { larger.T(), larger.K(), larger.sig(), larger.r(), larger.b(), larger.S() };
+        for (std::size_t k = 0; k < 6; k++)
+            std::copy(from[k], from[k] + count, to[k]);
+        std::copy(batch.type(), batch.type() + count, larger.type());
+        batch = std::move(larger);
+    }
+    
+    // Check the data of a position of a kind the same way as Option::set_data; the batch kernels also need sig and S
+    // larger than 0, and T for a European position (a perpetual one has no expiry)
+    static void CheckPosition(const struct OptionData& data, const PositionKind& kind)
+    {
+        CheckOption(data, true, kind == EUROPEAN_POSITION);
+        if (!(data.sig > 0) || !(data.S > 0))
+            throw InvalidValueException();
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Private Functions/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Evaluate the positions of a bucket with the batch kernel of its kind
+    void Portfolio::Evaluate(Bucket& bucket, const NormalMode& mode)
+    {
+        // Outputs of the kernel, kept by each thread between buckets
+        static thread_local std::vector<double> price, delta, gamma, vega;
+        std::size_t n = bucket.count;
+        if (price.size() < n)
+        {
+            price.resize(n);
+            delta.resize(n);
+            gamma.resize(n);
+            vega.resize(n);
+        }
+        
+        Simd::KernelOutput out;
+        out.price = price.data();
+        out.delta = delta.data();
+        out.gamma = gamma.data();
+        out.vega = vega.data();
+        const OptionBatch& batch = bucket.batch;
+        if (bucket.kind == EUROPEAN_POSITION)
+            Simd::EuropeanKernel(batch, 0, n, out, mode, ClassifyCarry(batch.r(), batch.b(), n));
+        else
+            Simd::PerpetualKernel(batch, 0, n, out);
+        
+        PortfolioRisk risk;
+        const double* q = bucket.quantity.data();
+        for (std::size_t i = 0; i < n; i++)
+        {
+            risk.price += q[i] * price[i];
+            risk.delta += q[i] * delta[i];
+            risk.gamma += q[i] * gamma[i];
+            risk.vega += q[i] * vega[i];
+        }
+        bucket.risk = risk;
+    }
+    
+    // Add a position of a kind from the data of an option
+    std::size_t Portfolio::Add(const struct OptionData& data, const PositionKind& kind, const double& quantity)
+    {
+        CheckPosition(data, kind);
+        
+        // Find or create the underlying
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(data.name);
+        std::size_t u;
+        if (it == index.end())
+        {
+            u = underlyings.size();
+            underlyings.push_back(Underlying());
+            underlyings[u].name = data.name;
+            underlyings[u].buckets[0] = underlyings[u].buckets[1] = npos;
+            underlyings[u].dirty = false;
+            index[data.name] = u;
+            
+            // The tree is built again when the leaves run out
+            if (u >= leaves)
+                built = false;
+        }
+        else
+            u = it->second;
+        
+        // Find or create the bucket of the kind
+        std::size_t k = underlyings[u].buckets[kind];
+        if (k == npos)
+        {
+            k = buckets.size();
+            buckets.push_back(Bucket());
+            buckets[k].kind = kind;
+            buckets[k].underlying = u;
+            buckets[k].dirty = false;
+            underlyings[u].buckets[kind] = k;
+        }
+        
+        Bucket& bucket = buckets[k];
+        if (bucket.count == bucket.batch.size())
+            Grow(bucket.batch, bucket.count);
+        bucket.batch.set_row(bucket.count, data);
+        bucket.quantity.push_back(quantity);
+        positions.push_back(std::make_pair(k, bucket.count));
+        bucket.count++;
+        
+        Touch(k);
+        return positions.size() - 1;
+    }
+    
+    // Mark a bucket and its underlying as changed
+    void Portfolio::Touch(const std::size_t& k)
+    {
+        if (!buckets[k].dirty)
+        {
+            buckets[k].dirty = true;
+            dirty_buckets.push_back(k);
+        }
+        std::size_t u = buckets[k].underlying;
+        if (!underlyings[u].dirty)
+        {
+            underlyings[u].dirty = true;
+            dirty_underlyings.push_back(u);
+        }
+    }
+    
+    // Serve for Aggregate() and ParallelAggregate(), run on the pool if one is given
+    std::size_t Portfolio::Reduce(ThreadPool* pool, const ParallelConfig& config)
+    {
+        // Evaluate the changed buckets; with a pool, they are grouped in tasks of about config.chunk options
+        std::size_t evaluated = dirty_buckets.size();
+        if (pool)
+        {
+            std::vector<std::size_t> tasks(1, 0);
+            std::size_t options = 0;
+            for (std::size_t i = 0; i < evaluated; i++)
+            {
+                options += buckets[dirty_buckets[i]].count;
+                if (options >= config.chunk || i + 1 == evaluated)
+                {
+                    tasks.push_back(i + 1);
+                    options = 0;
+                }
+            }
+            auto chunk = [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t t = begin; t < end; t++)
+                    for (std::size_t i = tasks[t]; i < tasks[t + 1]; i++)
+                        Evaluate(buckets[dirty_buckets[i]], mode);
+            };
+            pool->ParallelFor(tasks.size() - 1, 1, chunk, config.threads);
+        }
+        else
+            for (std::size_t i = 0; i < evaluated; i++)
+                Evaluate(buckets[dirty_buckets[i]], mode);
+        
+        // Risk of an underlying: its European bucket, then its perpetual American one
+        auto leaf = [&](std::size_t u)
+        {
+            PortfolioRisk risk;
+            for (std::size_t kind = 0; kind < 2; kind++)
+                if (underlyings[u].buckets[kind] != npos)
+                    risk = Sum(risk, buckets[underlyings[u].buckets[kind]].risk);
+            return risk;
+        };
+        
+        if (!built)
+        {
+            // Build the whole tree, one level at a time from the leaves up
+            leaves = 1;
+            while (leaves < underlyings.size())
+                leaves *= 2;
+            tree.assign(2 * leaves, PortfolioRisk());
+            for (std::size_t u = 0; u < underlyings.size(); u++)
+                tree[leaves + u] = leaf(u);
+            
+            for (std::size_t level = leaves / 2; level >= 1; level /= 2)
+            {
+                auto nodes = [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i = level + begin; i < level + end; i++)
+                        tree[i] = Sum(tree[2 * i], tree[2 * i + 1]);
+                };
+                if (pool)
+                    pool->ParallelFor(level, config.chunk, nodes, config.threads);
+                else
+                    nodes(0, level);
+            }
+            built = true;
+        }
+        else
+        {
+            // Add the paths from the changed leaves to the root again
+            for (std::size_t j = 0; j < dirty_underlyings.size(); j++)
+            {
+                std::size_t i = leaves + dirty_underlyings[j];
+                tree[i] = leaf(dirty_underlyings[j]);
+                for (i /= 2; i >= 1; i /= 2)
+                    tree[i] = Sum(tree[2 * i], tree[2 * i + 1]);
+            }
+        }
+        
+        for (std::size_t i = 0; i < dirty_buckets.size(); i++)
+            buckets[dirty_buckets[i]].dirty = false;
+        for (std::size_t i = 0; i < dirty_underlyings.size(); i++)
+            underlyings[dirty_underlyings[i]].dirty = false;
+        dirty_buckets.clear();
+        dirty_underlyings.clear();
+        return evaluated;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    Portfolio::Portfolio(const NormalMode& m)
+    : mode(m), buckets(), underlyings(), index(), positions(), tree(), leaves(0), built(false),
+      dirty_buckets(), dirty_underlyings() {}
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////Getters///////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Number of positions
+    std::size_t Portfolio::size() const
+    {
+        return positions.size();
+    }
+    
+    // Number of underlyings
+    std::size_t Portfolio::Underlyings() const
+    {
+        return underlyings.size();
+    }
+    
+    // Number of buckets
+    std::size_t Portfolio::Buckets() const
+    {
+        return buckets.size();
+    }
+    
+    // Kind of a position
+    PositionKind Portfolio::get_kind(const std::size_t& id) const
+    {
+        if (id >= positions.size())
+            throw InvalidValueException();
+        return buckets[positions[id].first].kind;
+    }
+    
+    // Data of a position
+    struct OptionData Portfolio::get_data(const std::size_t& id) const
+    {
+        if (id >= positions.size())
+            throw InvalidValueException();
+        const Bucket& bucket = buckets[positions[id].first];
+        OptionData data = bucket.batch.row(positions[id].second);
+        data.name = underlyings[bucket.underlying].name;
+        return data;
+    }
+    
+    // Quantity of a position
+    double Portfolio::get_quantity(const std::size_t& id) const
+    {
+        if (id >= positions.size())
+            throw InvalidValueException();
+        return buckets[positions[id].first].quantity[positions[id].second];
+    }
+    
+    // Accuracy mode of the normal distribution of European positions
+    NormalMode Portfolio::get_normal_mode() const
+    {
+        return mode;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////Positions//////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Add quantity European options
+    std::size_t Portfolio::Add(const European::EuropeanOption& option, const double& quantity)
+    {
+        return Add(option.get_data(), EUROPEAN_POSITION, quantity);
+    }
+    
+    // Add quantity perpetual American options
+    std::size_t Portfolio::Add(const PerpetualAmerican::PerpetualAmericanOption& option, const double& quantity)
+    {
+        return Add(option.get_data(), PERPETUAL_AMERICAN_POSITION, quantity);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////Modifiers//////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Change the quantity of a position
+    void Portfolio::set_quantity(const std::size_t& id, const double& quantity)
+    {
+        if (id >= positions.size())
+            throw InvalidValueException();
+        buckets[positions[id].first].quantity[positions[id].second] = quantity;
+        Touch(positions[id].first);
+    }
+    
+    // Change the data of a position
+    void Portfolio::set_data(const std::size_t& id, const struct OptionData& data)
+    {
+        if (id >= positions.size())
+            throw InvalidValueException();
+        
+        Bucket& bucket = buckets[positions[id].first];
+        CheckPosition(data, bucket.kind);
+        
+        // An unset type keeps the type of the position
+        std::size_t row = positions[id].second;
+        OptionData source = data;
+        if (data.optType == 0)
+            source.optType = bucket.batch.type()[row];
+        bucket.batch.set_row(row, source);
+        Touch(positions[id].first);
+    }
+    
+    // Move the spot of every position on an underlying
+    void Portfolio::set_S(const std::string& underlying, const double& S)
+    {
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(underlying);
+        if (it == index.end() || !(S > 0))
+            throw InvalidValueException();
+        
+        for (std::size_t kind = 0; kind < 2; kind++)
+        {
+            std::size_t k = underlyings[it->second].buckets[kind];
+            if (k == npos) continue;
+            std::fill(buckets[k].batch.S(), buckets[k].batch.S() + buckets[k].count, S);
+            Touch(k);
+        }
+    }
+    
+    // Set the accuracy mode of the normal distribution
+    void Portfolio::set_normal_mode(const NormalMode& m)
+    {
+        mode = m;
+        for (std::size_t k = 0; k < buckets.size(); k++)
+            if (buckets[k].kind == EUROPEAN_POSITION)
+                Touch(k);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////Aggregation/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Evaluate the changed buckets and add the risks of their underlyings up the tree
+    std::size_t Portfolio::Aggregate()
+    {
+        return Reduce(0, ParallelConfig());
+    }
+    
+    // Same as Aggregate, split over a pool of threads
+    std::size_t Portfolio::ParallelAggregate(const ParallelConfig& config)
+    {
+        ThreadPool& pool = config.pool? *config.pool : ThreadPool::Shared();
+        return Reduce(&pool, config);
+    }
+    
+    // Risk of the positions on an underlying, as of the last aggregation
+    PortfolioRisk Portfolio::Risk(const std::string& underlying) const
+    {
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(underlying);
+        if (it == index.end())
+            throw InvalidValueException();
+        
+        // An underlying added after the tree was built has not been aggregated yet
+        if (it->second >= leaves)
+            return PortfolioRisk();
+        return tree[leaves + it->second];
+    }
+    
+    // Risk of the whole portfolio, as of the last aggregation
+    PortfolioRisk Portfolio::Total() const
+    {
+        if (tree.empty())
+            return PortfolioRisk();
+        return tree[1];
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Description/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    std::string Portfolio::ToString() const
+    {
+        // Create a stringstream
+        std::stringstream str;
+        
+        PortfolioRisk total = Total();
+        str << "Portfolio (" << size() << " positions on " << Underlyings() << " underlyings, " << Buckets() << " buckets)\n";
+        str << "Price: " << total.price << "\n";
+        str << "Delta: " << total.delta << "\n";
+        str << "Gamma: " << total.gamma << "\n";
+        str << "Vega:  " << total.vega;
+        return str.str();
+    }
+    
+    // Get the information of the object using <<
+    std::ostream& operator << (std::ostream& os, const Portfolio& portfolio)
+    {
+        // Get the description from ToString() function
+        os << portfolio.ToString();
+        return os;
+    }
+}
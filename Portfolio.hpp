@@ -0,0 +1,173 @@
+//  Portfolio.hpp
+//  Positions (quantity x option) over many underlyings, with their price,
+//  delta, gamma and vega aggregated by underlying and in total. The
+//  positions of an underlying are kept in one bucket per kind of option
+//  (European, perpetual American), each a contiguous OptionBatch that is
+//  evaluated by the batch kernel of its kind. The risks of the
+//  underlyings are the leaves of a binary tree whose nodes add their two
+//  children: the whole tree is built level by level, split over a pool
+//  of threads, and after a partial update only the changed buckets are
+//  evaluated again and only the paths from their leaves to the root are
+//  added again. Every node is always the sum of the same two children,
+//  so the totals do not depend on the thread count or on the order of
+//  the updates.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef Portfolio_hpp
+#define Portfolio_hpp
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "OptionData.hpp"
+#include "OptionBatch.hpp"
+#include "NormalDistribution.hpp"
+#include "ThreadPool.hpp"
+#include "EuropeanOption.hpp"
+#include "PerpetualAmericanOption.hpp"
+
+namespace All_Options
+{
+    // Kinds of positions, kept in separate buckets
+    enum PositionKind { EUROPEAN_POSITION = 0, PERPETUAL_AMERICAN_POSITION = 1 };
+    
+    // Sum of quantity times the price, delta, gamma and vega of positions
+    struct PortfolioRisk
+    {
+        double price = 0;
+        double delta = 0;
+        double gamma = 0;
+        double vega = 0;
+    };
+    
+    class Portfolio
+    {
+    private:
+        // Positions of one kind on one underlying; rows [0, count) of the batch are used
+        struct Bucket
+        {
+            PositionKind kind = EUROPEAN_POSITION;
+            std::size_t underlying = 0;
+            OptionBatch batch;
+            std::size_t count = 0;
+            std::vector<double> quantity;
+            PortfolioRisk risk;     // As of the last aggregation
+            bool dirty = true;
+        };
+        
+        // Buckets of one underlying (npos when there is none of the kind)
+        struct Underlying
+        {
+            std::string name;
+            std::size_t buckets[2];
+            bool dirty = true;
+        };
+        
+        NormalMode mode;
+        std::vector<Bucket> buckets;
+        std::vector<Underlying> underlyings;
+        std::unordered_map<std::string, std::size_t> index;        // Name -> underlying
+        std::vector<std::pair<std::size_t, std::size_t>> positions; // Position -> (bucket, row)
+        
+        // Binary tree of the risks: the leaves [leaves, 2 * leaves) are the underlyings, node i adds 2i and 2i + 1
+        std::vector<PortfolioRisk> tree;
+        std::size_t leaves;
+        bool built;
+        
+        // Buckets and underlyings changed since the last aggregation
+        std::vector<std::size_t> dirty_buckets;
+        std::vector<std::size_t> dirty_underlyings;
+        
+        // Evaluate the positions of a bucket with the batch kernel of its kind
+        static void Evaluate(Bucket& bucket, const NormalMode& mode);
+        
+        // Add a position of a kind from the data of an option
+        std::size_t Add(const struct OptionData& data, const PositionKind& kind, const double& quantity);
+        
+        // Mark a bucket and its underlying as changed
+        void Touch(const std::size_t& bucket);
+        
+        // Serve for Aggregate() and ParallelAggregate(), run on the pool if one is given
+        std::size_t Reduce(ThreadPool* pool, const ParallelConfig& config);
+    
+    public:
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+        
+        ////////////////////////////////////////Constructors///////////////////////////////////////////////
+        
+        // Empty portfolio; European positions use the normal distribution of mode
+        Portfolio(const NormalMode& mode = HIGH_ACCURACY);
+        
+        ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+        
+        // Number of positions, of underlyings and of buckets
+        std::size_t size() const;
+        std::size_t Underlyings() const;
+        std::size_t Buckets() const;
+        
+        // Kind, data and quantity of a position
+        // Throw InvalidValueException if id is not a position
+        PositionKind get_kind(const std::size_t& id) const;
+        struct OptionData get_data(const std::size_t& id) const;
+        double get_quantity(const std::size_t& id) const;
+        
+        // Accuracy mode of the normal distribution of European positions
+        NormalMode get_normal_mode() const;
+        
+        /////////////////////////////////////////Positions//////////////////////////////////////////////////
+        
+        // Add quantity options on the underlying option.get_data().name and return the id of the position
+        // Throw InvalidValueException if sig or S of the option is not positive, or T for a European option
+        std::size_t Add(const European::EuropeanOption& option, const double& quantity = 1);
+        std::size_t Add(const PerpetualAmerican::PerpetualAmericanOption& option, const double& quantity = 1);
+        
+        ////////////////////////////////////////Modifiers///////////////////////////////////////////////////
+        
+        // Change the quantity of a position
+        // Throw InvalidValueException if id is not a position
+        void set_quantity(const std::size_t& id, const double& quantity);
+        
+        // Change the data of a position, with the rules of Option::set_data; the position keeps its underlying
+        // Throw InvalidValueException if id is not a position, for values Option::set_data rejects or if sig or S
+        // (or T for a European position) is not positive, and InvalidOptionTypeException if the type is not C or P
+        void set_data(const std::size_t& id, const struct OptionData& data);
+        
+        // Move the spot of every position on an underlying
+        // Throw InvalidValueException if the name is not in the portfolio or S is not positive
+        void set_S(const std::string& underlying, const double& S);
+        
+        // Set the accuracy mode of the normal distribution, which changes every European bucket
+        void set_normal_mode(const NormalMode& mode);
+        
+        ////////////////////////////////////////Aggregation/////////////////////////////////////////////////
+        
+        // Evaluate the buckets changed since the last aggregation with the batch kernels, then add the risks of
+        // their underlyings up the tree; return the number of buckets evaluated
+        std::size_t Aggregate();
+        
+        // Same as Aggregate, with the buckets and the levels of the tree split over a pool of threads
+        // config.chunk is the number of options (or of tree nodes) handed to a thread at a time
+        // The result is identical to Aggregate whatever the thread count and chunk size
+        std::size_t ParallelAggregate(const ParallelConfig& config = ParallelConfig());
+        
+        // Risk of the positions on an underlying and of the whole portfolio, as of the last aggregation
+        // Throw InvalidValueException if the name is not in the portfolio
+        PortfolioRisk Risk(const std::string& underlying) const;
+        PortfolioRisk Total() const;
+        
+        ////////////////////////////////////////Description/////////////////////////////////////////////////
+        
+        std::string ToString() const;
+        
+        // Get the information of the object using <<
+        friend std::ostream& operator << (std::ostream& os, const Portfolio& portfolio);
+    };
+}
+
+#endif
@@ -0,0 +1,127 @@
+//  RandomNumbers.cpp
+//  Sobol sequence of the Monte Carlo engine.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "RandomNumbers.hpp"
+#include "Exception.hpp"
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        // Definition of the constant, which is bound to references (C++11)
+        const std::size_t SobolSequence::MAX_DIMENSIONS;
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Direction Numbers////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Direction numbers v[d][k] (32-bit fractions) of every dimension, built on first use from the
+        // primitive polynomials and initial numbers of Joe and Kuo (new-joe-kuo-6.21201)
+        static const std::uint32_t (&Directions())[SobolSequence::MAX_DIMENSIONS][32]
+        {
+            struct Table
+            {
+                std::uint32_t v[SobolSequence::MAX_DIMENSIONS][32];
+                
+                Table()
+                {
+                    // Degree s, coefficients a and initial numbers m of dimensions 2 .. 21
+                    static const unsigned s[20] = { 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 7, 7 };
+                    static const unsigned a[20] = { 0, 1, 1, 2, 1, 4, 2, 4, 7, 11, 13, 14, 1, 13, 16, 19, 22, 25, 1, 4 };
+                    static const unsigned m[20][7] = {
+                        { 1 }, { 1, 3 }, { 1, 3, 1 }, { 1, 1, 1 }, { 1, 1, 3, 3 }, { 1, 3, 5, 13 },
+                        { 1, 1, 5, 5, 17 }, { 1, 1, 5, 5, 5 }, { 1, 1, 7, 11, 19 }, { 1, 1, 5, 1, 1 },
+                        { 1, 1, 1, 3, 11 }, { 1, 3, 5, 5, 31 }, { 1, 3, 3, 9, 7, 49 }, { 1, 1, 1, 15, 21, 21 },
+                        { 1, 3, 1, 13, 27, 49 }, { 1, 1, 1, 15, 7, 5 }, { 1, 3, 1, 15, 13, 25 }, { 1, 1, 5, 5, 19, 61 },
+                        { 1, 3, 7, 11, 23, 15, 103 }, { 1, 3, 7, 13, 13, 15, 69 } };
+                    
+                    // The first dimension is the van der Corput sequence
+                    for (unsigned k = 0; k < 32; k++)
+                        v[0][k] = 1u << (31 - k);
+                    
+                    for (std::size_t d = 1; d < SobolSequence::MAX_DIMENSIONS; d++)
+                    {
+                        unsigned degree = s[d - 1];
+                        for (unsigned k = 0; k < 32; k++)
+                        {
+                            if (k < degree)
+                            {
+                                v[d][k] = m[d - 1][k] << (31 - k);
+                                continue;
+                            }
+                            v[d][k] = v[d][k - degree] ^ (v[d][k - degree] >> degree);
+                            for (unsigned l = 1; l < degree; l++)
+                                if ((a[d - 1] >> (degree - 1 - l)) & 1)
+                                    v[d][k] ^= v[d][k - l];
+                        }
+                    }
+                }
+            };
+            static const Table table;
+            return table.v;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        SobolSequence::SobolSequence(const std::size_t& d): dimensions(d), index(0), point()
+        {
+            if (d == 0 || d > MAX_DIMENSIONS)
+                throw InvalidValueException();
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////Getter and Modifier//////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Coordinates of a point
+        std::size_t SobolSequence::get_dimensions() const
+        {
+            return dimensions;
+        }
+        
+        // Move to a point: the point before it in Gray code order is the XOR of the direction numbers
+        // of the bits of gray(index - 1)
+        void SobolSequence::Seek(const std::uint64_t& i)
+        {
+            index = i;
+            for (std::size_t d = 0; d < dimensions; d++)
+                point[d] = 0;
+            if (i == 0)
+                return;
+            
+            const std::uint32_t (&v)[MAX_DIMENSIONS][32] = Directions();
+            std::uint64_t gray = (i - 1) ^ ((i - 1) >> 1);
+            for (unsigned k = 0; k < 32 && (gray >> k) != 0; k++)
+                if ((gray >> k) & 1)
+                    for (std::size_t d = 0; d < dimensions; d++)
+                        point[d] ^= v[d][k];
+        }
+        
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////Points////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        
+        // Next point: point 0 is the origin, point i differs from point i - 1 by the direction numbers
+        // of the lowest zero bit of i - 1
+        const std::uint32_t* SobolSequence::Next()
+        {
+            if (index > 0)
+            {
+                const std::uint32_t (&v)[MAX_DIMENSIONS][32] = Directions();
+                unsigned k = 0;
+                for (std::uint64_t j = index - 1; j & 1; j >>= 1)
+                    k++;
+                for (std::size_t d = 0; d < dimensions; d++)
+                    point[d] ^= v[d][k];
+            }
+            index++;
+            return point;
+        }
+    }
+}
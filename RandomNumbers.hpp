@@ -0,0 +1,95 @@
+//  RandomNumbers.hpp
+//  Random numbers of the Monte Carlo engine. Philox4x32-10 is a
+//  counter-based generator: the numbers of sample i are a function of
+//  i and the seed only, so any thread can generate any sample and the
+//  results do not depend on how the samples are split between threads.
+//  SobolSequence gives the points of a Sobol sequence (Joe-Kuo
+//  direction numbers) from any index, with the Gray code update.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef RandomNumbers_hpp
+#define RandomNumbers_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+namespace All_Options
+{
+    namespace MonteCarlo
+    {
+        // Philox4x32-10 (Salmon, Moraes, Dror and Shaw, 2011)
+        struct Philox
+        {
+            // Four random 32-bit words for a counter and a key
+            static void Block(const std::uint32_t (&counter)[4], const std::uint32_t (&key)[2], std::uint32_t (&out)[4])
+            {
+                std::uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+                std::uint32_t k0 = key[0], k1 = key[1];
+                for (int round = 0; round < 10; round++)
+                {
+                    std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * c[0];
+                    std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * c[2];
+                    std::uint32_t next[4] = { static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<std::uint32_t>(p1),
+                                              static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<std::uint32_t>(p0) };
+                    c[0] = next[0]; c[1] = next[1]; c[2] = next[2]; c[3] = next[3];
+                    k0 += 0x9E3779B9u;
+                    k1 += 0xBB67AE85u;
+                }
+                out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+            }
+            
+            // Uniform number in (0, 1) from two random words (53 random bits, never 0 or 1)
+            static double Uniform(const std::uint32_t& high, const std::uint32_t& low)
+            {
+                std::uint64_t bits = (static_cast<std::uint64_t>(high) << 21) ^ (low >> 11);
+                return (static_cast<double>(bits) + 0.5) * (1.0 / 9007199254740992.0);
+            }
+        };
+        
+        class SobolSequence
+        {
+        public:
+            
+            // Dimensions with direction numbers
+            static const std::size_t MAX_DIMENSIONS = 21;
+        
+        private:
+            
+            std::size_t dimensions;                 // Coordinates of a point
+            std::uint64_t index;                    // Index of the next point
+            std::uint32_t point[MAX_DIMENSIONS];    // Point of index - 1 (Gray code order)
+        
+        public:
+            
+            ////////////////////////////////////////Constructors///////////////////////////////////////////////
+            
+            // Sequence of points with the given number of coordinates, starting at index 0
+            // Throw InvalidValueException if dimensions is 0 or above MAX_DIMENSIONS
+            explicit SobolSequence(const std::size_t& dimensions);
+            
+            ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+            
+            // Coordinates of a point
+            std::size_t get_dimensions() const;
+            
+            // Move to a point, so that the next call to Next() returns the point of that index
+            void Seek(const std::uint64_t& index);
+            
+            //////////////////////////////////////////Points////////////////////////////////////////////////////
+            
+            // Next point, as 32-bit fractions of the coordinates (x / 2^32), valid until the next call
+            const std::uint32_t* Next();
+            
+            // Uniform number in (0, 1) from a coordinate, XORed with a random shift
+            static double Uniform(const std::uint32_t& x, const std::uint32_t& shift = 0)
+            {
+                return (static_cast<double>(x ^ shift) + 0.5) * (1.0 / 4294967296.0);
+            }
+        };
+    }
+}
+
+#endif
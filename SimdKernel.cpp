@@ -0,0 +1,361 @@
+//  SimdKernel.cpp
+//  Vectorized Black-Scholes and perpetual American kernels used by the batch functions.
+//  The instruction set independent code lives in SimdKernel.inl, which is
+//  included once per instruction set below, each time with its own pack
+//  operations and target attribute. The best compiled version supported
+//  by the CPU is chosen at runtime.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "SimdKernel.hpp"
+#include "NormalDistribution.hpp"
+#include "PerpetualAmericanOption.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define OPTION_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define OPTION_SIMD_X86 0
+#endif
+
+namespace All_Options
+{
+    namespace Simd
+    {
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////////Scalar/////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        namespace Scalar
+        {
+            #define SIMD_TARGET
+
+            typedef double V;
+            typedef bool M;
+            const std::size_t W = 1;
+
+            inline std::uint64_t AsBits(const V& x) { std::uint64_t u; std::memcpy(&u, &x, sizeof(V)); return u; }
+            inline V FromBits(const std::uint64_t& u) { V x; std::memcpy(&x, &u, sizeof(V)); return x; }
+
+            inline V Set1(const double& x) { return x; }
+            inline V Load(const double* p) { return *p; }
+            inline void Store(double* p, const V& x) { *p = x; }
+            inline V Add(const V& a, const V& b) { return a + b; }
+            inline V Sub(const V& a, const V& b) { return a - b; }
+            inline V Mul(const V& a, const V& b) { return a * b; }
+            inline V Div(const V& a, const V& b) { return a / b; }
+            inline V Fma(const V& a, const V& b, const V& c) { return a * b + c; }
+            inline V Sqrt(const V& a) { return std::sqrt(a); }
+            inline V Min(const V& a, const V& b) { return (a < b)? a : b; }
+            inline V Max(const V& a, const V& b) { return (a > b)? a : b; }
+            inline M Lt(const V& a, const V& b) { return a < b; }
+            inline M Gt(const V& a, const V& b) { return a > b; }
+            inline M Eq(const V& a, const V& b) { return a == b; }
+            inline V Select(const M& m, const V& a, const V& b) { return m? a : b; }
+            inline bool All(const M& m) { return m; }
+            inline V And(const V& a, const V& b) { return FromBits(AsBits(a) & AsBits(b)); }
+            inline V Or(const V& a, const V& b) { return FromBits(AsBits(a) | AsBits(b)); }
+            inline V ShiftLeft52(const V& a) { return FromBits(AsBits(a) << 52); }
+            inline V ShiftRight52(const V& a) { return FromBits(AsBits(a) >> 52); }
+
+            #include "SimdKernel.inl"
+
+            #undef SIMD_TARGET
+        }
+
+#if OPTION_SIMD_X86
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////SSE2//////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        namespace Sse2
+        {
+            #define SIMD_TARGET __attribute__((target("sse2")))
+
+            typedef __m128d V;
+            typedef __m128d M;
+            const std::size_t W = 2;
+
+            SIMD_TARGET inline V Set1(const double& x) { return _mm_set1_pd(x); }
+            SIMD_TARGET inline V Load(const double* p) { return _mm_loadu_pd(p); }
+            SIMD_TARGET inline void Store(double* p, const V& x) { _mm_storeu_pd(p, x); }
+            SIMD_TARGET inline V Add(const V& a, const V& b) { return _mm_add_pd(a, b); }
+            SIMD_TARGET inline V Sub(const V& a, const V& b) { return _mm_sub_pd(a, b); }
+            SIMD_TARGET inline V Mul(const V& a, const V& b) { return _mm_mul_pd(a, b); }
+            SIMD_TARGET inline V Div(const V& a, const V& b) { return _mm_div_pd(a, b); }
+            SIMD_TARGET inline V Fma(const V& a, const V& b, const V& c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+            SIMD_TARGET inline V Sqrt(const V& a) { return _mm_sqrt_pd(a); }
+            SIMD_TARGET inline V Min(const V& a, const V& b) { return _mm_min_pd(a, b); }
+            SIMD_TARGET inline V Max(const V& a, const V& b) { return _mm_max_pd(a, b); }
+            SIMD_TARGET inline M Lt(const V& a, const V& b) { return _mm_cmplt_pd(a, b); }
+            SIMD_TARGET inline M Gt(const V& a, const V& b) { return _mm_cmpgt_pd(a, b); }
+            SIMD_TARGET inline M Eq(const V& a, const V& b) { return _mm_cmpeq_pd(a, b); }
+            SIMD_TARGET inline V Select(const M& m, const V& a, const V& b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+            SIMD_TARGET inline bool All(const M& m) { return _mm_movemask_pd(m) == 0x3; }
+            SIMD_TARGET inline V And(const V& a, const V& b) { return _mm_and_pd(a, b); }
+            SIMD_TARGET inline V Or(const V& a, const V& b) { return _mm_or_pd(a, b); }
+            SIMD_TARGET inline V ShiftLeft52(const V& a) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), 52)); }
+            SIMD_TARGET inline V ShiftRight52(const V& a) { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a), 52)); }
+
+            #include "SimdKernel.inl"
+
+            #undef SIMD_TARGET
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////AVX2//////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        namespace Avx2
+        {
+            #define SIMD_TARGET __attribute__((target("avx2,fma")))
+
+            typedef __m256d V;
+            typedef __m256d M;
+            const std::size_t W = 4;
+
+            SIMD_TARGET inline V Set1(const double& x) { return _mm256_set1_pd(x); }
+            SIMD_TARGET inline V Load(const double* p) { return _mm256_loadu_pd(p); }
+            SIMD_TARGET inline void Store(double* p, const V& x) { _mm256_storeu_pd(p, x); }
+            SIMD_TARGET inline V Add(const V& a, const V& b) { return _mm256_add_pd(a, b); }
+            SIMD_TARGET inline V Sub(const V& a, const V& b) { return _mm256_sub_pd(a, b); }
+            SIMD_TARGET inline V Mul(const V& a, const V& b) { return _mm256_mul_pd(a, b); }
+            SIMD_TARGET inline V Div(const V& a, const V& b) { return _mm256_div_pd(a, b); }
+            SIMD_TARGET inline V Fma(const V& a, const V& b, const V& c) { return _mm256_fmadd_pd(a, b, c); }
+            SIMD_TARGET inline V Sqrt(const V& a) { return _mm256_sqrt_pd(a); }
+            SIMD_TARGET inline V Min(const V& a, const V& b) { return _mm256_min_pd(a, b); }
+            SIMD_TARGET inline V Max(const V& a, const V& b) { return _mm256_max_pd(a, b); }
+            SIMD_TARGET inline M Lt(const V& a, const V& b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+            SIMD_TARGET inline M Gt(const V& a, const V& b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+            SIMD_TARGET inline M Eq(const V& a, const V& b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+            SIMD_TARGET inline V Select(const M& m, const V& a, const V& b) { return _mm256_blendv_pd(b, a, m); }
+            SIMD_TARGET inline bool All(const M& m) { return _mm256_movemask_pd(m) == 0xF; }
+            SIMD_TARGET inline V And(const V& a, const V& b) { return _mm256_and_pd(a, b); }
+            SIMD_TARGET inline V Or(const V& a, const V& b) { return _mm256_or_pd(a, b); }
+            SIMD_TARGET inline V ShiftLeft52(const V& a) { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a), 52)); }
+            SIMD_TARGET inline V ShiftRight52(const V& a) { return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a), 52)); }
+
+            #include "SimdKernel.inl"
+
+            #undef SIMD_TARGET
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /////////////////////////////////////////////AVX-512////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        // GCC 12 warns about the undefined pass-through operand inside its own AVX-512 intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+        namespace Avx512
+        {
+            #define SIMD_TARGET __attribute__((target("avx512f")))
+
+            typedef __m512d V;
+            typedef __mmask8 M;
+            const std::size_t W = 8;
+
+            SIMD_TARGET inline __m512i AsInt(const V& a) { return _mm512_castpd_si512(a); }
+            SIMD_TARGET inline V AsDouble(const __m512i& a) { return _mm512_castsi512_pd(a); }
+
+            SIMD_TARGET inline V Set1(const double& x) { return _mm512_set1_pd(x); }
+            SIMD_TARGET inline V Load(const double* p) { return _mm512_loadu_pd(p); }
+            SIMD_TARGET inline void Store(double* p, const V& x) { _mm512_storeu_pd(p, x); }
+            SIMD_TARGET inline V Add(const V& a, const V& b) { return _mm512_add_pd(a, b); }
+            SIMD_TARGET inline V Sub(const V& a, const V& b) { return _mm512_sub_pd(a, b); }
+            SIMD_TARGET inline V Mul(const V& a, const V& b) { return _mm512_mul_pd(a, b); }
+            SIMD_TARGET inline V Div(const V& a, const V& b) { return _mm512_div_pd(a, b); }
+            SIMD_TARGET inline V Fma(const V& a, const V& b, const V& c) { return _mm512_fmadd_pd(a, b, c); }
+            SIMD_TARGET inline V Sqrt(const V& a) { return _mm512_sqrt_pd(a); }
+            SIMD_TARGET inline V Min(const V& a, const V& b) { return _mm512_min_pd(a, b); }
+            SIMD_TARGET inline V Max(const V& a, const V& b) { return _mm512_max_pd(a, b); }
+            SIMD_TARGET inline M Lt(const V& a, const V& b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+            SIMD_TARGET inline M Gt(const V& a, const V& b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+            SIMD_TARGET inline M Eq(const V& a, const V& b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+            SIMD_TARGET inline V Select(const M& m, const V& a, const V& b) { return _mm512_mask_blend_pd(m, b, a); }
+            SIMD_TARGET inline bool All(const M& m) { return m == 0xFF; }
+            SIMD_TARGET inline V And(const V& a, const V& b) { return AsDouble(_mm512_and_si512(AsInt(a), AsInt(b))); }
+            SIMD_TARGET inline V Or(const V& a, const V& b) { return AsDouble(_mm512_or_si512(AsInt(a), AsInt(b))); }
+            SIMD_TARGET inline V ShiftLeft52(const V& a) { return AsDouble(_mm512_slli_epi64(AsInt(a), 52)); }
+            SIMD_TARGET inline V ShiftRight52(const V& a) { return AsDouble(_mm512_srli_epi64(AsInt(a), 52)); }
+
+            #include "SimdKernel.inl"
+
+            #undef SIMD_TARGET
+        }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////Dispatch////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        // Instruction set used by the batch functions (-1 until first use)
+        static std::atomic<int> active(-1);
+
+        // Best instruction set supported by this CPU
+        Level Detect()
+        {
+#if OPTION_SIMD_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return AVX512;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return AVX2;
+            if (__builtin_cpu_supports("sse2"))
+                return SSE2;
+#endif
+            return SCALAR;
+        }
+
+        // Instruction set currently used by the batch functions
+        Level Active()
+        {
+            int level = active.load(std::memory_order_relaxed);
+            if (level < 0)
+            {
+                level = Detect();
+                active.store(level, std::memory_order_relaxed);
+            }
+            return static_cast<Level>(level);
+        }
+
+        // Choose the instruction set used by the batch functions
+        void Select(const Level& level)
+        {
+            Level best = Detect();
+            active.store((level > best)? best : level, std::memory_order_relaxed);
+        }
+
+        // Name of an instruction set
+        std::string Name(const Level& level)
+        {
+            switch (level)
+            {
+                case SSE2:   return "SSE2";
+                case AVX2:   return "AVX2";
+                case AVX512: return "AVX-512";
+                default:     return "Scalar";
+            }
+        }
+
+        // Price and sensitivities of the rows [begin, end) of a batch
+        void EuropeanKernel(const OptionBatch& batch, std::size_t begin, std::size_t end, const KernelOutput& out,
+                            const NormalMode& mode, const CarryRegime& carry)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::EuropeanKernel(batch, begin, end, out, mode, carry); return;
+                case AVX2:   Avx2::EuropeanKernel(batch, begin, end, out, mode, carry); return;
+                case SSE2:   Sse2::EuropeanKernel(batch, begin, end, out, mode, carry); return;
+#endif
+                default:     Scalar::EuropeanKernel(batch, begin, end, out, mode, carry); return;
+            }
+        }
+        
+        // Price and sensitivities of strikes [begin, end) of a chain
+        void ChainKernel(const ChainTerms& terms, const double* K, const double* logK, const double* sig, const char* type,
+                         std::size_t begin, std::size_t end, const KernelOutput& out, const NormalMode& mode)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::ChainKernel(terms, K, logK, sig, type, begin, end, out, mode); return;
+                case AVX2:   Avx2::ChainKernel(terms, K, logK, sig, type, begin, end, out, mode); return;
+                case SSE2:   Sse2::ChainKernel(terms, K, logK, sig, type, begin, end, out, mode); return;
+#endif
+                default:     Scalar::ChainKernel(terms, K, logK, sig, type, begin, end, out, mode); return;
+            }
+        }
+        
+        // Price, delta and gamma of the rows [begin, end) of columns of S-independent terms at the spot S
+        void SpotKernel(const SpotColumns& terms, const double& S, std::size_t begin, std::size_t end, const KernelOutput& out,
+                        const NormalMode& mode)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::SpotKernel(terms, S, begin, end, out, mode); return;
+                case AVX2:   Avx2::SpotKernel(terms, S, begin, end, out, mode); return;
+                case SSE2:   Sse2::SpotKernel(terms, S, begin, end, out, mode); return;
+#endif
+                default:     Scalar::SpotKernel(terms, S, begin, end, out, mode); return;
+            }
+        }
+        
+        // Price and sensitivities of the perpetual American options of the rows [begin, end) of a batch
+        void PerpetualKernel(const OptionBatch& batch, std::size_t begin, std::size_t end, const KernelOutput& out)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::PerpetualKernel(batch, begin, end, out); return;
+                case AVX2:   Avx2::PerpetualKernel(batch, begin, end, out); return;
+                case SSE2:   Sse2::PerpetualKernel(batch, begin, end, out); return;
+#endif
+                default:     Scalar::PerpetualKernel(batch, begin, end, out); return;
+            }
+        }
+        
+        // Prices of the rows [begin, end) of a batch on binomial or trinomial trees
+        void LatticeKernel(const OptionBatch& batch, std::size_t begin, std::size_t end,
+                           const Lattice::LatticeConfig& config, const ExerciseStyle& style, double* price)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::LatticeKernel(batch, begin, end, config, style, price); return;
+                case AVX2:   Avx2::LatticeKernel(batch, begin, end, config, style, price); return;
+                case SSE2:   Sse2::LatticeKernel(batch, begin, end, config, style, price); return;
+#endif
+                default:     Scalar::LatticeKernel(batch, begin, end, config, style, price); return;
+            }
+        }
+        
+        // Standard normal numbers of n uniforms
+        void InverseNormalKernel(const double* u, double* z, std::size_t n)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::InverseNormalKernel(u, z, n); return;
+                case AVX2:   Avx2::InverseNormalKernel(u, z, n); return;
+                case SSE2:   Sse2::InverseNormalKernel(u, z, n); return;
+#endif
+                default:     Scalar::InverseNormalKernel(u, z, n); return;
+            }
+        }
+        
+        // One date of the paths [0, n) of a simulation
+        void PathDateKernel(const double* w, const double& drift, const double& sig, std::size_t n, const bool& barrier,
+                            const double& side, const double& level, double* sum, double* logsum, double* hit)
+        {
+            switch (Active())
+            {
+#if OPTION_SIMD_X86
+                case AVX512: Avx512::PathDateKernel(w, drift, sig, n, barrier, side, level, sum, logsum, hit); return;
+                case AVX2:   Avx2::PathDateKernel(w, drift, sig, n, barrier, side, level, sum, logsum, hit); return;
+                case SSE2:   Sse2::PathDateKernel(w, drift, sig, n, barrier, side, level, sum, logsum, hit); return;
+#endif
+                default:     Scalar::PathDateKernel(w, drift, sig, n, barrier, side, level, sum, logsum, hit); return;
+            }
+        }
+    }
+}
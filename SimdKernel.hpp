@@ -0,0 +1,137 @@
+//  SimdKernel.hpp
+//  Vectorized Black-Scholes, option chain, spot update, perpetual American, lattice and path simulation kernels used by the batch functions.
+//  The European kernel returns the price, delta, gamma, vega, theta and rho of each row
+//  with the same conventions as EuropeanOption::Greeks(). The kernels are compiled for several instruction sets (scalar, SSE2,
+//  AVX2 + FMA, AVX-512) and the best one supported by the CPU is picked
+//  at runtime. log, exp and the normal CDF are evaluated with branch-free
+//  polynomial approximations so that 2, 4 or 8 options are priced per
+//  instruction.
+//
+//  Accuracy: log and exp are within 1-2 ulp, the normal CDF uses Hart's
+//  double precision rational approximation, as NormalCdf does for
+//  HIGH_ACCURACY (absolute error about 2e-16).
+//  Against EuropeanOption the price error is below 1e-14 * K, the delta
+//  error below 1e-15 and the gamma relative error below 1e-11; vega,
+//  theta and rho share the same terms (values
+//  under 1e-300 are flushed to 0). Inputs are expected to be valid
+//  (T, sig > 0, K, S > 0); the kernel does not check them and does not
+//  throw.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef SimdKernel_hpp
+#define SimdKernel_hpp
+
+#include <cstddef>
+#include <string>
+#include "OptionBatch.hpp"
+#include "NormalDistribution.hpp"
+#include "EuropeanFormula.hpp"
+#include "Lattice.hpp"
+
+namespace All_Options
+{
+    namespace Simd
+    {
+        // Instruction sets the kernels are compiled for
+        enum Level { SCALAR = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+        // Best instruction set supported by this CPU
+        Level Detect();
+
+        // Instruction set currently used by the batch functions
+        Level Active();
+
+        // Choose the instruction set used by the batch functions
+        // A level the CPU does not support is lowered to Detect()
+        void Select(const Level& level);
+
+        // Name of an instruction set
+        std::string Name(const Level& level);
+
+        // Output columns of the kernels
+        // The result of row i goes to price[i], delta[i], ...; a null pointer skips that output
+        struct KernelOutput
+        {
+            double* price = 0;
+            double* delta = 0;
+            double* gamma = 0;
+            double* vega = 0;
+            double* theta = 0;
+            double* rho = 0;
+        };
+
+        // Price and sensitivities of the rows [begin, end) of a batch
+        // Only the terms needed by the requested outputs are evaluated
+        // The normal CDF is Hart's approximation for HIGH_ACCURACY, Abramowitz-Stegun 26.2.17 for FAST
+        // and boost (one lane at a time) for EXACT
+        // The carry regime must hold for every row; CARRY_GENERAL is valid for any batch, the other
+        // regimes (from ClassifyCarry) skip the terms that are constant for them
+        void EuropeanKernel(const OptionBatch& batch, std::size_t begin, std::size_t end, const KernelOutput& out,
+                            const NormalMode& mode = HIGH_ACCURACY, const CarryRegime& carry = CARRY_GENERAL);
+        
+        // Terms shared by every strike of a chain (one underlying, one expiry)
+        struct ChainTerms
+        {
+            double T = 0, r = 0, b = 0, S = 0;
+            double sqrtT = 0;   // sqrt(T)
+            double logS = 0;    // log(S)
+            double dfr = 1;     // exp(-r * T)
+            double dfb = 1;     // exp((b - r) * T)
+        };
+        
+        // Price and sensitivities of the strikes [begin, end) of a chain with strikes K, their logs logK,
+        // volatilities sig and types type, with the same conventions and accuracy as EuropeanKernel
+        // The shared terms are broadcast, so each strike only costs d1 and the normal CDF and PDF
+        void ChainKernel(const ChainTerms& terms, const double* K, const double* logK, const double* sig, const char* type,
+                         std::size_t begin, std::size_t end, const KernelOutput& out, const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Terms of options that do not depend on the spot, as columns (see TickRepricer)
+        struct SpotColumns
+        {
+            const double* K = 0;        // Strike
+            const double* drift = 0;    // (b + sig^2 / 2) * T - log(K)
+            const double* vol = 0;      // sig * sqrt(T)
+            const double* dfr = 0;      // exp(-r * T)
+            const double* dfb = 0;      // exp((b - r) * T)
+            const double* w = 0;        // +1 for calls, -1 for puts
+        };
+        
+        // Price, delta and gamma of the rows [begin, end) of the columns at the spot S, with the same conventions
+        // and accuracy as EuropeanKernel; each row only costs d1 and the normal CDF and PDF
+        // The other outputs of out are left untouched
+        void SpotKernel(const SpotColumns& terms, const double& S, std::size_t begin, std::size_t end, const KernelOutput& out,
+                        const NormalMode& mode = HIGH_ACCURACY);
+        
+        // Price and sensitivities of the perpetual American options of the rows [begin, end) of a batch
+        // (see PerpetualAmericanOption::ExponentGreeks, theta is 0)
+        // The exponent terms are kept in a table of 64 entries indexed by a hash of (sig, r, b), so they are
+        // computed once for each key (unless two keys in use share an entry) whatever the order of the rows, and
+        // x = (y - 1) S / (y K) to the power y is evaluated as exp(y log(x)) on whole packs, whose relative
+        // error grows with |y log(x)| (about 1e-15 near the money, below 1e-13 in general). Lanes where x is
+        // not a positive normal number or |y log(x)| >= 708 fall back to pow, as PerpetualAmericanOption does.
+        void PerpetualKernel(const OptionBatch& batch, std::size_t begin, std::size_t end, const KernelOutput& out);
+        
+        // Prices of the rows [begin, end) of a batch on binomial or trinomial trees (see LatticeOption)
+        // The rows are priced W at a time, each pack of rows rolled back in lockstep on one interleaved array
+        // (node i of row l at value[i * W + l]), so every step of the tree is one pack operation per node.
+        // Prices agree with LatticeOption to about 1e-13 * K. Rows with T, sig or S equal to 0 take
+        // LatticeOption::DegeneratePrice.
+        void LatticeKernel(const OptionBatch& batch, std::size_t begin, std::size_t end,
+                           const Lattice::LatticeConfig& config, const ExerciseStyle& style, double* price);
+        
+        // Standard normal numbers z[i] of the uniforms u[i] in (0, 1), i in [0, n); z may alias u
+        // Acklam's approximation refined by one Halley step on the normal CDF of the kernel, as InverseNormalCdf
+        // does on std::erfc (the two agree to a few ulp)
+        void InverseNormalKernel(const double* u, double* z, std::size_t n);
+        
+        // One date of the paths [0, n) of a simulation: x = drift + sig * w[i] is the log price, x and exp(x) are
+        // added to logsum[i] and sum[i], and if barrier is set hit[i] becomes 1 once side * (level - exp(x)) >= 0
+        void PathDateKernel(const double* w, const double& drift, const double& sig, std::size_t n, const bool& barrier,
+                            const double& side, const double& level, double* sum, double* logsum, double* hit);
+    }
+}
+
+#endif
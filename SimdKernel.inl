@@ -0,0 +1,864 @@
+//  SimdKernel.inl
+//  Instruction set independent part of the vectorized kernels.
+//  This file is included once per instruction set by SimdKernel.cpp,
+//  inside a namespace that defines the pack type V, the mask type M,
+//  the width W, SIMD_TARGET and the pack operations (Set1, Load, Store,
+//  Add, Sub, Mul, Div, Fma, Sqrt, Min, Max, Lt, Gt, Eq, Select, All, And,
+//  Or, ShiftLeft52, ShiftRight52).
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////Math Functions///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Pack with every lane set to the given bit pattern
+SIMD_TARGET inline V Bits(const std::uint64_t& bits)
+{
+    double x;
+    std::memcpy(&x, &bits, sizeof(double));
+    return Set1(x);
+}
+
+// Absolute value
+SIMD_TARGET inline V Abs(const V& x)
+{
+    return And(x, Bits(0x7FFFFFFFFFFFFFFFULL));
+}
+
+// Exponential
+SIMD_TARGET inline V Exp(const V& x0)
+{
+    // Keep 2^n a normal number
+    V x = Min(Max(x0, Set1(-708.0)), Set1(708.0));
+
+    // n = round(x / ln2) with the 1.5 * 2^52 shifter
+    const V shifter = Set1(6755399441055744.0);
+    V n = Sub(Fma(x, Set1(1.4426950408889634), shifter), shifter);
+
+    // Reduced argument r = x - n * ln2 (ln2 split in two so that n * ln2_hi is exact)
+    V r = Fma(n, Set1(-6.93147180369123816490e-01), x);
+    r = Fma(n, Set1(-1.90821492927058770002e-10), r);
+
+    // exp(r) with |r| <= ln2 / 2 by its Taylor series up to r^13
+    V p = Set1(1.0 / 6227020800.0);
+    p = Fma(p, r, Set1(1.0 / 479001600.0));
+    p = Fma(p, r, Set1(1.0 / 39916800.0));
+    p = Fma(p, r, Set1(1.0 / 3628800.0));
+    p = Fma(p, r, Set1(1.0 / 362880.0));
+    p = Fma(p, r, Set1(1.0 / 40320.0));
+    p = Fma(p, r, Set1(1.0 / 5040.0));
+    p = Fma(p, r, Set1(1.0 / 720.0));
+    p = Fma(p, r, Set1(1.0 / 120.0));
+    p = Fma(p, r, Set1(1.0 / 24.0));
+    p = Fma(p, r, Set1(1.0 / 6.0));
+    p = Fma(p, r, Set1(0.5));
+    p = Fma(p, r, Set1(1.0));
+    p = Fma(p, r, Set1(1.0));
+
+    // 2^n: put n + 1023 in the exponent field
+    V scale = ShiftLeft52(Add(n, Set1(4503599627370496.0 + 1023.0)));
+
+    // Flush results below the normal range to 0
+    return Select(Lt(x0, Set1(-708.0)), Set1(0.0), Mul(p, scale));
+}
+
+// Natural logarithm of a positive normal number
+SIMD_TARGET inline V Log(const V& x)
+{
+    // Split x = m * 2^e with m in [1, 2)
+    const V two52 = Set1(4503599627370496.0);
+    V e = Sub(Or(ShiftRight52(x), two52), Add(two52, Set1(1023.0)));
+    V m = Or(And(x, Bits(0x000FFFFFFFFFFFFFULL)), Set1(1.0));
+
+    // Move m to [sqrt(1/2), sqrt(2))
+    M big = Gt(m, Set1(1.4142135623730951));
+    m = Select(big, Mul(m, Set1(0.5)), m);
+    e = Select(big, Add(e, Set1(1.0)), e);
+
+    // log(1 + f) = f - f^2/2 + s * (f^2/2 + R(s^2)) with s = f / (2 + f)
+    V f = Sub(m, Set1(1.0));
+    V s = Div(f, Add(f, Set1(2.0)));
+    V z = Mul(s, s);
+    V w = Mul(z, z);
+    V t1 = Mul(w, Fma(w, Fma(w, Set1(1.531383769920937332e-01), Set1(2.222219843214978396e-01)), Set1(3.999999999940941908e-01)));
+    V t2 = Mul(z, Fma(w, Fma(w, Fma(w, Set1(1.479819860511658591e-01), Set1(1.818357216161805012e-01)),
+                                Set1(2.857142874366239149e-01)), Set1(6.666666666666735130e-01)));
+    V R = Add(t1, t2);
+    V hfsq = Mul(Set1(0.5), Mul(f, f));
+
+    V lo = Fma(e, Set1(1.90821492927058770002e-10), Mul(s, Add(hfsq, R)));
+    return Fma(e, Set1(6.93147180369123816490e-01), Sub(f, Sub(hfsq, lo)));
+}
+
+// Standard normal CDF and PDF sharing one exponential
+SIMD_TARGET inline void NormCdfPdf(const V& x, V& cdf, V& pdf)
+{
+    V a = Abs(x);
+    V e = Exp(Mul(Mul(a, a), Set1(-0.5)));
+    pdf = Mul(e, Set1(0.3989422804014327));
+
+    // Hart's rational approximation for |x| < 7.07
+    V num = Set1(3.52624965998911e-02);
+    num = Fma(num, a, Set1(0.700383064443688));
+    num = Fma(num, a, Set1(6.37396220353165));
+    num = Fma(num, a, Set1(33.912866078383));
+    num = Fma(num, a, Set1(112.079291497871));
+    num = Fma(num, a, Set1(221.213596169931));
+    num = Fma(num, a, Set1(220.206867912376));
+    V den = Set1(8.83883476483184e-02);
+    den = Fma(den, a, Set1(1.75566716318264));
+    den = Fma(den, a, Set1(16.064177579207));
+    den = Fma(den, a, Set1(86.7807322029461));
+    den = Fma(den, a, Set1(296.564248779674));
+    den = Fma(den, a, Set1(637.333633378831));
+    den = Fma(den, a, Set1(793.826512519948));
+    den = Fma(den, a, Set1(440.413735824752));
+    V tail = Div(Mul(e, num), den);
+
+    // Continued fraction for the far tail, only when a lane needs it
+    M near = Lt(a, Set1(7.07106781186547));
+    if (!All(near))
+    {
+        V c = Add(a, Set1(0.65));
+        c = Add(a, Div(Set1(4.0), c));
+        c = Add(a, Div(Set1(3.0), c));
+        c = Add(a, Div(Set1(2.0), c));
+        c = Add(a, Div(Set1(1.0), c));
+        V far = Div(e, Mul(c, Set1(2.506628274631)));
+        tail = Select(near, tail, far);
+        tail = Select(Gt(a, Set1(37.0)), Set1(0.0), tail);
+    }
+
+    cdf = Select(Gt(x, Set1(0.0)), Sub(Set1(1.0), tail), tail);
+}
+
+// Standard normal CDF and PDF with the Abramowitz-Stegun polynomial 26.2.17 (absolute error below 7.5e-8)
+SIMD_TARGET inline void NormCdfPdfFast(const V& x, V& cdf, V& pdf)
+{
+    V a = Abs(x);
+    pdf = Mul(Exp(Mul(Mul(a, a), Set1(-0.5))), Set1(0.3989422804014327));
+    
+    V t = Div(Set1(1.0), Fma(a, Set1(0.2316419), Set1(1.0)));
+    V poly = Set1(1.330274429);
+    poly = Fma(poly, t, Set1(-1.821255978));
+    poly = Fma(poly, t, Set1(1.781477937));
+    poly = Fma(poly, t, Set1(-0.356563782));
+    poly = Fma(poly, t, Set1(0.319381530));
+    V tail = Mul(pdf, Mul(poly, t));
+    
+    cdf = Select(Gt(x, Set1(0.0)), Sub(Set1(1.0), tail), tail);
+}
+
+// Standard normal CDF and PDF from All_Options::NormalCdf/NormalPdf (boost), lane by lane
+SIMD_TARGET inline void NormCdfPdfExact(const V& x, V& cdf, V& pdf)
+{
+    double in[W], c[W], p[W];
+    Store(in, x);
+    for (std::size_t j = 0; j < W; j++)
+    {
+        c[j] = All_Options::NormalCdf(in[j], All_Options::EXACT);
+        p[j] = All_Options::NormalPdf(in[j], All_Options::EXACT);
+    }
+    cdf = Load(c);
+    pdf = Load(p);
+}
+
+// Standard normal CDF and PDF in the given accuracy mode
+SIMD_TARGET inline void NormCdfPdf(const V& x, V& cdf, V& pdf, const All_Options::NormalMode& mode)
+{
+    if (mode == All_Options::FAST)
+        NormCdfPdfFast(x, cdf, pdf);
+    else if (mode == All_Options::EXACT)
+        NormCdfPdfExact(x, cdf, pdf);
+    else
+        NormCdfPdf(x, cdf, pdf);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////Kernels/////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Output bits of the kernels (same values as All_Options::GreekMask)
+const unsigned OUT_PRICE = 1, OUT_DELTA = 2, OUT_GAMMA = 4, OUT_VEGA = 8, OUT_THETA = 16, OUT_RHO = 32;
+
+// Price and sensitivities of one pack of options in the carry regime C from the terms sqrtT = sqrt(T),
+// tmp = sig * sqrt(T), d1 and the discount factors dfr = exp(-r * T) and dfb = exp((b - r) * T)
+// w is +1 for calls and -1 for puts; out[k] receives the output with bit 1 << k
+template <All_Options::CarryRegime C>
+SIMD_TARGET inline void EuropeanOutputs(const V& T, const V& K, const V& sig, const V& r, const V& b, const V& S, const V& w,
+                                        const V& sqrtT, const V& tmp, const V& d1, const V& dfr, const V& dfb,
+                                        const unsigned& mask, const All_Options::NormalMode& mode, V* out)
+{
+    V d2 = Sub(d1, tmp);
+
+    // N(w * d1) and n(d1) are shared by every output, N(w * d2) only when an output needs it
+    V n1, pdf, n2 = Set1(0.0), unused;
+    NormCdfPdf(Mul(w, d1), n1, pdf, mode);
+    if (mask & (OUT_PRICE | OUT_THETA | OUT_RHO))
+        NormCdfPdf(Mul(w, d2), n2, unused, mode);
+
+    V sdfb = Mul(S, dfb);
+    V kdfr = Mul(K, dfr);
+    V price = Mul(w, Sub(Mul(sdfb, n1), Mul(kdfr, n2)));
+
+    if (mask & OUT_PRICE)
+        out[0] = price;
+    if (mask & OUT_DELTA)
+        out[1] = Mul(w, Mul(dfb, n1));
+    if (mask & OUT_GAMMA)
+        out[2] = Div(Mul(dfb, pdf), Mul(S, tmp));
+    if (mask & OUT_VEGA)
+        out[3] = Mul(Mul(sdfb, pdf), sqrtT);
+    if (mask & OUT_THETA)
+    {
+        V decay = Div(Mul(Mul(sdfb, pdf), Mul(sig, Set1(0.5))), sqrtT);
+        V rate = Mul(Mul(w, r), Mul(kdfr, n2));
+        V theta = Sub(Set1(0.0), decay);
+        if (C != All_Options::CARRY_STOCK) // The carry term is 0 for a stock
+            theta = Sub(theta, Mul(Mul(w, Sub(b, r)), Mul(sdfb, n1)));
+        out[4] = Sub(theta, rate);
+    }
+    if (mask & OUT_RHO) // Futures options (b = 0) lose only the discounting of the premium
+    {
+        if (C == All_Options::CARRY_FUTURES)
+            out[5] = Mul(Sub(Set1(0.0), T), price);
+        else if (C == All_Options::CARRY_GENERAL)
+            out[5] = Select(Eq(b, Set1(0.0)), Mul(Sub(Set1(0.0), T), price), Mul(Mul(w, T), Mul(kdfr, n2)));
+        else
+            out[5] = Mul(Mul(w, T), Mul(kdfr, n2));
+    }
+}
+
+// Price and sensitivities of one pack of options in the carry regime C (see EuropeanFormula.hpp)
+// w is +1 for calls and -1 for puts; out[k] receives the output with bit 1 << k
+template <All_Options::CarryRegime C>
+SIMD_TARGET inline void EuropeanPack(const V& T, const V& K, const V& sig, const V& r, const V& b, const V& S, const V& w,
+                                     const unsigned& mask, const All_Options::NormalMode& mode, V* out)
+{
+    V sqrtT = Sqrt(T);
+    V tmp = Mul(sig, sqrtT);
+    V d1 = Div(Fma(Fma(Mul(sig, sig), Set1(0.5), b), T, Log(Div(S, K))), tmp);
+    
+    // exp((b - r) * T) is 1 for a stock and exp(-r * T) for a futures
+    V dfr = Exp(Mul(Sub(Set1(0.0), r), T));
+    V dfb = (C == All_Options::CARRY_STOCK)? Set1(1.0) : (C == All_Options::CARRY_FUTURES)? dfr : Exp(Mul(Sub(b, r), T));
+    
+    EuropeanOutputs<C>(T, K, sig, r, b, S, w, sqrtT, tmp, d1, dfr, dfb, mask, mode, out);
+}
+
+// Price and sensitivities of rows [begin, end) of a batch, all in the carry regime C
+template <All_Options::CarryRegime C>
+SIMD_TARGET void EuropeanRows(const All_Options::OptionBatch& batch, std::size_t begin, std::size_t end,
+                              const All_Options::Simd::KernelOutput& output, const All_Options::NormalMode& mode)
+{
+    const double *T = batch.T(), *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+    const char* type = batch.type();
+
+    // Output columns in mask bit order
+    double* const dst[6] = { output.price, output.delta, output.gamma, output.vega, output.theta, output.rho };
+    unsigned mask = 0;
+    for (unsigned k = 0; k < 6; k++)
+        if (dst[k]) mask |= 1u << k;
+    if (mask == 0) return;
+
+    // +1 for calls, -1 for puts, filled block by block
+    const std::size_t block = 256;
+    double w[block];
+
+    for (std::size_t first = begin; first < end; first += block)
+    {
+        std::size_t last = (end - first < block)? end : first + block;
+        for (std::size_t i = first; i < last; i++)
+            w[i - first] = (type[i] == 'P' || type[i] == 'p')? -1.0 : 1.0;
+
+        std::size_t i = first;
+
+        // Full packs
+        for (; i + W <= last; i += W)
+        {
+            V out[6];
+            EuropeanPack<C>(Load(T + i), Load(K + i), Load(sig + i), Load(r + i), Load(b + i), Load(S + i), Load(w + i - first),
+                         mask, mode, out);
+            for (unsigned k = 0; k < 6; k++)
+                if (dst[k]) Store(dst[k] + i, out[k]);
+        }
+
+        // Remaining rows go through one padded pack
+        if (i < last)
+        {
+            double in[7][W], res[6][W];
+            for (std::size_t j = 0; j < W; j++)
+            {
+                bool valid = i + j < last;
+                in[0][j] = valid? T[i + j] : 1.0;
+                in[1][j] = valid? K[i + j] : 1.0;
+                in[2][j] = valid? sig[i + j] : 1.0;
+                in[3][j] = valid? r[i + j] : 0.0;
+                in[4][j] = valid? b[i + j] : 0.0;
+                in[5][j] = valid? S[i + j] : 1.0;
+                in[6][j] = valid? w[i + j - first] : 1.0;
+            }
+
+            V out[6];
+            EuropeanPack<C>(Load(in[0]), Load(in[1]), Load(in[2]), Load(in[3]), Load(in[4]), Load(in[5]), Load(in[6]), mask, mode, out);
+            for (unsigned k = 0; k < 6; k++)
+            {
+                if (!dst[k]) continue;
+                Store(res[k], out[k]);
+                for (std::size_t j = 0; i + j < last; j++)
+                    dst[k][i + j] = res[k][j];
+            }
+        }
+    }
+}
+
+// Price and sensitivities of rows [begin, end) of a batch
+// The pack is specialized once for the carry regime of the rows
+SIMD_TARGET void EuropeanKernel(const All_Options::OptionBatch& batch, std::size_t begin, std::size_t end,
+                                const All_Options::Simd::KernelOutput& output, const All_Options::NormalMode& mode,
+                                const All_Options::CarryRegime& carry)
+{
+    switch (carry)
+    {
+        case All_Options::CARRY_STOCK:   EuropeanRows<All_Options::CARRY_STOCK>(batch, begin, end, output, mode); return;
+        case All_Options::CARRY_FUTURES: EuropeanRows<All_Options::CARRY_FUTURES>(batch, begin, end, output, mode); return;
+        case All_Options::CARRY_MERTON:  EuropeanRows<All_Options::CARRY_MERTON>(batch, begin, end, output, mode); return;
+        default:                         EuropeanRows<All_Options::CARRY_GENERAL>(batch, begin, end, output, mode); return;
+    }
+}
+
+// d1 and the outputs of one pack of strikes of a chain, from the broadcast shared terms
+template <All_Options::CarryRegime C>
+SIMD_TARGET inline void ChainPack(const V& T, const V& K, const V& logK, const V& sig, const V& r, const V& b, const V& S,
+                                  const V& w, const V& sqrtT, const V& logS, const V& dfr, const V& dfb, const unsigned& mask,
+                                  const All_Options::NormalMode& mode, V* out)
+{
+    V tmp = Mul(sig, sqrtT);
+    V d1 = Div(Fma(Fma(Mul(sig, sig), Set1(0.5), b), T, Sub(logS, logK)), tmp);
+    EuropeanOutputs<C>(T, K, sig, r, b, S, w, sqrtT, tmp, d1, dfr, dfb, mask, mode, out);
+}
+
+// Price and sensitivities of strikes [begin, end) of a chain, all in the carry regime C
+// Only sig * sqrt(T) and d1 are computed per strike: log(S / K) is log(S) - log(K) from the cached logs,
+// and the discount factors are broadcast from the shared terms
+template <All_Options::CarryRegime C>
+SIMD_TARGET void ChainRows(const All_Options::Simd::ChainTerms& terms, const double* K, const double* logK, const double* sig,
+                           const char* type, std::size_t begin, std::size_t end,
+                           const All_Options::Simd::KernelOutput& output, const All_Options::NormalMode& mode)
+{
+    // Output columns in mask bit order
+    double* const dst[6] = { output.price, output.delta, output.gamma, output.vega, output.theta, output.rho };
+    unsigned mask = 0;
+    for (unsigned k = 0; k < 6; k++)
+        if (dst[k]) mask |= 1u << k;
+    if (mask == 0) return;
+    
+    V T = Set1(terms.T), r = Set1(terms.r), b = Set1(terms.b), S = Set1(terms.S), sqrtT = Set1(terms.sqrtT);
+    V logS = Set1(terms.logS), dfr = Set1(terms.dfr), dfb = Set1(terms.dfb);
+    
+    // +1 for calls, -1 for puts, filled block by block
+    const std::size_t block = 256;
+    double w[block];
+    
+    for (std::size_t first = begin; first < end; first += block)
+    {
+        std::size_t last = (end - first < block)? end : first + block;
+        for (std::size_t i = first; i < last; i++)
+            w[i - first] = (type[i] == 'P' || type[i] == 'p')? -1.0 : 1.0;
+        
+        std::size_t i = first;
+        
+        // Full packs
+        for (; i + W <= last; i += W)
+        {
+            V out[6];
+            ChainPack<C>(T, Load(K + i), Load(logK + i), Load(sig + i), r, b, S, Load(w + i - first),
+                         sqrtT, logS, dfr, dfb, mask, mode, out);
+            for (unsigned k = 0; k < 6; k++)
+                if (dst[k]) Store(dst[k] + i, out[k]);
+        }
+        
+        // Remaining strikes go through one padded pack
+        if (i < last)
+        {
+            double in[4][W], res[6][W];
+            for (std::size_t j = 0; j < W; j++)
+            {
+                bool valid = i + j < last;
+                in[0][j] = valid? K[i + j] : 1.0;
+                in[1][j] = valid? logK[i + j] : 0.0;
+                in[2][j] = valid? sig[i + j] : 1.0;
+                in[3][j] = valid? w[i + j - first] : 1.0;
+            }
+            
+            V out[6];
+            ChainPack<C>(T, Load(in[0]), Load(in[1]), Load(in[2]), r, b, S, Load(in[3]),
+                         sqrtT, logS, dfr, dfb, mask, mode, out);
+            for (unsigned k = 0; k < 6; k++)
+            {
+                if (!dst[k]) continue;
+                Store(res[k], out[k]);
+                for (std::size_t j = 0; i + j < last; j++)
+                    dst[k][i + j] = res[k][j];
+            }
+        }
+    }
+}
+
+// Price and sensitivities of strikes [begin, end) of a chain
+// The pack is specialized once for the carry regime of the chain
+SIMD_TARGET void ChainKernel(const All_Options::Simd::ChainTerms& terms, const double* K, const double* logK, const double* sig,
+                             const char* type, std::size_t begin, std::size_t end,
+                             const All_Options::Simd::KernelOutput& output, const All_Options::NormalMode& mode)
+{
+    switch (All_Options::ClassifyCarry(terms.r, terms.b))
+    {
+        case All_Options::CARRY_STOCK:   ChainRows<All_Options::CARRY_STOCK>(terms, K, logK, sig, type, begin, end, output, mode); return;
+        case All_Options::CARRY_FUTURES: ChainRows<All_Options::CARRY_FUTURES>(terms, K, logK, sig, type, begin, end, output, mode); return;
+        default:                         ChainRows<All_Options::CARRY_MERTON>(terms, K, logK, sig, type, begin, end, output, mode); return;
+    }
+}
+
+// Price, delta and gamma of rows [begin, end) of columns of S-independent terms at the spot S
+// d1 is (log(S) + drift) / vol; the outputs only need the discount factors, so the carry regime
+// and the factors of vega, theta and rho are not used
+SIMD_TARGET void SpotKernel(const All_Options::Simd::SpotColumns& terms, const double& spot, std::size_t begin, std::size_t end,
+                            const All_Options::Simd::KernelOutput& output, const All_Options::NormalMode& mode)
+{
+    // Output columns in mask bit order, only the first three are computed
+    double* const dst[3] = { output.price, output.delta, output.gamma };
+    unsigned mask = 0;
+    for (unsigned k = 0; k < 3; k++)
+        if (dst[k]) mask |= 1u << k;
+    if (mask == 0) return;
+    
+    V S = Set1(spot), logS = Set1(log(spot)), zero = Set1(0.0);
+    std::size_t i = begin;
+    
+    // Full packs
+    for (; i + W <= end; i += W)
+    {
+        V vol = Load(terms.vol + i), out[6];
+        V d1 = Div(Add(logS, Load(terms.drift + i)), vol);
+        EuropeanOutputs<All_Options::CARRY_GENERAL>(zero, Load(terms.K + i), zero, zero, zero, S, Load(terms.w + i), zero, vol,
+                                                    d1, Load(terms.dfr + i), Load(terms.dfb + i), mask, mode, out);
+        for (unsigned k = 0; k < 3; k++)
+            if (dst[k]) Store(dst[k] + i, out[k]);
+    }
+    
+    // Remaining rows go through one padded pack
+    if (i < end)
+    {
+        double in[6][W], res[3][W];
+        for (std::size_t j = 0; j < W; j++)
+        {
+            bool valid = i + j < end;
+            in[0][j] = valid? terms.K[i + j] : 1.0;
+            in[1][j] = valid? terms.drift[i + j] : 0.0;
+            in[2][j] = valid? terms.vol[i + j] : 1.0;
+            in[3][j] = valid? terms.dfr[i + j] : 1.0;
+            in[4][j] = valid? terms.dfb[i + j] : 1.0;
+            in[5][j] = valid? terms.w[i + j] : 1.0;
+        }
+        
+        V vol = Load(in[2]), out[6];
+        V d1 = Div(Add(logS, Load(in[1])), vol);
+        EuropeanOutputs<All_Options::CARRY_GENERAL>(zero, Load(in[0]), zero, zero, zero, S, Load(in[5]), zero, vol,
+                                                    d1, Load(in[3]), Load(in[4]), mask, mode, out);
+        for (unsigned k = 0; k < 3; k++)
+        {
+            if (!dst[k]) continue;
+            Store(res[k], out[k]);
+            for (std::size_t j = 0; i + j < end; j++)
+                dst[k][i + j] = res[k][j];
+        }
+    }
+}
+
+
+// Price and sensitivities of one pack of perpetual American options from the exponent y, written to dst[k] for each
+// non-null output k (see PerpetualAmericanOption::ExponentGreeks); c is K / (y - 1) for calls and K / (1 - y) for puts,
+// dys and dyr the derivatives of y in sig and r. x^y is exp(y * log(x)) while x is a positive normal number and
+// |y * log(x)| < 708; other lanes use pow, so every lane only depends on its own row
+SIMD_TARGET inline void PerpetualPack(const V& K, const V& S, const V& y, const V& c, const V& dys, const V& dyr,
+                                      double* const* dst)
+{
+    V x = Div(Div(Mul(Sub(y, Set1(1.0)), S), K), y);
+    V lx = Log(x);
+    V z = Mul(y, lx);
+    V price = Mul(c, Exp(z));
+    
+    if (dst[0]) Store(dst[0], price);
+    if (dst[1]) Store(dst[1], Div(Mul(y, price), S));
+    if (dst[2]) Store(dst[2], Div(Div(Mul(Mul(y, Sub(y, Set1(1.0))), price), S), S));
+    if (dst[3]) Store(dst[3], Mul(Mul(price, lx), dys));
+    if (dst[4]) Store(dst[4], Set1(0.0));
+    if (dst[5]) Store(dst[5], Mul(Mul(price, lx), dyr));
+    
+    if (All(Gt(x, Set1(2.2250738585072014e-308))) && All(Lt(Abs(z), Set1(708.0))))
+        return;
+    
+    double xs[W], zs[W], ys[W], cs[W], ss[W], dss[W], drs[W];
+    Store(xs, x); Store(zs, z); Store(ys, y); Store(cs, c); Store(ss, S); Store(dss, dys); Store(drs, dyr);
+    for (std::size_t j = 0; j < W; j++)
+    {
+        if (xs[j] > 2.2250738585072014e-308 && std::fabs(zs[j]) < 708.0)
+            continue;
+        double p = cs[j] * std::pow(xs[j], ys[j]);
+        if (dst[0]) dst[0][j] = p;
+        if (dst[1]) dst[1][j] = ys[j] * p / ss[j];
+        if (dst[2]) dst[2][j] = ys[j] * (ys[j] - 1) * p / ss[j] / ss[j];
+        if (dst[3]) dst[3][j] = p * std::log(xs[j]) * dss[j];
+        if (dst[5]) dst[5][j] = p * std::log(xs[j]) * drs[j];
+    }
+}
+
+// Price and sensitivities of the perpetual American options of rows [begin, end) of a batch
+// The exponent terms only depend on sig, r and b: they are kept in a table indexed by a hash of the bits of
+// (sig, r, b), so that the rows sharing a key reuse them whatever their order in the batch
+SIMD_TARGET void PerpetualKernel(const All_Options::OptionBatch& batch, std::size_t begin, std::size_t end,
+                                 const All_Options::Simd::KernelOutput& output)
+{
+    typedef All_Options::PerpetualAmerican::PerpetualAmericanOption Perpetual;
+    const double *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+    const char* type = batch.type();
+    
+    // Output columns in mask bit order
+    double* const dst[6] = { output.price, output.delta, output.gamma, output.vega, output.theta, output.rho };
+    if (!(dst[0] || dst[1] || dst[2] || dst[3] || dst[4] || dst[5])) return;
+    
+    // Exponent y, its derivatives in sig and r and the coefficient K / (y - 1) (calls) or K / (1 - y) (puts),
+    // filled block by block
+    const std::size_t block = 256;
+    double y[block], dys[block], dyr[block], c[block];
+    
+    // Exponent terms of the last keys met, one entry per hash; a key replaces the one in its entry
+    const unsigned entries = 64;
+    struct Entry
+    {
+        std::uint64_t key[3];
+        All_Options::PerpetualAmerican::PerpetualExponent call, put;
+        bool used;
+    } table[entries];
+    for (unsigned k = 0; k < entries; k++)
+        table[k].used = false;
+    
+    for (std::size_t first = begin; first < end; first += block)
+    {
+        std::size_t last = (end - first < block)? end : first + block;
+        for (std::size_t i = first; i < last; i++)
+        {
+            // Bits of the key, so that every value (NaN included) finds its entry
+            std::uint64_t key[3];
+            std::memcpy(key, sig + i, sizeof(double));
+            std::memcpy(key + 1, r + i, sizeof(double));
+            std::memcpy(key + 2, b + i, sizeof(double));
+            std::uint64_t hash = (key[0] * 0x9E3779B97F4A7C15ULL) ^ (key[1] * 0xC2B2AE3D27D4EB4FULL) ^ (key[2] * 0x165667B19E3779F9ULL);
+            Entry& entry = table[hash >> 58];
+            if (!entry.used || entry.key[0] != key[0] || entry.key[1] != key[1] || entry.key[2] != key[2])
+            {
+                entry.key[0] = key[0]; entry.key[1] = key[1]; entry.key[2] = key[2];
+                entry.call = Perpetual::ExponentTerms(sig[i], r[i], b[i], true);
+                entry.put = Perpetual::ExponentTerms(sig[i], r[i], b[i], false);
+                entry.used = true;
+            }
+            bool is_put = (type[i] == 'P' || type[i] == 'p');
+            const All_Options::PerpetualAmerican::PerpetualExponent& e = is_put? entry.put : entry.call;
+            y[i - first] = e.y;
+            dys[i - first] = e.dy_dsig;
+            dyr[i - first] = e.dy_dr;
+            c[i - first] = is_put? K[i] / (1 - e.y) : K[i] / (e.y - 1);
+        }
+        
+        std::size_t i = first;
+        
+        // Full packs
+        for (; i + W <= last; i += W)
+        {
+            double* at[6];
+            for (unsigned k = 0; k < 6; k++)
+                at[k] = dst[k]? dst[k] + i : 0;
+            std::size_t j = i - first;
+            PerpetualPack(Load(K + i), Load(S + i), Load(y + j), Load(c + j), Load(dys + j), Load(dyr + j), at);
+        }
+        
+        // Remaining rows go through one padded pack
+        if (i < last)
+        {
+            double in[6][W], res[6][W];
+            for (std::size_t j = 0; j < W; j++)
+            {
+                bool valid = i + j < last;
+                in[0][j] = valid? K[i + j] : 1.0;
+                in[1][j] = valid? S[i + j] : 1.0;
+                in[2][j] = valid? y[i + j - first] : 2.0;
+                in[3][j] = valid? c[i + j - first] : 1.0;
+                in[4][j] = valid? dys[i + j - first] : 0.0;
+                in[5][j] = valid? dyr[i + j - first] : 0.0;
+            }
+            
+            double* at[6];
+            for (unsigned k = 0; k < 6; k++)
+                at[k] = dst[k]? res[k] : 0;
+            PerpetualPack(Load(in[0]), Load(in[1]), Load(in[2]), Load(in[3]), Load(in[4]), Load(in[5]), at);
+            for (unsigned k = 0; k < 6; k++)
+            {
+                if (!dst[k]) continue;
+                for (std::size_t j = 0; i + j < last; j++)
+                    dst[k][i + j] = res[k][j];
+            }
+        }
+    }
+}
+
+
+// Price of one pack of options on trees of n steps, the lanes rolled back in lockstep (see LatticeOption)
+// w is +1 for calls and -1 for puts; node i of lane l is at value[i * W + l] and the spot S * exp(k * h) at power[(n + k) * W + l]
+SIMD_TARGET inline V LatticePack(const V& T, const V& K, const V& sig, const V& r, const V& b, const V& S, const V& w,
+                                 const std::size_t& n, const bool& trinomial, const bool& american, const bool& smooth,
+                                 double* value, double* power)
+{
+    // Step h in log(S) and discounted probabilities of moving up, staying and moving down
+    V dt = Div(T, Set1(static_cast<double>(n)));
+    V disc = Exp(Mul(Sub(Set1(0.0), r), dt));
+    V h, pu, pm, pd;
+    if (trinomial)
+    {
+        h = Mul(sig, Sqrt(Mul(Set1(3.0), dt)));
+        V nu = Sub(b, Mul(Set1(0.5), Mul(sig, sig)));
+        V a = Div(Fma(Mul(sig, sig), dt, Mul(Mul(nu, nu), Mul(dt, dt))), Mul(h, h));
+        V c = Div(Mul(nu, dt), h);
+        pu = Mul(disc, Mul(Set1(0.5), Add(a, c)));
+        pm = Mul(disc, Sub(Set1(1.0), a));
+        pd = Mul(disc, Mul(Set1(0.5), Sub(a, c)));
+    }
+    else
+    {
+        h = Mul(sig, Sqrt(dt));
+        V u = Exp(h), d = Exp(Sub(Set1(0.0), h));
+        V p = Div(Sub(Exp(Mul(b, dt)), d), Sub(u, d));
+        pu = Mul(disc, p);
+        pm = Set1(0.0);
+        pd = Mul(disc, Sub(Set1(1.0), p));
+    }
+    
+    // Spots of every level of the tree
+    for (std::size_t k = 0; k <= 2 * n; k++)
+        Store(power + k * W, Mul(S, Exp(Mul(Set1(static_cast<double>(k) - static_cast<double>(n)), h))));
+    
+    // Node i of step j is at k = 2i - j (binomial, j + 1 nodes) or k = i - j (trinomial, 2j + 1 nodes)
+    std::size_t stride = trinomial? W : 2 * W;
+    
+    // Values at expiry, or one step before it for BBS
+    std::size_t last = smooth? n - 1 : n;
+    std::size_t nodes = trinomial? 2 * last + 1 : last + 1;
+    const double* s = power + (n - last) * W;
+    for (std::size_t i = 0; i < nodes; i++)
+    {
+        V spot = Load(s + i * stride);
+        V exercise = Max(Mul(w, Sub(spot, K)), Set1(0.0));
+        if (!smooth)
+        {
+            Store(value + i * W, exercise);
+            continue;
+        }
+        V out[6];
+        EuropeanPack<All_Options::CARRY_GENERAL>(dt, K, sig, r, b, spot, w, OUT_PRICE, All_Options::HIGH_ACCURACY, out);
+        Store(value + i * W, american? Max(out[0], exercise) : out[0]);
+    }
+    
+    // Roll back in place: node i of step j only reads nodes i and above of step j + 1
+    for (std::size_t j = last; j-- > 0;)
+    {
+        nodes = trinomial? 2 * j + 1 : j + 1;
+        s = power + (n - j) * W;
+        for (std::size_t i = 0; i < nodes; i++)
+        {
+            double* at = value + i * W;
+            V v = trinomial? Fma(pd, Load(at), Fma(pm, Load(at + W), Mul(pu, Load(at + 2 * W))))
+                           : Fma(pd, Load(at), Mul(pu, Load(at + W)));
+            Store(at, american? Max(v, Mul(w, Sub(Load(s + i * stride), K))) : v);
+        }
+    }
+    return Load(value);
+}
+
+// Prices of rows [begin, end) of a batch on trees of the same settings, W rows at a time
+// Rows where the tree degenerates (T, sig or S is 0) take LatticeOption::DegeneratePrice
+SIMD_TARGET void LatticeKernel(const All_Options::OptionBatch& batch, std::size_t begin, std::size_t end,
+                               const All_Options::Lattice::LatticeConfig& config, const All_Options::ExerciseStyle& style,
+                               double* price)
+{
+    const double *T = batch.T(), *K = batch.K(), *sig = batch.sig(), *r = batch.r(), *b = batch.b(), *S = batch.S();
+    const char* type = batch.type();
+    
+    bool trinomial = (config.type == All_Options::Lattice::TRINOMIAL);
+    bool american = (style == All_Options::AMERICAN_EXERCISE);
+    bool smooth = (config.smoothing != All_Options::Lattice::NO_SMOOTHING);
+    bool richardson = (config.smoothing == All_Options::Lattice::BBS_RICHARDSON);
+    const std::size_t& n = config.steps;
+    
+    // Nodes and spots of one pack, shared by all the packs of the rows and kept by each thread between calls
+    static thread_local std::vector<double> value, power;
+    if (value.size() < (2 * n + 1) * W)
+    {
+        value.resize((2 * n + 1) * W);
+        power.resize((2 * n + 1) * W);
+    }
+    
+    for (std::size_t i = begin; i < end; i += W)
+    {
+        // Every pack goes through the same padded load, so a row only depends on its own inputs
+        double in[7][W], res[W];
+        for (std::size_t j = 0; j < W; j++)
+        {
+            std::size_t row = i + j;
+            bool valid = row < end && T[row] > 0 && sig[row] > 0 && S[row] > 0;
+            in[0][j] = valid? T[row] : 1.0;
+            in[1][j] = valid? K[row] : 1.0;
+            in[2][j] = valid? sig[row] : 1.0;
+            in[3][j] = valid? r[row] : 0.0;
+            in[4][j] = valid? b[row] : 0.0;
+            in[5][j] = valid? S[row] : 1.0;
+            in[6][j] = (row < end && (type[row] == 'P' || type[row] == 'p'))? -1.0 : 1.0;
+        }
+        
+        V pack[7];
+        for (unsigned k = 0; k < 7; k++)
+            pack[k] = Load(in[k]);
+        V p = LatticePack(pack[0], pack[1], pack[2], pack[3], pack[4], pack[5], pack[6],
+                          n, trinomial, american, smooth, value.data(), power.data());
+        if (richardson)
+            p = Sub(Mul(Set1(2.0), p), LatticePack(pack[0], pack[1], pack[2], pack[3], pack[4], pack[5], pack[6],
+                                                   n / 2, trinomial, american, true, value.data(), power.data()));
+        Store(res, p);
+        
+        for (std::size_t j = 0; j < W && i + j < end; j++)
+        {
+            std::size_t row = i + j;
+            if (T[row] > 0 && sig[row] > 0 && S[row] > 0)
+                price[row] = res[j];
+            else
+                price[row] = All_Options::Lattice::LatticeOption::DegeneratePrice(T[row], K[row], r[row], b[row], S[row],
+                                                                                  in[6][j] > 0, style);
+        }
+    }
+}
+
+
+// Standard normal numbers of uniforms p in (0, 1) (see All_Options::InverseNormalCdf): Acklam's rational approximation
+// on the central region and on the tails, then one Halley step on the normal CDF and PDF of the kernel
+SIMD_TARGET inline V InverseNormalPack(const V& p)
+{
+    const double low = 0.02425;
+    
+    // Central region
+    V q = Sub(p, Set1(0.5));
+    V t = Mul(q, q);
+    V num = Set1(-3.969683028665376e+01);
+    num = Fma(num, t, Set1(2.209460984245205e+02));
+    num = Fma(num, t, Set1(-2.759285104469687e+02));
+    num = Fma(num, t, Set1(1.383577518672690e+02));
+    num = Fma(num, t, Set1(-3.066479806614716e+01));
+    num = Fma(num, t, Set1(2.506628277459239e+00));
+    V den = Set1(-5.447609879822406e+01);
+    den = Fma(den, t, Set1(1.615858368580409e+02));
+    den = Fma(den, t, Set1(-1.556989798598866e+02));
+    den = Fma(den, t, Set1(6.680131188771972e+01));
+    den = Fma(den, t, Set1(-1.328068155288572e+01));
+    den = Fma(den, t, Set1(1.0));
+    V x = Div(Mul(num, q), den);
+    
+    // Tails, from the smaller of p and 1 - p, only when a lane needs them
+    M central = Lt(Abs(q), Set1(0.5 - low));
+    if (!All(central))
+    {
+        V s = Sqrt(Mul(Set1(-2.0), Log(Min(p, Sub(Set1(1.0), p)))));
+        V tn = Set1(-7.784894002430293e-03);
+        tn = Fma(tn, s, Set1(-3.223964580411365e-01));
+        tn = Fma(tn, s, Set1(-2.400758277161838e+00));
+        tn = Fma(tn, s, Set1(-2.549732539343734e+00));
+        tn = Fma(tn, s, Set1(4.374664141464968e+00));
+        tn = Fma(tn, s, Set1(2.938163982698783e+00));
+        V td = Set1(7.784695709041462e-03);
+        td = Fma(td, s, Set1(3.224671290700398e-01));
+        td = Fma(td, s, Set1(2.445134137142996e+00));
+        td = Fma(td, s, Set1(3.754408661907416e+00));
+        td = Fma(td, s, Set1(1.0));
+        V tail = Div(tn, td);
+        tail = Select(Gt(p, Set1(0.5)), Sub(Set1(0.0), tail), tail);
+        x = Select(central, x, tail);
+    }
+    
+    // One Halley step on N(x) - p
+    V cdf, pdf;
+    NormCdfPdf(x, cdf, pdf);
+    V u = Div(Sub(cdf, p), pdf);
+    return Sub(x, Div(u, Fma(Mul(Set1(0.5), x), u, Set1(1.0))));
+}
+
+// Standard normal numbers z[i] of the uniforms u[i] in (0, 1), i in [0, n); z may alias u
+SIMD_TARGET void InverseNormalKernel(const double* u, double* z, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + W <= n; i += W)
+        Store(z + i, InverseNormalPack(Load(u + i)));
+    
+    // Remaining values go through one padded pack
+    if (i < n)
+    {
+        double in[W], res[W];
+        for (std::size_t j = 0; j < W; j++)
+            in[j] = (i + j < n)? u[i + j] : 0.5;
+        Store(res, InverseNormalPack(Load(in)));
+        for (std::size_t j = 0; i + j < n; j++)
+            z[i + j] = res[j];
+    }
+}
+
+// One date of paths: the log price x = drift + sig * w and the price exp(x), added to sum and logsum; hit becomes 1 once
+// side * (level - price) >= 0 if barrier is set
+SIMD_TARGET inline void PathDatePack(const V& w, const V& drift, const V& sig, const bool& barrier, const V& side,
+                                     const V& level, double* sum, double* logsum, double* hit)
+{
+    V x = Fma(sig, w, drift);
+    V price = Exp(x);
+    Store(sum, Add(Load(sum), price));
+    Store(logsum, Add(Load(logsum), x));
+    if (barrier)
+        Store(hit, Select(Lt(Mul(side, Sub(level, price)), Set1(0.0)), Load(hit), Set1(1.0)));
+}
+
+// Prices of the paths [0, n) on one date from their Brownian motion w (see Simd::PathDateKernel)
+SIMD_TARGET void PathDateKernel(const double* w, const double& drift, const double& sig, std::size_t n, const bool& barrier,
+                                const double& side, const double& level, double* sum, double* logsum, double* hit)
+{
+    const V vd = Set1(drift), vs = Set1(sig), vside = Set1(side), vlevel = Set1(level);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W)
+        PathDatePack(Load(w + i), vd, vs, barrier, vside, vlevel, sum + i, logsum + i, hit + i);
+    
+    // Remaining paths go through one padded pack
+    if (i < n)
+    {
+        double in[W], s[W], ls[W], h[W];
+        for (std::size_t j = 0; j < W; j++)
+        {
+            bool valid = i + j < n;
+            in[j] = valid? w[i + j] : 0.0;
+            s[j] = valid? sum[i + j] : 0.0;
+            ls[j] = valid? logsum[i + j] : 0.0;
+            h[j] = valid? hit[i + j] : 0.0;
+        }
+        PathDatePack(Load(in), vd, vs, barrier, vside, vlevel, s, ls, h);
+        for (std::size_t j = 0; i + j < n; j++)
+        {
+            sum[i + j] = s[j];
+            logsum[i + j] = ls[j];
+            hit[i + j] = h[j];
+        }
+    }
+}
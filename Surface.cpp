@@ -0,0 +1,44 @@
+//  Surface.cpp
+//  Price or sensitivity surfaces of an option over two varying factors.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "Surface.hpp"
+#include "Exception.hpp"
+
+namespace All_Options
+{
+    // Values of one axis, with the same accumulation as GenerateMatrix
+    static std::vector<double> AxisValues(const SurfaceAxis& axis)
+    {
+        // Check range and step
+        if (((axis.end - axis.start) < 0 && axis.step >= 0) || ((axis.end - axis.start) > 0 && axis.step <= 0) || axis.step == 0)
+            throw InvalidStepException(axis.step, axis.start, axis.end);
+        
+        // Check the value of the factor
+        if ((axis.end < 0 || axis.start < 0) || ((axis.end == 0 || axis.start == 0) && axis.factor == Factor::K))
+            throw InvalidValueException();
+        
+        std::vector<double> values;
+        int direction = (axis.end > axis.start)? 1:-1;
+        for (double i = axis.start; (i - axis.end) * direction <= 0; i += axis.step)
+            values.push_back(i);
+        return values;
+    }
+    
+    
+    // Check the two axes and size the surface
+    void PrepareSurface(OptionSurface& surface, const SurfaceAxis& rows, const SurfaceAxis& cols)
+    {
+        if (rows.factor == cols.factor)
+            throw InvalidFactorException(FactorName(cols.factor));
+        
+        surface.row_factor = rows.factor;
+        surface.col_factor = cols.factor;
+        surface.row_values = AxisValues(rows);
+        surface.col_values = AxisValues(cols);
+        surface.values.assign(surface.row_values.size() * surface.col_values.size(), 0.0);
+    }
+}
@@ -0,0 +1,78 @@
+//  Surface.hpp
+//  Price or sensitivity surfaces of an option over two varying factors.
+//  The grid is stored row-major in one contiguous vector and is
+//  evaluated in tiles of SurfaceTileRows x SurfaceTileCols points, which
+//  keeps the outputs being written in cache and gives the thread pool
+//  independent pieces of work.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef Surface_hpp
+#define Surface_hpp
+
+#include <cstddef>
+#include <vector>
+#include "OptionData.hpp"
+#include "ThreadPool.hpp"
+
+namespace All_Options
+{
+    // One axis of a surface: a factor from start to end with the given step
+    struct SurfaceAxis
+    {
+        Factor factor;
+        double start;
+        double end;
+        double step;
+    };
+    
+    // Values of an option over a grid of two factors
+    struct OptionSurface
+    {
+        Factor row_factor;              // Factor varying from row to row
+        Factor col_factor;              // Factor varying from column to column
+        std::vector<double> row_values; // Value of the row factor on each row
+        std::vector<double> col_values; // Value of the column factor in each column
+        std::vector<double> values;     // Row-major grid, values[i * col_values.size() + j]
+    };
+    
+    // Rows and columns of a tile (64 KB of outputs)
+    const std::size_t SurfaceTileRows = 16;
+    const std::size_t SurfaceTileCols = 512;
+    
+    // Check the two axes and size the surface
+    // Throw InvalidFactorException if both axes vary the same factor,
+    // InvalidStepException or InvalidValueException for a bad range
+    void PrepareSurface(OptionSurface& surface, const SurfaceAxis& rows, const SurfaceAxis& cols);
+    
+    // Call tile(row_begin, row_end, col_begin, col_end) on every tile of the surface
+    // The tiles run on the pool when one is given, in order on the calling thread otherwise
+    template <typename F>
+    void ForEachTile(const OptionSurface& surface, F& tile, ThreadPool* pool, const ParallelConfig& config)
+    {
+        std::size_t rows = surface.row_values.size(), cols = surface.col_values.size();
+        std::size_t row_tiles = (rows + SurfaceTileRows - 1) / SurfaceTileRows;
+        std::size_t col_tiles = (cols + SurfaceTileCols - 1) / SurfaceTileCols;
+        
+        auto chunk = [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t t = begin; t < end; t++)
+            {
+                std::size_t row = (t / col_tiles) * SurfaceTileRows, col = (t % col_tiles) * SurfaceTileCols;
+                std::size_t row_end = (row + SurfaceTileRows < rows)? row + SurfaceTileRows : rows;
+                std::size_t col_end = (col + SurfaceTileCols < cols)? col + SurfaceTileCols : cols;
+                tile(row, row_end, col, col_end);
+            }
+        };
+        
+        // One tile per chunk, a tile is already a large piece of work
+        if (pool)
+            pool->ParallelFor(row_tiles * col_tiles, 1, chunk, config.threads);
+        else
+            chunk(0, row_tiles * col_tiles);
+    }
+}
+
+#endif
@@ -0,0 +1,174 @@
+//  ThreadPool.cpp
+//  Persistent pool of worker threads used by the parallel batch functions.
+//  A job is a range of rows split into fixed-size chunks; the calling
+//  thread and the workers take chunks until none are left. Each chunk
+//  writes only its own rows, so the results do not depend on the number
+//  of threads or on which thread ran which chunk.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "ThreadPool.hpp"
+
+namespace All_Options
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Constructors////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Create a pool that runs jobs on the given number of threads (0 for all hardware threads)
+    ThreadPool::ThreadPool(std::size_t threads):
+    job(0), context(0), total(0), chunk(1), helpers(0), next(0), busy(0), generation(0), stop(false)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+
+        // The calling thread is one of the threads
+        for (std::size_t i = 0; i + 1 < threads; i++)
+            workers.push_back(std::thread(&ThreadPool::Worker, this, i));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////Destructor//////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+
+        for (std::size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of threads a job can run on, including the caller
+    std::size_t ThreadPool::size() const
+    {
+        return workers.size() + 1;
+    }
+
+    // Pool shared by the batch functions, created on first use with all hardware threads
+    ThreadPool& ThreadPool::Shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////Private Functions////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Loop of each worker thread
+    void ThreadPool::Worker(std::size_t index)
+    {
+        unsigned long seen = 0;
+
+        while (true)
+        {
+            // Wait for a new job
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (!stop && generation == seen)
+                    wake.wait(lock);
+                if (stop) return;
+                seen = generation;
+
+                // Workers beyond the requested thread count sit this job out
+                if (index >= helpers) continue;
+            }
+
+            RunChunks();
+
+            // Tell the caller this worker is done
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0)
+                    finished.notify_one();
+            }
+        }
+    }
+
+    // Take chunks of the current job until none are left
+    void ThreadPool::RunChunks()
+    {
+        while (true)
+        {
+            std::size_t begin = next.fetch_add(chunk);
+            if (begin >= total) return;
+            std::size_t end = (total - begin < chunk)? total : begin + chunk;
+
+            try
+            {
+                job(context, begin, end);
+            }
+            catch (...)
+            {
+                // Keep the first exception and stop handing out chunks
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                next.store(total);
+                return;
+            }
+        }
+    }
+
+    // Run a job given as a chunk function and its context
+    void ThreadPool::Run(void (*func)(void*, std::size_t, std::size_t), void* ctx,
+                         std::size_t n, std::size_t rows_per_chunk, std::size_t threads)
+    {
+        if (n == 0) return;
+        if (rows_per_chunk == 0) rows_per_chunk = 1;
+        if (threads == 0 || threads > size()) threads = size();
+
+        // A single thread or a single chunk runs directly on the caller
+        if (threads == 1 || n <= rows_per_chunk)
+        {
+            for (std::size_t begin = 0; begin < n; begin += rows_per_chunk)
+                func(ctx, begin, (n - begin < rows_per_chunk)? n : begin + rows_per_chunk);
+            return;
+        }
+
+        std::lock_guard<std::mutex> job_lock(job_mutex);
+
+        // Publish the job and wake the workers
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = func;
+            context = ctx;
+            total = n;
+            chunk = rows_per_chunk;
+            helpers = threads - 1;
+            busy = helpers;
+            next.store(0);
+            error = std::exception_ptr();
+            generation++;
+        }
+        wake.notify_all();
+
+        // The caller takes chunks too
+        RunChunks();
+
+        // Wait for the workers
+        std::exception_ptr failure;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (busy != 0)
+                finished.wait(lock);
+            failure = error;
+            error = std::exception_ptr();
+        }
+
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+}
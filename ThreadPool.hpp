@@ -0,0 +1,113 @@
+//  ThreadPool.hpp
+//  Persistent pool of worker threads used by the parallel batch functions.
+//  A job is a range of rows split into fixed-size chunks; the calling
+//  thread and the workers take chunks until none are left. Each chunk
+//  writes only its own rows, so the results do not depend on the number
+//  of threads or on which thread ran which chunk.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace All_Options
+{
+    class ThreadPool;
+
+    // Number of threads and rows per chunk used by the parallel batch functions
+    struct ParallelConfig
+    {
+        std::size_t threads = 0;    // Threads taking part, 0 for every thread of the pool
+        std::size_t chunk = 4096;   // Rows handed to a thread at a time
+        ThreadPool* pool = 0;       // Pool to run on, 0 for ThreadPool::Shared()
+    };
+
+    class ThreadPool
+    {
+    private:
+        ///////////////////////////////////////////Private data//////////////////////////////////////////////////
+
+        std::vector<std::thread> workers;   // Worker threads (the caller is the extra thread)
+
+        std::mutex job_mutex;               // Only one job runs at a time
+        std::mutex mutex;                   // Guards the job description below
+        std::condition_variable wake;       // Signals workers that a job is ready
+        std::condition_variable finished;   // Signals the caller that the workers are done
+
+        void (*job)(void*, std::size_t, std::size_t);   // Chunk function of the current job
+        void* context;                                  // Object the chunk function works on
+        std::size_t total;                              // Rows of the current job
+        std::size_t chunk;                              // Rows per chunk
+        std::size_t helpers;                            // Workers taking part in the current job
+        std::atomic<std::size_t> next;                  // First row of the next chunk to hand out
+        std::size_t busy;                               // Workers still running the current job
+        unsigned long generation;                       // Incremented for each job
+        bool stop;                                      // Set when the pool is destroyed
+        std::exception_ptr error;                       // First exception thrown by a chunk
+
+        ////////////////////////////////////////Private Functions///////////////////////////////////////////
+
+        // Loop of each worker thread
+        void Worker(std::size_t index);
+
+        // Take chunks of the current job until none are left
+        void RunChunks();
+
+        // Run a job given as a chunk function and its context
+        void Run(void (*func)(void*, std::size_t, std::size_t), void* ctx,
+                 std::size_t n, std::size_t rows_per_chunk, std::size_t threads);
+
+        // Call a functor on one chunk
+        template <typename F>
+        static void Invoke(void* ctx, std::size_t begin, std::size_t end)
+        {
+            (*static_cast<F*>(ctx))(begin, end);
+        }
+
+        // Not copyable
+        ThreadPool(const ThreadPool&);
+        ThreadPool& operator = (const ThreadPool&);
+
+    public:
+        ////////////////////////////////////////Constructors///////////////////////////////////////////////
+
+        // Create a pool that runs jobs on the given number of threads (0 for all hardware threads)
+        explicit ThreadPool(std::size_t threads = 0);
+
+        /////////////////////////////////////////Destructor/////////////////////////////////////////////////
+
+        ~ThreadPool();
+
+        ///////////////////////////////////////////Getters//////////////////////////////////////////////////
+
+        // Number of threads a job can run on, including the caller
+        std::size_t size() const;
+
+        // Pool shared by the batch functions, created on first use with all hardware threads
+        static ThreadPool& Shared();
+
+        ////////////////////////////////////////Parallel Loop///////////////////////////////////////////////
+
+        // Call f(begin, end) for every chunk of [0, n) on up to the given number of threads
+        // (0 for the whole pool). Returns when every chunk is done; if a chunk throws, the remaining
+        // chunks are skipped and the first exception is rethrown here.
+        // Does not allocate, so it can be used on latency-sensitive paths.
+        template <typename F>
+        void ParallelFor(std::size_t n, std::size_t rows_per_chunk, F& f, std::size_t threads = 0)
+        {
+            Run(&ThreadPool::Invoke<F>, &f, n, rows_per_chunk, threads);
+        }
+    };
+}
+
+#endif
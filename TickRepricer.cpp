@@ -0,0 +1,243 @@
+//  TickRepricer.cpp
+//  Book of European options indexed by underlying, repriced tick by tick.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#include "TickRepricer.hpp"
+#include "SimdKernel.hpp"
+#include "Exception.hpp"
+#include <cmath>
+
+namespace All_Options
+{
+    // Columns of the terms of an underlying for the kernel
+    template <typename U>
+    static Simd::SpotColumns Columns(const U& u)
+    {
+        Simd::SpotColumns terms;
+        terms.K = u.K.data();
+        terms.drift = u.drift.data();
+        terms.vol = u.vol.data();
+        terms.dfr = u.dfr.data();
+        terms.dfb = u.dfb.data();
+        terms.w = u.w.data();
+        return terms;
+    }
+    
+    // Delta-gamma expansion of totals from the reference spot by dS
+    static TickRisk Expand(const TickRisk& total, const double& dS)
+    {
+        TickRisk risk;
+        risk.value = total.value + dS * (total.delta + 0.5 * dS * total.gamma);
+        risk.delta = total.delta + dS * total.gamma;
+        risk.gamma = total.gamma;
+        return risk;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Private Functions/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Underlying of a name
+    TickRepricer::Underlying& TickRepricer::Find(const std::string& name)
+    {
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(name);
+        if (it == index.end())
+            throw InvalidValueException();
+        return underlyings[it->second];
+    }
+    
+    const TickRepricer::Underlying& TickRepricer::Find(const std::string& name) const
+    {
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(name);
+        if (it == index.end())
+            throw InvalidValueException();
+        return underlyings[it->second];
+    }
+    
+    // Reprice every option of an underlying at its spot, which becomes the reference
+    TickRisk TickRepricer::Full(Underlying& u) const
+    {
+        std::size_t n = u.K.size();
+        Simd::KernelOutput out;
+        out.price = u.price.data();
+        out.delta = u.delta.data();
+        out.gamma = u.gamma.data();
+        Simd::SpotKernel(Columns(u), u.S, 0, n, out, config.mode);
+        
+        TickRisk total;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            total.value += u.quantity[i] * u.price[i];
+            total.delta += u.quantity[i] * u.delta[i];
+            total.gamma += u.quantity[i] * u.gamma[i];
+        }
+        u.total = total;
+        u.reference = u.S;
+        
+        total.repriced = n;
+        return total;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////Constructors/////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    TickRepricer::TickRepricer(): config(), underlyings(), index(), ids() {}
+    
+    TickRepricer::TickRepricer(const RepricerConfig& c): config(), underlyings(), index(), ids()
+    {
+        set_config(c);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////Getter and Modifier////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Get the settings
+    const RepricerConfig& TickRepricer::get_config() const
+    {
+        return config;
+    }
+    
+    // Set the settings
+    void TickRepricer::set_config(const RepricerConfig& c)
+    {
+        if (!(c.threshold >= 0))
+            throw InvalidValueException();
+        config = c;
+    }
+    
+    // Number of options
+    std::size_t TickRepricer::size() const
+    {
+        return ids.size();
+    }
+    
+    // Number of underlyings
+    std::size_t TickRepricer::Underlyings() const
+    {
+        return underlyings.size();
+    }
+    
+    // Current spot of an underlying
+    double TickRepricer::get_S(const std::string& underlying) const
+    {
+        return Find(underlying).S;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////Book///////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Add quantity options of data on the underlying data.name and return the id of the position
+    std::size_t TickRepricer::Add(const struct OptionData& data, const double& quantity)
+    {
+        // Check the data before changing the book
+        char type = (data.optType != 0)? data.optType : 'C';
+        if (type != 'C' && type != 'P' && type != 'c' && type != 'p')
+            throw InvalidOptionTypeException(type);
+        if (!(data.T > 0) || !(data.K > 0) || !(data.sig > 0) || !(data.S > 0) || data.r < 0 || data.b < 0)
+            throw InvalidValueException();
+        
+        std::unordered_map<std::string, std::size_t>::const_iterator it = index.find(data.name);
+        std::size_t k;
+        if (it == index.end())
+        {
+            k = underlyings.size();
+            underlyings.push_back(Underlying());
+            underlyings[k].name = data.name;
+            underlyings[k].S = data.S;
+            underlyings[k].reference = data.S;
+            index[data.name] = k;
+        }
+        else
+            k = it->second;
+        Underlying& u = underlyings[k];
+        
+        // Terms of the option that do not depend on the spot
+        double sqrtT = sqrt(data.T);
+        u.K.push_back(data.K);
+        u.drift.push_back((data.b + 0.5 * data.sig * data.sig) * data.T - log(data.K));
+        u.vol.push_back(data.sig * sqrtT);
+        u.dfr.push_back(exp(-data.r * data.T));
+        u.dfb.push_back(exp((data.b - data.r) * data.T));
+        u.w.push_back((type == 'P' || type == 'p')? -1.0 : 1.0);
+        u.quantity.push_back(quantity);
+        
+        // Price the option at the reference spot, so that the expansion of the underlying still holds
+        std::size_t row = u.K.size() - 1;
+        u.price.push_back(0);
+        u.delta.push_back(0);
+        u.gamma.push_back(0);
+        Simd::KernelOutput out;
+        out.price = u.price.data();
+        out.delta = u.delta.data();
+        out.gamma = u.gamma.data();
+        Simd::SpotKernel(Columns(u), u.reference, row, row + 1, out, config.mode);
+        u.total.value += quantity * u.price[row];
+        u.total.delta += quantity * u.delta[row];
+        u.total.gamma += quantity * u.gamma[row];
+        
+        ids.push_back(std::make_pair(k, row));
+        return ids.size() - 1;
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////Ticks/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Move the spot of an underlying and return the totals of its positions at the new spot
+    TickRisk TickRepricer::OnTick(const std::string& underlying, const double& S)
+    {
+        if (!(S > 0))
+            throw InvalidValueException();
+        Underlying& u = Find(underlying);
+        u.S = S;
+        
+        // Small moves only expand the totals; the prices of the options are expanded when asked for
+        double dS = S - u.reference;
+        if (config.threshold > 0 && fabs(dS) <= config.threshold * u.reference)
+            return Expand(u.total, dS);
+        
+        return Full(u);
+    }
+    
+    // Reprice every option of an underlying in full at its current spot
+    TickRisk TickRepricer::Reprice(const std::string& underlying)
+    {
+        Underlying& u = Find(underlying);
+        return Full(u);
+    }
+    
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    
+    // Totals of the positions of an underlying at its current spot
+    TickRisk TickRepricer::Risk(const std::string& underlying) const
+    {
+        const Underlying& u = Find(underlying);
+        if (u.S == u.reference)
+            return u.total;
+        return Expand(u.total, u.S - u.reference);
+    }
+    
+    // Price, delta and gamma of one option at the current spot of its underlying
+    OptionGreeks TickRepricer::Greeks(const std::size_t& id) const
+    {
+        if (id >= ids.size())
+            throw InvalidValueException();
+        const Underlying& u = underlyings[ids[id].first];
+        std::size_t row = ids[id].second;
+        
+        OptionGreeks greeks;
+        double dS = u.S - u.reference;
+        greeks.price = u.price[row] + dS * (u.delta[row] + 0.5 * dS * u.gamma[row]);
+        greeks.delta = u.delta[row] + dS * u.gamma[row];
+        greeks.gamma = u.gamma[row];
+        return greeks;
+    }
+}
@@ -0,0 +1,135 @@
+//  TickRepricer.hpp
+//  Book of European options indexed by underlying, repriced tick by
+//  tick. The terms of each option that do not depend on the spot
+//  ((b + sig^2 / 2) T - log(K), sig sqrt(T) and the discount factors)
+//  are computed once when the option is added and kept as columns of
+//  its underlying. A tick only touches the options of its underlying:
+//  in full, one pass of the vectorized kernel evaluates d1 and the
+//  normal distribution of each option at the new spot. Below a move
+//  threshold, the delta-gamma expansion from the last full repricing is
+//  used instead, and the totals of the underlying are updated in O(1);
+//  the price of an option is then expanded when it is asked for.
+//
+//  AB
+//
+//  Created by Yaojia Huang on 2018/11/5.
+
+#ifndef TickRepricer_hpp
+#define TickRepricer_hpp
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "OptionData.hpp"
+#include "Greeks.hpp"
+#include "NormalDistribution.hpp"
+
+namespace All_Options
+{
+    // Settings of a repricer
+    struct RepricerConfig
+    {
+        // Relative move of the spot from the last full repricing of an underlying, |S / S_ref - 1|, up to which
+        // a tick uses the delta-gamma expansion (0 reprices every tick in full)
+        double threshold = 0;
+        NormalMode mode = HIGH_ACCURACY;
+    };
+    
+    // Totals of the positions of an underlying (quantity times the price, delta and gamma of each option)
+    struct TickRisk
+    {
+        double value = 0;
+        double delta = 0;
+        double gamma = 0;
+        std::size_t repriced = 0;   // Options repriced in full by the tick (0 for the delta-gamma expansion)
+    };
+    
+    class TickRepricer
+    {
+    private:
+        // Options of one underlying
+        struct Underlying
+        {
+            std::string name;
+            double S = 0;           // Current spot
+            double reference = 0;   // Spot of the last full repricing
+            
+            // Terms that do not depend on the spot (see Simd::SpotColumns) and quantities
+            std::vector<double> K, drift, vol, dfr, dfb, w, quantity;
+            
+            // Price, delta and gamma of each option and totals at the reference spot
+            std::vector<double> price, delta, gamma;
+            TickRisk total;
+        };
+        
+        RepricerConfig config;
+        std::vector<Underlying> underlyings;
+        std::unordered_map<std::string, std::size_t> index;     // Name -> underlying
+        std::vector<std::pair<std::size_t, std::size_t>> ids;   // Option -> (underlying, row)
+        
+        // Underlying of a name
+        // Throw InvalidValueException if the name is not in the book
+        Underlying& Find(const std::string& name);
+        const Underlying& Find(const std::string& name) const;
+        
+        // Reprice every option of an underlying at its spot, which becomes the reference, and return its totals
+        TickRisk Full(Underlying& u) const;
+    
+    public:
+        ////////////////////////////////////////Constructors///////////////////////////////////////////////
+        
+        TickRepricer();
+        TickRepricer(const RepricerConfig& config);
+        
+        ///////////////////////////////////////Getter and Modifier/////////////////////////////////////////
+        
+        // Get the settings
+        const RepricerConfig& get_config() const;
+        
+        // Set the settings
+        // Throw InvalidValueException if the threshold is negative
+        void set_config(const RepricerConfig& config);
+        
+        // Number of options and of underlyings
+        std::size_t size() const;
+        std::size_t Underlyings() const;
+        
+        // Current spot of an underlying
+        // Throw InvalidValueException if the name is not in the book
+        double get_S(const std::string& underlying) const;
+        
+        /////////////////////////////////////////Book///////////////////////////////////////////////////////
+        
+        // Add quantity options of data on the underlying data.name and return the id of the position
+        // The first option of an underlying sets its spot to data.S; the next ones are priced at the current
+        // spot of the underlying and data.S is ignored
+        // Throw InvalidValueException if T, K, sig or S is not positive or r or b is negative, and
+        // InvalidOptionTypeException if the type is not C or P
+        std::size_t Add(const struct OptionData& data, const double& quantity = 1);
+        
+        //////////////////////////////////////////Ticks/////////////////////////////////////////////////////
+        
+        // Move the spot of an underlying and return the totals of its positions at the new spot
+        // Throw InvalidValueException if the name is not in the book or S is not positive
+        TickRisk OnTick(const std::string& underlying, const double& S);
+        
+        // Reprice every option of an underlying in full at its current spot
+        // Throw InvalidValueException if the name is not in the book
+        TickRisk Reprice(const std::string& underlying);
+        
+        //////////////////////////////////////Price Getters/////////////////////////////////////////////////
+        
+        // Totals of the positions of an underlying at its current spot
+        // Throw InvalidValueException if the name is not in the book
+        TickRisk Risk(const std::string& underlying) const;
+        
+        // Price, delta and gamma of one option at the current spot of its underlying (the other outputs are 0),
+        // expanded from the last full repricing if the underlying has moved since
+        // Throw InvalidValueException if id is not a position
+        OptionGreeks Greeks(const std::size_t& id) const;
+    };
+}
+
+#endif
@@ -8,15 +8,55 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
 #include "Exception.hpp"
 #include "EuropeanOption.hpp"
 #include "PerpetualAmericanOption.hpp"
+#include "AmericanOption.hpp"
+#include "FiniteDifference.hpp"
+#include "Lattice.hpp"
+#include "Chebyshev.hpp"
+#include "Fourier.hpp"
+#include "MonteCarlo.hpp"
+#include "PathMonteCarlo.hpp"
 #include "OptionMatrix.hpp"
+#include "OptionChain.hpp"
+#include "TickRepricer.hpp"
+#include "Portfolio.hpp"
+#include "ImpliedVolatility.hpp"
 
 using namespace std;
 using namespace All_Options;
 using European::EuropeanOption;
 using PerpetualAmerican::PerpetualAmericanOption;
+
+// Number of calls to operator new, counted to check that the caller-buffer overloads do not allocate
+static atomic<size_t> Allocations(0);
+
+void* operator new(size_t size)
+{
+    Allocations++;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
 int main()
 {
     
@@ -82,6 +122,11 @@ int main()
     Ame1.toggle();
     // Print the call price
     cout << "Call Price: " << Ame1.Price() << "\n" << endl;
+    
+    // Print the sensitivities, computed in one pass
+    OptionGreeks AmeGreeks = Ame1.Greeks();
+    cout << "Delta: " << AmeGreeks.delta << ", Gamma: " << AmeGreeks.gamma
+         << ", Vega: " << AmeGreeks.vega << ", Rho: " << AmeGreeks.rho << "\n" << endl;
 
     
     
@@ -95,5 +140,389 @@ int main()
         cout << Ameprice[i] << endl;
     }
     cout << "\n";
+    
+    
+    
+    cout << "//////////////////Testing Parallel Batch Pricing/////////////////.\n" << endl;
+    
+    // Create a batch of 10^6 options by varying S
+    OptionBatch book(Batch1, "S", 50, 150, 0.0001);
+    
+    // Price the batch with 1 to N threads and report the speedup over 1 thread
+    double serial = 0;
+    for (size_t threads = 1; threads <= ThreadPool::Shared().size(); threads++)
+    {
+        ParallelConfig config;
+        config.threads = threads;
+        
+        auto start = chrono::steady_clock::now();
+        vector<double> book_price = European::ParallelMatrixPricer(book, config);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1) serial = seconds;
+        
+        cout << threads << " thread(s): " << seconds << " s, speedup " << serial / seconds << endl;
+    }
+    cout << "\n";
+    
+    cout << "//////////////////Testing Normal Distribution Modes/////////////////.\n" << endl;
+    
+    // Accuracy and speed of each mode against the exact (boost) prices of the batch
+    vector<double> exact_price = European::MatrixPricer(book, EXACT);
+    NormalMode modes[3] = { EXACT, HIGH_ACCURACY, FAST };
+    for (int m = 0; m < 3; m++)
+    {
+        // Largest error of the normal CDF on [-10, 10]
+        double cdf_error = 0;
+        for (double x = -10; x <= 10; x += 0.001)
+            cdf_error = max(cdf_error, abs(NormalCdf(x, modes[m]) - NormalCdf(x, EXACT)));
+        
+        auto start = chrono::steady_clock::now();
+        vector<double> book_price = European::MatrixPricer(book, modes[m]);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        double price_error = 0;
+        for (size_t i = 0; i < book.size(); i++)
+            price_error = max(price_error, abs(book_price[i] - exact_price[i]));
+        
+        cout << NormalModeName(modes[m]) << ": CDF error " << cdf_error << ", price error " << price_error
+             << ", " << seconds << " s for " << book.size() << " options" << endl;
+    }
+    cout << "\n";
+    
+    cout << "//////////////////Testing Implied Volatility/////////////////.\n" << endl;
+    
+    // Recover the volatility of every option of the batch from its exact price
+    auto iv_start = chrono::steady_clock::now();
+    ImpliedVolResult iv = European::ParallelMatrixImpliedVol(book, exact_price);
+    double iv_seconds = chrono::duration<double>(chrono::steady_clock::now() - iv_start).count();
+    
+    size_t converged = 0;
+    double iv_error = 0;
+    for (size_t i = 0; i < book.size(); i++)
+    {
+        if (iv.status[i] != IV_CONVERGED) continue;
+        converged++;
+        iv_error = max(iv_error, abs(iv.sig[i] - book.sig()[i]));
+    }
+    cout << converged << " of " << book.size() << " converged in " << iv_seconds << " s, largest sig error " << iv_error << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Checked Batch/////////////////.\n" << endl;
+    
+    // Spoil some rows; the checked pricer prices the others and reports the bad ones
+    OptionBatch feed(book);
+    for (size_t i = 0; i < feed.size(); i += 1000)
+        feed.K()[i] = -1;
+    CheckedGreeks checked = European::CheckedMatrixGreeks(feed, PRICE);
+    cout << checked.invalid << " invalid rows, first price " << checked.greeks.price[0]
+         << ", second price " << checked.greeks.price[1] << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Allocation-Free Pricing/////////////////.\n" << endl;
+    
+    // Buffers sized in advance with SweepSize and batch.size()
+    OptionBatch perpetual_book(Amebatch1, "S", 50, 150, 0.01);
+    size_t points = SweepSize(50, 150, 0.01);
+    vector<double> sweep_price(points), sweep_delta(points), sweep_gamma(points), sweep_vega(points);
+    vector<double> book_price(book.size()), book_delta(book.size()), book_gamma(book.size()), book_vega(book.size());
+    vector<double> perpetual_price(perpetual_book.size());
+    Simd::KernelOutput sweep_out, book_out;
+    sweep_out.price = sweep_price.data(); sweep_out.delta = sweep_delta.data();
+    sweep_out.gamma = sweep_gamma.data(); sweep_out.vega = sweep_vega.data();
+    book_out.price = book_price.data(); book_out.delta = book_delta.data();
+    book_out.gamma = book_gamma.data(); book_out.vega = book_vega.data();
+    
+    // A short spot ladder for the finite-maturity pricers
+    size_t ladder = SweepSize(80, 120, 10);
+    vector<double> ladder_price(ladder);
+    OptionBatch ladder_book(Batch1, "S", 80, 120, 10);
+    American::AmericanOption am_buffer(Batch1);
+    FiniteDifference::FiniteDifferenceOption fd_buffer(Batch1);
+    Lattice::LatticeOption tree_buffer(Batch1);
+    MonteCarlo::MonteCarloConfig path_buffer_config;
+    path_buffer_config.paths = 4096;
+    MonteCarlo::PathDependentOption path_buffer(Batch1, MonteCarlo::PathPayoff(), path_buffer_config);
+    
+    // Every caller-buffer overload, on the sweeps of the options and on the batches
+    auto buffered = [&]()
+    {
+        euro.Price(Factor::S, 50, 150, 0.01, sweep_price.data(), points);
+        euro.Delta(Factor::S, 50, 150, 0.01, sweep_delta.data(), points);
+        euro.Gamma(Factor::S, 50, 150, 0.01, sweep_gamma.data(), points);
+        euro.Greeks(Factor::S, 50, 150, 0.01, sweep_out, points);
+        European::SweepPricer(Batch1, Factor::S, 50, 150, 0.01, sweep_price.data(), points);
+        European::SweepDelta(Batch1, Factor::S, 50, 150, 0.01, sweep_delta.data(), points);
+        European::SweepGamma(Batch1, Factor::S, 50, 150, 0.01, sweep_gamma.data(), points);
+        European::SweepGreeks(Batch1, Factor::S, 50, 150, 0.01, sweep_out, points);
+        European::MatrixPricer(book, book_price.data(), book.size());
+        European::MatrixDelta(book, book_delta.data(), book.size());
+        European::MatrixGamma(book, book_gamma.data(), book.size());
+        European::MatrixGreeks(book, book_out, book.size());
+        European::ParallelMatrixPricer(book, book_price.data(), book.size());
+        European::ParallelMatrixGreeks(book, book_out, book.size());
+        Ame1.Price(Factor::S, 50, 150, 0.01, sweep_price.data(), points);
+        Ame1.Greeks(Factor::S, 50, 150, 0.01, sweep_out, points);
+        PerpetualAmerican::MatrixPricer(perpetual_book, perpetual_price.data(), perpetual_book.size());
+        PerpetualAmerican::ParallelMatrixPricer(perpetual_book, perpetual_price.data(), perpetual_book.size());
+        PerpetualAmerican::MatrixGreeks(perpetual_book, sweep_out, perpetual_book.size());
+        PerpetualAmerican::ParallelMatrixGreeks(perpetual_book, sweep_out, perpetual_book.size());
+        am_buffer.Price(Factor::S, 80, 120, 10, ladder_price.data(), ladder);
+        American::MatrixPricer(ladder_book, ladder_price.data(), ladder);
+        American::ParallelMatrixPricer(ladder_book, ladder_price.data(), ladder);
+        fd_buffer.Price(Factor::S, 80, 120, 10, ladder_price.data(), ladder);
+        fd_buffer.Price(Factor::K, 80, 120, 10, ladder_price.data(), ladder);
+        tree_buffer.Price(Factor::S, 80, 120, 10, ladder_price.data(), ladder);
+        Lattice::MatrixPricer(ladder_book, ladder_price.data(), ladder);
+        Lattice::ParallelMatrixPricer(ladder_book, ladder_price.data(), ladder);
+        path_buffer.Price(Factor::S, 80, 120, 10, ladder_price.data(), ladder);
+    };
+    
+    // The first round starts the pool and the per-thread buffers; the next ones must not allocate
+    buffered();
+    size_t allocations_before = Allocations;
+    for (int round = 0; round < 3; round++)
+        buffered();
+    size_t allocations = Allocations - allocations_before;
+    cout << allocations << " allocations in 3 rounds of the caller-buffer overloads" << endl;
+    assert(allocations == 0);
+    cout << "\n";
+    
+    cout << "//////////////////Testing American Approximations/////////////////.\n" << endl;
+    
+    // A finite-maturity American put, priced by both approximations
+    OptionData Ambatch;
+    Ambatch.T = 0.5; Ambatch.K = 100; Ambatch.sig = 0.25; Ambatch.r = 0.08; Ambatch.b = 0.08; Ambatch.S = 95; Ambatch.optType = 'P';
+    American::AmericanOption Am(Ambatch, American::BARONE_ADESI_WHALEY);
+    cout << American::MethodName(Am.get_method()) << " put: " << Am.Price() << endl;
+    Am.set_method(American::BJERKSUND_STENSLAND);
+    cout << American::MethodName(Am.get_method()) << " put: " << Am.Price() << endl;
+    
+    // Without volatility both approximations give the best exercise value along the sure path, as the tree does
+    OptionData flat = Ambatch;
+    flat.sig = 0;
+    OptionBatch flat_book(flat, "S", 80, 120, 10);
+    for (int m = 0; m < 2; m++)
+    {
+        American::AmericanMethod method = static_cast<American::AmericanMethod>(m);
+        vector<double> flat_prices = American::MatrixPricer(flat_book, method);
+        for (size_t i = 0; i < flat_book.size(); i++)
+            assert(flat_prices[i] == Lattice::LatticeOption::DegeneratePrice(flat.T, flat.K, flat.r, flat.b, flat_book.S()[i],
+                                                                             false, AMERICAN_EXERCISE));
+        cout << American::MethodName(method) << " put with sig = 0: " << American::AmericanOption(flat, method).Price() << endl;
+    }
+    
+    // The whole book as American options; the boundary is solved once per (T, sig, r, b, type) group
+    auto am_start = chrono::steady_clock::now();
+    vector<double> am_prices = American::MatrixPricer(book, American::BARONE_ADESI_WHALEY);
+    double am_seconds = chrono::duration<double>(chrono::steady_clock::now() - am_start).count();
+    cout << am_prices.size() << " American prices in " << am_seconds << " s" << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Finite Difference/////////////////.\n" << endl;
+    
+    // The same put on a Crank-Nicolson grid; a spot ladder and its delta and gamma come from one solve
+    FiniteDifference::FiniteDifferenceOption Fd(Ambatch);
+    OptionGreeks FdGreeks = Fd.Greeks();
+    cout << "Finite difference put: " << FdGreeks.price << ", delta " << FdGreeks.delta << ", gamma " << FdGreeks.gamma << endl;
+    BatchGreeks fd_ladder = Fd.Greeks(80, 120, 10);
+    for (size_t i = 0; i < fd_ladder.price.size(); i++)
+        cout << "S = " << 80 + 10 * i << ": " << fd_ladder.price[i] << ", delta " << fd_ladder.delta[i] << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Lattice/////////////////.\n" << endl;
+    
+    // The same put on binomial and trinomial trees with BBS smoothing and Richardson extrapolation
+    Lattice::LatticeOption Tree(Ambatch);
+    cout << Tree.ToString() << "\nprice: " << Tree.Price() << endl;
+    Lattice::LatticeConfig tri;
+    tri.type = Lattice::TRINOMIAL;
+    Tree.set_config(tri);
+    cout << "trinomial price: " << Tree.Price() << endl;
+    
+    // A spot ladder of the put as a batch, priced in lockstep by the lattice kernel
+    OptionBatch tree_book(Ambatch, "S", 50, 150, 0.1);
+    auto tree_start = chrono::steady_clock::now();
+    vector<double> tree_prices = Lattice::MatrixPricer(tree_book);
+    double tree_seconds = chrono::duration<double>(chrono::steady_clock::now() - tree_start).count();
+    cout << tree_prices.size() << " tree prices in " << tree_seconds << " s" << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Monte Carlo/////////////////.\n" << endl;
+    
+    // A European call by simulation against its closed-form price, with each random source
+    OptionData Mcdata = Ambatch;
+    Mcdata.optType = 'C';
+    cout << "closed form: " << European::EuropeanOption(Mcdata).Price() << endl;
+    MonteCarlo::MonteCarloConfig mc_config;
+    for (int source = MonteCarlo::PSEUDO_RANDOM; source <= MonteCarlo::SOBOL; source++)
+    {
+        mc_config.source = static_cast<MonteCarlo::RandomSource>(source);
+        MonteCarlo::MonteCarloEngine Mc(mc_config);
+        auto mc_start = chrono::steady_clock::now();
+        MonteCarlo::MonteCarloResult mc = Mc.Price(Mcdata);
+        double mc_seconds = chrono::duration<double>(chrono::steady_clock::now() - mc_start).count();
+        cout << ((source == MonteCarlo::SOBOL)? "Sobol: " : "Philox: ") << mc.price << " +/- " << mc.standard_error
+             << " (" << mc.paths << " paths in " << mc_seconds << " s)" << endl;
+    }
+    cout << "\n";
+    
+    cout << "//////////////////Testing Path Monte Carlo/////////////////.\n" << endl;
+    
+    // Asian options on 12 monthly fixings: the geometric one against its closed form, the arithmetic one
+    // with the geometric one as control variate
+    MonteCarlo::MonteCarloConfig path_config;
+    path_config.source = MonteCarlo::SOBOL;
+    path_config.control = MonteCarlo::GEOMETRIC_ASIAN_CONTROL;
+    cout << "geometric closed form: " << MonteCarlo::PathDependentOption::GeometricAsianPrice(Mcdata.T, Mcdata.K, Mcdata.sig,
+            Mcdata.r, Mcdata.b, Mcdata.S, path_config.steps, true) << endl;
+    MonteCarlo::PathPayoff asian;
+    MonteCarlo::PathDependentOption Asian(Mcdata, asian, path_config);
+    MonteCarlo::MonteCarloResult asian_mc = Asian.Simulate();
+    cout << Asian << "\n" << asian_mc.price << " +/- " << asian_mc.standard_error << " (beta " << asian_mc.beta << ")" << endl;
+    
+    // Knock-out and knock-in barriers add up to the European option
+    MonteCarlo::PathPayoff knock_out;
+    knock_out.type = MonteCarlo::BARRIER;
+    knock_out.barrier = MonteCarlo::DOWN_AND_OUT;
+    knock_out.level = 85;
+    MonteCarlo::PathPayoff knock_in = knock_out;
+    knock_in.barrier = MonteCarlo::DOWN_AND_IN;
+    path_config.control = MonteCarlo::EUROPEAN_CONTROL;
+    double out_price = MonteCarlo::PathDependentOption(Mcdata, knock_out, path_config).Price();
+    double in_price = MonteCarlo::PathDependentOption(Mcdata, knock_in, path_config).Price();
+    cout << "down-and-out: " << out_price << ", down-and-in: " << in_price << ", sum: " << out_price + in_price << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Chebyshev Proxy/////////////////.\n" << endl;
+    
+    // Proxy of an American put priced by a tree over S x sig x T, served from the proxy while inside the box
+    Lattice::LatticeOption proxy_tree(Ambatch, AMERICAN_EXERCISE);
+    vector<Chebyshev::ChebyshevAxis> proxy_box;
+    proxy_box.push_back(Chebyshev::ChebyshevAxis("S", 80, 120, 12));
+    proxy_box.push_back(Chebyshev::ChebyshevAxis("sig", 0.15, 0.35, 8));
+    proxy_box.push_back(Chebyshev::ChebyshevAxis("T", 0.25, 1, 8));
+    Chebyshev::ChebyshevProxy proxy(proxy_tree, proxy_box);
+    cout << proxy << "measured error: " << proxy.Verify(proxy_tree) << endl;
+    cout << "tree: " << proxy_tree.Price() << ", proxy: " << proxy.Price(Ambatch) << endl;
+    OptionData proxy_move = Ambatch;
+    proxy_move.S = 130;
+    cout << "S 130 in the box: " << proxy.Contains(proxy_move) << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Fourier Engine/////////////////.\n" << endl;
+    
+    // A strike chain from GenerateMatrix in one pass, under Black-Scholes against the closed form, then under Heston
+    OptionData chain_data = Ambatch;
+    vector<vector<double>> chain = GenerateMatrix(chain_data, "K", 50, 150, 0.1);
+    vector<double> chain_exact = EuropeanOption(chain_data).Price("K", 50, 150, 0.1);
+    for (int method = Fourier::CARR_MADAN; method <= Fourier::COS; method++)
+    {
+        Fourier::FourierConfig fourier_config;
+        fourier_config.method = static_cast<Fourier::FourierMethod>(method);
+        Fourier::FourierEngine fourier(Fourier::BLACK_SCHOLES, Fourier::HestonParameters(), fourier_config);
+        auto fourier_start = chrono::steady_clock::now();
+        vector<double> chain_prices = fourier.Price(chain, chain_data.optType);
+        double fourier_seconds = chrono::duration<double>(chrono::steady_clock::now() - fourier_start).count();
+        double chain_error = 0;
+        for (size_t i = 0; i < chain_prices.size(); i++)
+            chain_error = max(chain_error, fabs(chain_prices[i] - chain_exact[i]));
+        cout << ((method == Fourier::COS)? "COS: " : "Carr-Madan: ") << chain_prices.size() << " strikes in "
+             << fourier_seconds << " s, largest error " << chain_error << endl;
+    }
+    Fourier::FourierEngine heston(Fourier::HESTON);
+    vector<double> heston_prices = heston.Price(chain, chain_data.optType);
+    cout << "Heston put at K = 100: " << heston_prices[500] << " (Black-Scholes " << chain_exact[500] << ")" << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Option Chain/////////////////.\n" << endl;
+    
+    // The strikes of GenerateMatrix in a chain sharing the terms of S and T, against the option by option prices
+    OptionChain option_chain(chain_data, vector<double>());
+    for (size_t i = 0; i < chain.size(); i++)
+        option_chain.Add(chain[i][1], chain[i][2], chain_data.optType);
+    auto option_chain_start = chrono::steady_clock::now();
+    BatchGreeks option_chain_greeks = option_chain.Greeks();
+    double option_chain_seconds = chrono::duration<double>(chrono::steady_clock::now() - option_chain_start).count();
+    double option_chain_error = 0;
+    for (size_t i = 0; i < option_chain.size(); i++)
+        option_chain_error = max(option_chain_error, fabs(option_chain_greeks.price[i] - chain_exact[i]));
+    cout << option_chain << "\n" << option_chain.size() << " strikes with Greeks in " << option_chain_seconds
+         << " s, largest error " << option_chain_error << endl;
+    
+    // Move the spot and one volatility in place
+    option_chain.set_S(100);
+    option_chain.set_sig(500, 0.3);
+    EuropeanOption option_chain_atm(option_chain.get_data(500));
+    cout << "K = 100 after the move: " << option_chain.Price()[500] << " (" << option_chain_atm.Price() << ")" << endl;
+    
+    // Types are stored uppercase, like the type of an option
+    option_chain.Add(100, 0.3, 'p');
+    assert(option_chain.type()[option_chain.size() - 1] == 'P');
+    cout << "\n";
+    
+    cout << "//////////////////Testing Tick Repricer/////////////////.\n" << endl;
+    
+    // A book of the strikes of the chain on two underlyings, ticked in full and then by the delta-gamma expansion
+    RepricerConfig tick_config;
+    tick_config.threshold = 0.002;
+    TickRepricer tick_book(tick_config);
+    OptionData tick_data = chain_data;
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        tick_data.K = chain[i][1];
+        tick_data.name = (i % 2 == 0)? "ABC" : "XYZ";
+        tick_book.Add(tick_data, (i % 3 == 0)? -1 : 1);
+    }
+    TickRisk tick_full = tick_book.OnTick("ABC", 96);
+    TickRisk tick_fast = tick_book.OnTick("ABC", 96.1);
+    cout << tick_book.Underlyings() << " underlyings, " << tick_book.size() << " options" << endl;
+    cout << "ABC to 96: value " << tick_full.value << ", delta " << tick_full.delta << " (" << tick_full.repriced
+         << " options repriced)" << endl;
+    cout << "ABC to 96.1: value " << tick_fast.value << ", delta " << tick_fast.delta << " (expanded), in full "
+         << tick_book.Reprice("ABC").value << endl;
+    cout << "XYZ unchanged at " << tick_book.get_S("XYZ") << ": value " << tick_book.Risk("XYZ").value << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Cached European Option/////////////////.\n" << endl;
+    
+    // The first call computes d1, d2, the normal terms and every output, the next ones read them
+    EuropeanOption cached_option(Ambatch);
+    cached_option.set_caching(true);
+    cout << "price " << cached_option.Price() << ", delta " << cached_option.Delta() << ", gamma " << cached_option.Gamma() << endl;
+    
+    // toggle() keeps the terms shared by calls and puts, set_data() empties the cache
+    cached_option.toggle();
+    cout << "toggled: price " << cached_option.Price() << " (parity "
+         << cached_option.Put_Call_Parity(EuropeanOption(Ambatch).Price(), Ambatch.optType) << ")" << endl;
+    OptionData cached_data = cached_option.get_data();
+    cached_data.S = 100;
+    cached_option.set_data(cached_data);
+    cout << "S = 100: price " << cached_option.Price() << " (" << EuropeanOption(cached_data).Price() << ")" << endl;
+    cout << "\n";
+    
+    cout << "//////////////////Testing Portfolio/////////////////.\n" << endl;
+    
+    // European and perpetual American positions on the strikes of the chain, over ten underlyings
+    Portfolio portfolio;
+    OptionData position_data = chain_data;
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        position_data.K = chain[i][1];
+        position_data.name = "U" + to_string(i % 10);
+        if (i % 4 == 0)
+            portfolio.Add(PerpetualAmericanOption(position_data), -1);
+        else
+            portfolio.Add(EuropeanOption(position_data), 2);
+    }
+    size_t portfolio_buckets = portfolio.ParallelAggregate();
+    cout << portfolio << "\n(" << portfolio_buckets << " buckets evaluated)" << endl;
+    
+    // Moving one underlying only evaluates its buckets again
+    PortfolioRisk portfolio_before = portfolio.Risk("U3");
+    portfolio.set_S("U3", 100);
+    portfolio_buckets = portfolio.Aggregate();
+    cout << "U3 to 100: delta " << portfolio_before.delta << " -> " << portfolio.Risk("U3").delta << " ("
+         << portfolio_buckets << " buckets evaluated), total price " << portfolio.Total().price << endl;
+    cout << "\n";
 
 }